@@ -0,0 +1,894 @@
+/*
+  ==============================================================================
+
+	am_AdditiveEngine.h
+	Created: 18 Oct 2026 12:41:19am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//how an AdditiveEngine turns its partials into sound
+enum class AdditiveMode
+{
+	rotation = 0,		//each partial is a complex number turned by one complex multiply per sample. Cost grows with the partials.
+	inverseFft,			//the partials are drawn into a spectrum every hop and turned into sound with an inverse FFT.
+						//Cost is mostly the FFT, so it barely grows with the partials, but frequencies only change once a hop.
+	automatic			//inverseFft from getFftThreshold() audible partials up, rotation below. Chosen by setUp(), setMode() and
+						//setInstructionSet(), so frequency and amplitude changes never switch (and restart) the output.
+};
+
+/**
+*An additive synth for hundreds or thousands of sine partials, like Chord's harmonic stacking without an Oscillator
+*per note.
+*
+*Partial i plays at baseFrequency * ratio (i + 1 unless set with setPartialRatio()) with an amplitude that starts at
+*Chord's 1 / (i + 1) weighting, scaled so the amplitudes add up to 1. Partials at or above Nyquist, and silent ones,
+*are culled and cost nothing; they come back as soon as they are under Nyquist again.
+*
+*In rotation mode the partials are stored as structure-of-arrays and 4, 8 or 16 of them are turned per SSE2, AVX2 or
+*AVX-512 instruction (chosen at runtime, see am_Simd). The output is very close to, not bit-identical with, the
+*scalar path. In inverseFft mode each partial adds a few bins of a Blackman-Harris spectrum every 256 samples, and
+*the frames are overlap-added with a triangular window (Rodet and Depalle's FFT-1 method).
+*
+*setUp() allocates. The other setters do not, and the partials are re-culled at the start of the next block.
+*/
+class AdditiveEngine
+{
+public:
+	static constexpr int fftSize = 1024;
+	static constexpr int hopSize = fftSize / 4;
+
+	AdditiveEngine()
+	{
+		setInstructionSet(detectInstructionSet());
+	}
+
+	/**
+	*sets up the engine. Allocates, so call it outside the audio callback.
+	*@param sample rate in Hz
+	*@param base frequency in Hz (the first partial)
+	*@param number of partials
+	*/
+	void setUp(float _sampleRate, float _baseFrequency, int _numPartials)
+	{
+		numPartials = std::max(_numPartials, 0);
+		const int padded = paddedSize(numPartials);
+
+		ratio.assign(padded, 0.0f);
+		amplitude.assign(padded, 0.0f);
+		stateRe.assign(padded, 1.0f);
+		stateIm.assign(padded, 0.0f);
+
+		double harmonicSum = 0.0;
+		for (int i = 0; i < numPartials; i++)
+		{
+			harmonicSum += 1.0 / double(i + 1);
+		}
+		for (int i = 0; i < numPartials; i++)
+		{
+			ratio[i] = float(i + 1);
+			amplitude[i] = float(1.0 / (double(i + 1) * harmonicSum));
+		}
+
+		activeIndex.assign(padded, 0);
+		re.assign(padded, 0.0f);
+		im.assign(padded, 0.0f);
+		stepCos.assign(padded, 1.0f);
+		stepSin.assign(padded, 0.0f);
+		gain.assign(padded, 0.0f);
+		bin.assign(padded, 0.0f);
+
+		if (fftRe.empty())
+		{
+			fftRe.assign(spectrumSize, 0.0f);
+			fftIm.assign(spectrumSize, 0.0f);
+			halfRe.assign(fftSize / 2, 0.0f);
+			halfIm.assign(fftSize / 2, 0.0f);
+			buildFftTables();
+		}
+
+		sampleRate = _sampleRate;
+		baseFrequency = _baseFrequency;
+		numActive = 0;
+		needsUpdate = true;
+		needsModeChoice = true;
+		reset();
+	}
+
+	//set the sample rate in Hz. Frequencies and amplitudes are kept.
+	void setSampleRate(float _sampleRate)
+	{
+		sampleRate = _sampleRate;
+		needsUpdate = true;
+	}
+
+	//set the frequency of the first partial in Hz; the rest follow by their ratios
+	void setFrequency(float _baseFrequency)
+	{
+		baseFrequency = _baseFrequency;
+		needsUpdate = true;
+	}
+
+	float getFrequency() const
+	{
+		return baseFrequency;
+	}
+
+	//set the amplitude of one partial
+	void setPartialAmplitude(int index, float _amplitude)
+	{
+		amplitude[index] = _amplitude;
+		needsUpdate = true;
+	}
+
+	//set the frequency of one partial as a multiple of the base frequency (i + 1 for harmonic partials)
+	void setPartialRatio(int index, float _ratio)
+	{
+		ratio[index] = _ratio;
+		needsUpdate = true;
+	}
+
+	int getNumPartials() const
+	{
+		return numPartials;
+	}
+
+	//partials that are under Nyquist and not silent, i.e. the ones that cost anything
+	int getNumAudiblePartials()
+	{
+		updatePartials();
+		return numActive;
+	}
+
+	/**
+	*choose how the partials are rendered. Changing it restarts the output (the partials keep their phases).
+	*@param rotation, inverseFft or automatic
+	*/
+	void setMode(AdditiveMode _mode)
+	{
+		mode = _mode;
+		needsUpdate = true;											//the rotations are per sample in one mode and per hop in the other
+		needsModeChoice = true;
+		reset();
+	}
+
+	//the mode actually used, i.e. what automatic has chosen for the partials left after culling
+	AdditiveMode getMode()
+	{
+		updatePartials();
+		return usingFft ? AdditiveMode::inverseFft : AdditiveMode::rotation;
+	}
+
+	/**
+	*the number of partials from which AdditiveMode::automatic uses the inverse FFT. The FFT costs about the same
+	*everywhere but the rotations get cheaper with wider vectors, so the crossover moves up with the instruction set
+	*(measured on one AVX-512 machine at 48kHz).
+	*/
+	int getFftThreshold() const
+	{
+		switch (instructionSet)
+		{
+			case InstructionSet::avx512:	return 896;
+			case InstructionSet::avx2:		return 256;
+			default:						return 96;
+		}
+	}
+
+	/**
+	*choose which instruction set renders rotation mode. Anything the machine cannot run is lowered to the best it can.
+	*@param instruction set to use
+	*/
+	void setInstructionSet(InstructionSet requested)
+	{
+		static const InstructionSet supported = detectInstructionSet();
+		instructionSet = std::min(requested, supported);
+		needsUpdate = true;
+		needsModeChoice = true;										//automatic may now pick the other mode
+	}
+
+	//clears the inverse FFT overlap, so the output starts again from the next sample
+	void reset()
+	{
+		std::fill(overlap, overlap + hopSize, 0.0f);
+		std::fill(ready, ready + hopSize, 0.0f);
+		readyPosition = hopSize;
+	}
+
+
+	//Output Functions
+
+	float process()
+	{
+		float out;
+		processBlock(&out, 1);
+		return out;
+	}
+
+	/**
+	*fills a buffer with the partials, overwriting what is already there
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		render(out, numSamples, false);
+	}
+
+	/**
+	*adds the partials on top of what is already in the buffer
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		render(out, numSamples, true);
+	}
+
+private:
+	static constexpr int maxLanes = 16;							//widest vector (AVX-512)
+	static constexpr int groupSize = 2 * maxLanes;				//two vectors are turned side by side, so their multiplies overlap
+	static constexpr int scratchSize = 64;						//samples rendered per pass over the partials in rotation mode
+	static constexpr int kernelRadius = 4;						//bins either side of a partial in the Blackman-Harris spectrum
+	static constexpr int kernelSteps = 64;						//kernel table entries per bin
+	static constexpr int spectrumSize = fftSize / 2 + 2 * kernelRadius + 1;	//bins -kernelRadius to fftSize / 2 + kernelRadius
+
+	static int paddedSize(int count)
+	{
+		return ((count + groupSize - 1) / groupSize) * groupSize;
+	}
+
+	//culls the partials and works out the per-sample and per-hop rotations of the ones left
+	void updatePartials()
+	{
+		if (!needsUpdate)
+		{
+			return;
+		}
+		needsUpdate = false;
+
+		//the culled partials keep their phase for when they come back
+		for (int a = 0; a < numActive; a++)
+		{
+			stateRe[activeIndex[a]] = re[a];
+			stateIm[activeIndex[a]] = im[a];
+		}
+
+		//automatic decides on the partials that will be rendered, so they are counted before the rotations are worked out
+		if (needsModeChoice)
+		{
+			needsModeChoice = false;
+
+			int numAudible = 0;
+			for (int i = 0; i < numPartials; i++)
+			{
+				numAudible += getAudibleFrequency(i) > 0.0 ? 1 : 0;
+			}
+
+			const bool fft = mode == AdditiveMode::inverseFft || (mode == AdditiveMode::automatic && numAudible >= getFftThreshold());
+			if (fft != usingFft)
+			{
+				usingFft = fft;
+				reset();											//as setMode() does
+			}
+		}
+
+		const bool fft = usingFft;
+
+		const double twoPi = 6.283185307179586;
+		numActive = 0;
+
+		for (int i = 0; i < numPartials; i++)
+		{
+			const double frequency = getAudibleFrequency(i);
+
+			if (frequency <= 0.0)
+			{
+				continue;
+			}
+
+			const double step = twoPi * frequency / double(sampleRate) * (fft ? double(hopSize) : 1.0);
+			const int a = numActive++;
+			activeIndex[a] = i;
+			re[a] = stateRe[i];
+			im[a] = stateIm[i];
+			stepCos[a] = float(std::cos(step));
+			stepSin[a] = float(std::sin(step));
+			gain[a] = amplitude[i];
+			bin[a] = float(frequency * double(fftSize) / double(sampleRate));
+		}
+
+		//the padding is silent and does not turn
+		for (int a = numActive; a < paddedSize(numActive); a++)
+		{
+			re[a] = 1.0f;
+			im[a] = 0.0f;
+			stepCos[a] = 1.0f;
+			stepSin[a] = 0.0f;
+			gain[a] = 0.0f;
+		}
+	}
+
+	//the frequency of a partial in Hz, or 0 if it is culled (silent, or not under Nyquist)
+	double getAudibleFrequency(int index) const
+	{
+		const double frequency = double(baseFrequency) * double(ratio[index]);
+		return amplitude[index] != 0.0f && frequency > 0.0 && frequency < 0.5 * double(sampleRate) ? frequency : 0.0;
+	}
+
+	void render(float* out, int numSamples, bool add)
+	{
+		updatePartials();
+
+		if (usingFft)
+		{
+			renderFromFrames(out, numSamples, add);
+			return;
+		}
+
+		for (int start = 0; start < numSamples;)
+		{
+			//the partials are put back on the unit circle every scratchSize samples, however the blocks are cut
+			const int chunk = std::min(scratchSize - samplesSinceNormalise, numSamples - start);
+			samplesSinceNormalise += chunk;
+			const bool normalise = samplesSinceNormalise == scratchSize;
+			samplesSinceNormalise = normalise ? 0 : samplesSinceNormalise;
+
+			if (numActive == 0)
+			{
+				if (!add)
+				{
+					std::fill(out + start, out + start + chunk, 0.0f);
+				}
+			}
+			else
+			{
+				switch (instructionSet)
+				{
+#if AM_SIMD_X86
+					case InstructionSet::avx512: rotateAvx512(out + start, chunk, add, normalise); break;
+					case InstructionSet::avx2: rotateAvx2(out + start, chunk, add, normalise); break;
+					case InstructionSet::sse2: rotateSse2(out + start, chunk, add, normalise); break;
+#endif
+					default: rotateScalar(out + start, chunk, add, normalise); break;
+				}
+			}
+			start += chunk;
+		}
+	}
+
+	//pulls a rotating partial back onto the unit circle, which float rounding slowly moves it off (one Newton step)
+	static void toUnitCircle(float& x, float& y)
+	{
+		const float correction = 1.5f - 0.5f * (x * x + y * y);
+		x *= correction;
+		y *= correction;
+	}
+
+	//reference version, also used on non-x86 machines
+	void rotateScalar(float* out, int numSamples, bool add, bool normalise)
+	{
+		float sums[scratchSize] = {};
+
+		for (int a = 0; a < numActive; a++)
+		{
+			float x = re[a];
+			float y = im[a];
+			const float c = stepCos[a];
+			const float s = stepSin[a];
+			const float g = gain[a];
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				const float turned = x * c - y * s;
+				y = x * s + y * c;
+				x = turned;
+				sums[i] += g * y;
+			}
+
+			if (normalise)
+			{
+				toUnitCircle(x, y);
+			}
+			re[a] = x;
+			im[a] = y;
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			out[i] = add ? out[i] + sums[i] : sums[i];
+		}
+	}
+
+#if AM_SIMD_X86
+
+	AM_TARGET_SSE2 void rotateSse2(float* out, int numSamples, bool add, bool normalise)
+	{
+		alignas(16) __m128 sums[scratchSize];
+		const int used = paddedSize(numActive);
+		const __m128 half = _mm_set1_ps(normalise ? 0.5f : 0.0f);			//the correction is 1.5 - 0.5 * r^2 when normalising, 1 otherwise
+		const __m128 threeHalves = _mm_set1_ps(normalise ? 1.5f : 1.0f);
+
+		for (int a = 0; a < used; a += 8)
+		{
+			__m128 x0 = _mm_loadu_ps(&re[a]);
+			__m128 y0 = _mm_loadu_ps(&im[a]);
+			__m128 x1 = _mm_loadu_ps(&re[a + 4]);
+			__m128 y1 = _mm_loadu_ps(&im[a + 4]);
+			const __m128 c0 = _mm_loadu_ps(&stepCos[a]);
+			const __m128 s0 = _mm_loadu_ps(&stepSin[a]);
+			const __m128 c1 = _mm_loadu_ps(&stepCos[a + 4]);
+			const __m128 s1 = _mm_loadu_ps(&stepSin[a + 4]);
+			const __m128 g0 = _mm_loadu_ps(&gain[a]);
+			const __m128 g1 = _mm_loadu_ps(&gain[a + 4]);
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				const __m128 turned0 = _mm_sub_ps(_mm_mul_ps(x0, c0), _mm_mul_ps(y0, s0));
+				const __m128 turned1 = _mm_sub_ps(_mm_mul_ps(x1, c1), _mm_mul_ps(y1, s1));
+				y0 = _mm_add_ps(_mm_mul_ps(x0, s0), _mm_mul_ps(y0, c0));
+				y1 = _mm_add_ps(_mm_mul_ps(x1, s1), _mm_mul_ps(y1, c1));
+				x0 = turned0;
+				x1 = turned1;
+
+				const __m128 weighted = _mm_add_ps(_mm_mul_ps(g0, y0), _mm_mul_ps(g1, y1));
+				sums[i] = a == 0 ? weighted : _mm_add_ps(sums[i], weighted);
+			}
+
+			const __m128 correction0 = _mm_sub_ps(threeHalves, _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(x0, x0), _mm_mul_ps(y0, y0))));
+			const __m128 correction1 = _mm_sub_ps(threeHalves, _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(x1, x1), _mm_mul_ps(y1, y1))));
+			_mm_storeu_ps(&re[a], _mm_mul_ps(x0, correction0));
+			_mm_storeu_ps(&im[a], _mm_mul_ps(y0, correction0));
+			_mm_storeu_ps(&re[a + 4], _mm_mul_ps(x1, correction1));
+			_mm_storeu_ps(&im[a + 4], _mm_mul_ps(y1, correction1));
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			__m128 s = _mm_add_ps(sums[i], _mm_movehl_ps(sums[i], sums[i]));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			const float total = _mm_cvtss_f32(s);
+			out[i] = add ? out[i] + total : total;
+		}
+	}
+
+	AM_TARGET_AVX2 void rotateAvx2(float* out, int numSamples, bool add, bool normalise)
+	{
+		alignas(32) __m256 sums[scratchSize];
+		const int used = paddedSize(numActive);
+		const __m256 half = _mm256_set1_ps(normalise ? 0.5f : 0.0f);			//the correction is 1.5 - 0.5 * r^2 when normalising, 1 otherwise
+		const __m256 threeHalves = _mm256_set1_ps(normalise ? 1.5f : 1.0f);
+
+		for (int a = 0; a < used; a += 16)
+		{
+			__m256 x0 = _mm256_loadu_ps(&re[a]);
+			__m256 y0 = _mm256_loadu_ps(&im[a]);
+			__m256 x1 = _mm256_loadu_ps(&re[a + 8]);
+			__m256 y1 = _mm256_loadu_ps(&im[a + 8]);
+			const __m256 c0 = _mm256_loadu_ps(&stepCos[a]);
+			const __m256 s0 = _mm256_loadu_ps(&stepSin[a]);
+			const __m256 c1 = _mm256_loadu_ps(&stepCos[a + 8]);
+			const __m256 s1 = _mm256_loadu_ps(&stepSin[a + 8]);
+			const __m256 g0 = _mm256_loadu_ps(&gain[a]);
+			const __m256 g1 = _mm256_loadu_ps(&gain[a + 8]);
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				const __m256 turned0 = _mm256_fmsub_ps(x0, c0, _mm256_mul_ps(y0, s0));
+				const __m256 turned1 = _mm256_fmsub_ps(x1, c1, _mm256_mul_ps(y1, s1));
+				y0 = _mm256_fmadd_ps(x0, s0, _mm256_mul_ps(y0, c0));
+				y1 = _mm256_fmadd_ps(x1, s1, _mm256_mul_ps(y1, c1));
+				x0 = turned0;
+				x1 = turned1;
+
+				const __m256 weighted = _mm256_fmadd_ps(g0, y0, _mm256_mul_ps(g1, y1));
+				sums[i] = a == 0 ? weighted : _mm256_add_ps(sums[i], weighted);
+			}
+
+			const __m256 correction0 = _mm256_fnmadd_ps(half, _mm256_fmadd_ps(x0, x0, _mm256_mul_ps(y0, y0)), threeHalves);
+			const __m256 correction1 = _mm256_fnmadd_ps(half, _mm256_fmadd_ps(x1, x1, _mm256_mul_ps(y1, y1)), threeHalves);
+			_mm256_storeu_ps(&re[a], _mm256_mul_ps(x0, correction0));
+			_mm256_storeu_ps(&im[a], _mm256_mul_ps(y0, correction0));
+			_mm256_storeu_ps(&re[a + 8], _mm256_mul_ps(x1, correction1));
+			_mm256_storeu_ps(&im[a + 8], _mm256_mul_ps(y1, correction1));
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(sums[i]), _mm256_extractf128_ps(sums[i], 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			const float total = _mm_cvtss_f32(s);
+			out[i] = add ? out[i] + total : total;
+		}
+	}
+
+	AM_TARGET_AVX512 void rotateAvx512(float* out, int numSamples, bool add, bool normalise)
+	{
+		alignas(64) float sums[scratchSize * 16];
+		const int used = paddedSize(numActive);
+		const __m512 half = _mm512_set1_ps(normalise ? 0.5f : 0.0f);			//the correction is 1.5 - 0.5 * r^2 when normalising, 1 otherwise
+		const __m512 threeHalves = _mm512_set1_ps(normalise ? 1.5f : 1.0f);
+
+		for (int a = 0; a < used; a += 32)
+		{
+			__m512 x0 = _mm512_loadu_ps(&re[a]);
+			__m512 y0 = _mm512_loadu_ps(&im[a]);
+			__m512 x1 = _mm512_loadu_ps(&re[a + 16]);
+			__m512 y1 = _mm512_loadu_ps(&im[a + 16]);
+			const __m512 c0 = _mm512_loadu_ps(&stepCos[a]);
+			const __m512 s0 = _mm512_loadu_ps(&stepSin[a]);
+			const __m512 c1 = _mm512_loadu_ps(&stepCos[a + 16]);
+			const __m512 s1 = _mm512_loadu_ps(&stepSin[a + 16]);
+			const __m512 g0 = _mm512_loadu_ps(&gain[a]);
+			const __m512 g1 = _mm512_loadu_ps(&gain[a + 16]);
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				const __m512 turned0 = _mm512_fmsub_ps(x0, c0, _mm512_mul_ps(y0, s0));
+				const __m512 turned1 = _mm512_fmsub_ps(x1, c1, _mm512_mul_ps(y1, s1));
+				y0 = _mm512_fmadd_ps(x0, s0, _mm512_mul_ps(y0, c0));
+				y1 = _mm512_fmadd_ps(x1, s1, _mm512_mul_ps(y1, c1));
+				x0 = turned0;
+				x1 = turned1;
+
+				const __m512 weighted = _mm512_fmadd_ps(g0, y0, _mm512_mul_ps(g1, y1));
+				_mm512_store_ps(&sums[i * 16], a == 0 ? weighted : _mm512_add_ps(_mm512_load_ps(&sums[i * 16]), weighted));
+			}
+
+			const __m512 correction0 = _mm512_fnmadd_ps(half, _mm512_fmadd_ps(x0, x0, _mm512_mul_ps(y0, y0)), threeHalves);
+			const __m512 correction1 = _mm512_fnmadd_ps(half, _mm512_fmadd_ps(x1, x1, _mm512_mul_ps(y1, y1)), threeHalves);
+			_mm512_storeu_ps(&re[a], _mm512_mul_ps(x0, correction0));
+			_mm512_storeu_ps(&im[a], _mm512_mul_ps(y0, correction0));
+			_mm512_storeu_ps(&re[a + 16], _mm512_mul_ps(x1, correction1));
+			_mm512_storeu_ps(&im[a + 16], _mm512_mul_ps(y1, correction1));
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			const __m256 v = _mm256_add_ps(_mm256_load_ps(&sums[i * 16]), _mm256_load_ps(&sums[i * 16 + 8]));
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			const float total = _mm_cvtss_f32(s);
+			out[i] = add ? out[i] + total : total;
+		}
+	}
+
+#endif
+
+	//Inverse FFT mode
+
+	void renderFromFrames(float* out, int numSamples, bool add)
+	{
+		for (int i = 0; i < numSamples;)
+		{
+			if (readyPosition == hopSize)
+			{
+				renderFrame();
+			}
+
+			const int chunk = std::min(hopSize - readyPosition, numSamples - i);
+			for (int n = 0; n < chunk; n++)
+			{
+				out[i + n] = add ? out[i + n] + ready[readyPosition + n] : ready[readyPosition + n];
+			}
+			readyPosition += chunk;
+			i += chunk;
+		}
+	}
+
+	/**
+	*renders the next hop. Each partial adds its Blackman-Harris window's spectrum, centred on its frequency, to the
+	*bins around it; after the inverse FFT the frame is the sum of windowed sines. Dividing out the window and applying
+	*a triangle over the middle half lets consecutive frames, one hop apart, add up to constant-amplitude sines.
+	*/
+	void renderFrame()
+	{
+		std::fill(fftRe.begin(), fftRe.end(), 0.0f);
+		std::fill(fftIm.begin(), fftIm.end(), 0.0f);
+
+		const std::vector<float>& kernel = getKernel();
+		float* spectrumRe = fftRe.data() + kernelRadius;				//the first kernelRadius floats hold bins -4 to -1
+		float* spectrumIm = fftIm.data() + kernelRadius;
+
+		for (int a = 0; a < numActive; a++)
+		{
+			//the partial is g * sin(phase) = g * cos(phase - pi / 2) at the middle of the frame
+			const float coefficientRe = 0.5f * gain[a] * im[a];
+			const float coefficientIm = -0.5f * gain[a] * re[a];
+
+			//the bins a partial covers all sit at the same fraction of a bin from it, so they are one row of the kernel
+			const float position = bin[a];
+			const int below = int(position);
+			const float offset = (position - float(below)) * float(kernelSteps);
+			const int row = int(offset);
+			const float fraction = offset - float(row);
+			const float* weights = kernel.data() + row * 2 * kernelRadius;
+			const float* nextWeights = weights + 2 * kernelRadius;
+
+			const int first = below - kernelRadius + 1;
+			const float sign = (first & 1) != 0 ? -1.0f : 1.0f;				//the frame's middle is half an FFT in
+			const float re0 = sign * coefficientRe;
+			const float im0 = sign * coefficientIm;
+			float* binsRe = spectrumRe + first;
+			float* binsIm = spectrumIm + first;
+
+			for (int k = 0; k < 2 * kernelRadius; k++)
+			{
+				const float weight = weights[k] + fraction * (nextWeights[k] - weights[k]);
+				binsRe[k] += re0 * weight;
+				binsIm[k] += im0 * weight;
+			}
+
+			//on to the middle of the next frame
+			const float turned = re[a] * stepCos[a] - im[a] * stepSin[a];
+			im[a] = re[a] * stepSin[a] + im[a] * stepCos[a];
+			re[a] = turned;
+			toUnitCircle(re[a], im[a]);
+		}
+
+		inverseRealFft(spectrumRe, spectrumIm);
+
+		//the frame covers one hop either side of its middle: the first hop finishes the overlap, the second starts it.
+		//Sample 2m of the frame is in halfRe[m] and sample 2m + 1 in halfIm[m].
+		const float scale = 1.0f / float(fftSize);
+		for (int n = 0; n < hopSize; n += 2)
+		{
+			const int early = (fftSize / 4 + n) / 2;
+			const int late = (fftSize / 2 + n) / 2;
+			ready[n] = overlap[n] + scale * halfRe[early] * synthesisWindow[n];
+			ready[n + 1] = overlap[n + 1] + scale * halfIm[early] * synthesisWindow[n + 1];
+			overlap[n] = scale * halfRe[late] * synthesisWindow[hopSize + n];
+			overlap[n + 1] = scale * halfIm[late] * synthesisWindow[hopSize + n + 1];
+		}
+		readyPosition = 0;
+	}
+
+	/**
+	*turns the one-sided spectrum X (bins -kernelRadius to fftSize / 2 + kernelRadius) into 2 * Re(inverse FFT of X),
+	*unscaled, with one complex FFT of half the size: the real signal's even samples go in the real part and its odd
+	*samples in the imaginary part.
+	*/
+	void inverseRealFft(const float* spectrumRe, const float* spectrumIm)
+	{
+		const int half = fftSize / 2;
+
+		//Hermitian spectrum H[k] = X[k] + conj(X[-k]), folding in what spilled below 0 and above Nyquist
+		auto hermitian = [&](int k, float& hr, float& hi)
+		{
+			hr = spectrumRe[k];
+			hi = spectrumIm[k];
+			if (k <= kernelRadius)
+			{
+				hr += spectrumRe[-k];
+				hi -= spectrumIm[-k];
+			}
+			if (k >= half - kernelRadius)
+			{
+				hr += spectrumRe[fftSize - k];
+				hi -= spectrumIm[fftSize - k];
+			}
+		};
+
+		for (int k = 0; k < half; k++)
+		{
+			float ar, ai, br, bi;
+			hermitian(k, ar, ai);
+			hermitian(half - k, br, bi);
+			bi = -bi;														//conj(H[N / 2 - k])
+
+			const float evenRe = ar + br;
+			const float evenIm = ai + bi;
+			const float differenceRe = ar - br;
+			const float differenceIm = ai - bi;
+			const float oddRe = differenceRe * postRe[k] - differenceIm * postIm[k];
+			const float oddIm = differenceRe * postIm[k] + differenceIm * postRe[k];
+
+			halfRe[k] = evenRe - oddIm;
+			halfIm[k] = evenIm + oddRe;
+		}
+
+		inverseFft(halfRe.data(), halfIm.data());
+	}
+
+	//in-place radix-2 inverse FFT of fftSize / 2 bins, unscaled
+	void inverseFft(float* xr, float* xi)
+	{
+		const int size = fftSize / 2;
+
+		for (int i = 0; i < size; i++)
+		{
+			const int j = bitReversed[i];
+			if (j > i)
+			{
+				std::swap(xr[i], xr[j]);
+				std::swap(xi[i], xi[j]);
+			}
+		}
+
+		//the first two stages together need no multiplies: their twiddles are 1 and j
+		for (int start = 0; start < size; start += 4)
+		{
+			float* r = xr + start;
+			float* i = xi + start;
+			const float sumRe0 = r[0] + r[1];
+			const float sumIm0 = i[0] + i[1];
+			const float differenceRe0 = r[0] - r[1];
+			const float differenceIm0 = i[0] - i[1];
+			const float sumRe1 = r[2] + r[3];
+			const float sumIm1 = i[2] + i[3];
+			const float differenceRe1 = r[2] - r[3];
+			const float differenceIm1 = i[2] - i[3];
+
+			r[0] = sumRe0 + sumRe1;
+			i[0] = sumIm0 + sumIm1;
+			r[2] = sumRe0 - sumRe1;
+			i[2] = sumIm0 - sumIm1;
+			r[1] = differenceRe0 - differenceIm1;						//j * (differenceRe1 + j * differenceIm1)
+			i[1] = differenceIm0 + differenceRe1;
+			r[3] = differenceRe0 + differenceIm1;
+			i[3] = differenceIm0 - differenceRe1;
+		}
+
+		//each later stage's twiddles are stored one after the other, so the inner loop reads everything contiguously
+		const float* wr = twiddleRe.data();
+		const float* wi = twiddleIm.data();
+
+		for (int halfLength = 4; halfLength < size; halfLength *= 2)
+		{
+			for (int start = 0; start < size; start += 2 * halfLength)
+			{
+				float* topRe = xr + start;
+				float* topIm = xi + start;
+				float* bottomRe = topRe + halfLength;
+				float* bottomIm = topIm + halfLength;
+
+				for (int k = 0; k < halfLength; k++)
+				{
+					const float tr = bottomRe[k] * wr[k] - bottomIm[k] * wi[k];
+					const float ti = bottomRe[k] * wi[k] + bottomIm[k] * wr[k];
+					bottomRe[k] = topRe[k] - tr;
+					bottomIm[k] = topIm[k] - ti;
+					topRe[k] += tr;
+					topIm[k] += ti;
+				}
+			}
+			wr += halfLength;
+			wi += halfLength;
+		}
+	}
+
+	//4 term Blackman-Harris window of fftSize, periodic, n from the start of the frame
+	static double blackmanHarris(double n)
+	{
+		const double x = 6.283185307179586 * n / double(fftSize);
+		return 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x) - 0.01168 * std::cos(3.0 * x);
+	}
+
+	void buildFftTables()
+	{
+		const int size = fftSize / 2;
+		bitReversed.assign(size, 0);
+		int bits = 0;
+		while ((1 << bits) < size)
+		{
+			bits++;
+		}
+		for (int i = 0; i < size; i++)
+		{
+			int reversed = 0;
+			for (int b = 0; b < bits; b++)
+			{
+				reversed |= ((i >> b) & 1) << (bits - 1 - b);
+			}
+			bitReversed[i] = reversed;
+		}
+
+		twiddleRe.clear();
+		twiddleIm.clear();
+		for (int halfLength = 4; halfLength < size; halfLength *= 2)
+		{
+			for (int k = 0; k < halfLength; k++)
+			{
+				const double angle = 3.141592653589793 * double(k) / double(halfLength);
+				twiddleRe.push_back(float(std::cos(angle)));
+				twiddleIm.push_back(float(std::sin(angle)));				//positive: inverse transform
+			}
+		}
+
+		//the odd samples are half a sample later
+		postRe.assign(size, 0.0f);
+		postIm.assign(size, 0.0f);
+		for (int k = 0; k < size; k++)
+		{
+			const double angle = 6.283185307179586 * double(k) / double(fftSize);
+			postRe[k] = float(std::cos(angle));
+			postIm[k] = float(std::sin(angle));
+		}
+
+		//triangle over the middle half of the frame, divided by the window the kernel put there
+		synthesisWindow.assign(2 * hopSize, 0.0f);
+		for (int n = 0; n < 2 * hopSize; n++)
+		{
+			const double triangle = 1.0 - std::fabs(double(n - hopSize)) / double(hopSize);
+			synthesisWindow[n] = float(triangle / blackmanHarris(double(fftSize / 4 + n)));
+		}
+	}
+
+	/**
+	*the window's spectrum, one row of 2 * kernelRadius bins for each of kernelSteps + 1 fractions of a bin. Row f is for
+	*a partial f / kernelSteps of a bin above a whole bin b, and holds the weights of bins b - 3 to b + 4, with every
+	*other one negated. It is the same for every engine, so it is worked out once.
+	*/
+	static const std::vector<float>& getKernel()
+	{
+		static const std::vector<float> kernel = []
+		{
+			std::vector<float> table((kernelSteps + 1) * 2 * kernelRadius, 0.0f);
+			for (int row = 0; row <= kernelSteps; row++)
+			{
+				for (int k = 0; k < 2 * kernelRadius; k++)
+				{
+					const double offset = double(k - kernelRadius + 1) - double(row) / double(kernelSteps);
+					double sum = 0.0;
+					for (int n = 0; n < fftSize; n++)
+					{
+						const double centred = double(n - fftSize / 2);
+						sum += blackmanHarris(double(n)) * std::cos(6.283185307179586 * offset * centred / double(fftSize));
+					}
+					table[row * 2 * kernelRadius + k] = float((k & 1) != 0 ? -sum : sum);
+				}
+			}
+			return table;
+		}();
+		return kernel;
+	}
+
+	//every partial, in order
+	std::vector<float> ratio;
+	std::vector<float> amplitude;
+	std::vector<float> stateRe;									//phase of a partial while it is culled
+	std::vector<float> stateIm;
+
+	//the partials that are not culled, as structure-of-arrays padded with silent ones
+	std::vector<int> activeIndex;
+	std::vector<float> re;										//cos and sin of each partial's phase
+	std::vector<float> im;
+	std::vector<float> stepCos;									//rotation per sample (rotation mode) or per hop (inverseFft mode)
+	std::vector<float> stepSin;
+	std::vector<float> gain;
+	std::vector<float> bin;										//frequency in FFT bins
+
+	//inverse FFT mode
+	std::vector<float> fftRe;									//one-sided spectrum, from bin -kernelRadius
+	std::vector<float> fftIm;
+	std::vector<float> halfRe;									//the half size FFT
+	std::vector<float> halfIm;
+	std::vector<int> bitReversed;
+	std::vector<float> twiddleRe;
+	std::vector<float> twiddleIm;
+	std::vector<float> postRe;									//e^(j 2 pi k / fftSize)
+	std::vector<float> postIm;
+	std::vector<float> synthesisWindow;
+	float overlap[hopSize] = {};
+	float ready[hopSize] = {};
+	int readyPosition = hopSize;
+	int samplesSinceNormalise = 0;
+
+	int numPartials = 0;
+	int numActive = 0;
+	bool needsUpdate = false;
+	bool usingFft = false;										//the mode chosen by the last updatePartials()
+	bool needsModeChoice = false;								//set by setUp(), setMode() and setInstructionSet() only
+	float sampleRate = 44100.0f;
+	float baseFrequency = 110.0f;
+	AdditiveMode mode = AdditiveMode::automatic;
+	InstructionSet instructionSet = InstructionSet::scalar;
+};
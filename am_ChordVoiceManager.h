@@ -0,0 +1,362 @@
+/*
+  ==============================================================================
+
+    am_ChordVoiceManager.h
+    Created: 17 Oct 2026 4:48:13pm
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Chords.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+///which voice to take over when a note starts and every voice is busy
+enum class VoiceStealing
+{
+    oldest = 0,     //the voice whose note started first
+    quietest        //the voice with the lowest envelope level
+};
+
+/**
+*Plays chords polyphonically from a pool of MaxVoices FixedChord voices that are all created up front, so note-on and
+*note-off never allocate and can be called from the audio thread.
+*
+*Each voice has a linear attack/release envelope. A voice is free again once its release reaches silence. When every
+*voice is busy, a note-on steals one: voices already releasing are taken first, then the oldest or quietest one
+*(setVoiceStealing()). A stolen voice is still sounding, so its new note's attack starts from the level it had reached
+*(and glides down to the new velocity if that is lower) instead of jumping to 0, which would click.
+*
+*Only the voices that are playing are kept in the list the render functions walk through, so the cost of process()
+*and processBlock() depends on the number of notes sounding, not on MaxVoices.
+*
+*@tparam number of voices in the pool
+*@tparam most octaves a single chord can have
+*/
+template <int MaxVoices, int MaxOctaves = 1>
+class ChordVoiceManager
+{
+    static_assert(MaxVoices > 0, "ChordVoiceManager needs at least one voice");
+
+public:
+
+    /**
+    *sets up every voice in the pool. Can be called again (e.g. on a sample rate change), which silences all voices.
+    *@param sample rate in Hz
+    *@param wave index for every voice: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+    *@param number of octaves in each chord, clamped to [1, MaxOctaves]
+    */
+    void setUp(float _sampleRate, int waveIndex, int octaves)
+    {
+        sampleRate = _sampleRate;
+        octaves = std::min(std::max(octaves, 1), MaxOctaves);
+
+        for (auto& voice : voices)
+        {
+            voice.chord.setUp(sampleRate, 100.0f, waveIndex, 0, octaves);
+            voice.active = false;
+            voice.level = 0.0f;
+        }
+        numActive = 0;
+
+        updateEnvelopeSteps();
+    }
+
+    /**
+    *set the envelope used by every voice
+    *@param attack time in seconds
+    *@param release time in seconds
+    */
+    void setEnvelope(float attackSeconds, float releaseSeconds)
+    {
+        attackTime = std::max(attackSeconds, 0.0f);
+        releaseTime = std::max(releaseSeconds, 0.0f);
+        updateEnvelopeSteps();
+    }
+
+    //choose which voice is taken over when the pool is full
+    void setVoiceStealing(VoiceStealing policy)
+    {
+        stealing = policy;
+    }
+
+    //choose how sine waves are calculated for every voice (see am_FastSine.h)
+    void setSineMode(SineMode mode)
+    {
+        for (auto& voice : voices)
+        {
+            voice.chord.setSineMode(mode);
+        }
+    }
+
+    //choose band-limited (PolyBLEP) square, triangle and sawtooth waves for every voice
+    void setBandLimited(bool shouldBandLimit)
+    {
+        for (auto& voice : voices)
+        {
+            voice.chord.setBandLimited(shouldBandLimit);
+        }
+    }
+
+    /**
+    *starts a chord, stealing a voice if the pool is full
+    *@param note number (any id the caller uses to match the note-off)
+    *@param base frequency of the chord in Hz
+    *@param type of chord: 0 = major, 1 = minor
+    *@param velocity in [0, 1], used as the gain of the voice
+    *@return index of the voice playing the note
+    */
+    int noteOn(int noteNumber, float baseFrequency, int chordChoice, float velocity)
+    {
+        const int index = findVoice();
+        Voice& voice = voices[index];
+
+        if (chordChoice == 1)
+        {
+            voice.chord.setMinorBaseFrequency(baseFrequency);
+        }
+        else
+        {
+            voice.chord.setMajorBaseFrequency(baseFrequency);
+        }
+
+        voice.note = noteNumber;
+        voice.velocity = velocity;
+        voice.step = std::abs(velocity - voice.level) * attackStep;  //from wherever a stolen voice was, to the velocity in the attack time
+        voice.releasing = false;
+        voice.startedAt = noteCounter++;
+
+        if (!voice.active)
+        {
+            voice.active = true;
+            activeList[numActive++] = index;
+        }
+
+        return index;
+    }
+
+    /**
+    *releases every voice playing a note
+    *@param note number given to noteOn()
+    */
+    void noteOff(int noteNumber)
+    {
+        for (int i = 0; i < numActive; i++)
+        {
+            Voice& voice = voices[activeList[i]];
+            if (voice.note == noteNumber)
+            {
+                release(voice);
+            }
+        }
+    }
+
+    //releases every voice
+    void allNotesOff()
+    {
+        for (int i = 0; i < numActive; i++)
+        {
+            release(voices[activeList[i]]);
+        }
+    }
+
+    //number of voices sounding (including ones in their release)
+    int getNumActiveVoices() const
+    {
+        return numActive;
+    }
+
+    //outputs one sample of every sounding voice
+    float process()
+    {
+        float mix = 0.0f;
+
+        for (int i = 0; i < numActive; i++)
+        {
+            Voice& voice = voices[activeList[i]];
+            mix += voice.chord.process() * nextGain(voice);
+        }
+
+        removeFinishedVoices();
+        return mix;
+    }
+
+    /**
+    *fills a buffer with every sounding voice, overwriting what is already there.
+    *Sample-identical to calling process() numSamples times.
+    *@param buffer to write into
+    *@param number of samples to write
+    */
+    void processBlock(float* out, int numSamples)
+    {
+        std::fill(out, out + std::max(numSamples, 0), 0.0f);
+        processBlockAdd(out, numSamples);
+    }
+
+    /**
+    *adds every sounding voice on top of what is already in the buffer
+    *@param buffer to add into
+    *@param number of samples to add
+    */
+    void processBlockAdd(float* out, int numSamples)
+    {
+        float voiceOut[scratchSize];
+        float gains[scratchSize];
+
+        for (int start = 0; start < numSamples; start += scratchSize)
+        {
+            const int chunk = std::min(scratchSize, numSamples - start);
+
+            for (int i = 0; i < numActive; i++)
+            {
+                Voice& voice = voices[activeList[i]];
+
+                //a voice whose release ends in this chunk stops on that sample, as it would in process()
+                int length = chunk;
+                for (int j = 0; j < chunk; j++)
+                {
+                    gains[j] = nextGain(voice);
+                    if (voice.releasing && voice.level <= 0.0f)
+                    {
+                        length = j + 1;
+                        break;
+                    }
+                }
+
+                voice.chord.processBlock(voiceOut, length);
+
+                for (int j = 0; j < length; j++)
+                {
+                    out[start + j] += voiceOut[j] * gains[j];
+                }
+            }
+
+            removeFinishedVoices();
+        }
+    }
+
+private:
+
+    struct Voice
+    {
+        FixedChord<MaxOctaves> chord;
+        int note = -1;
+        float velocity = 1.0f;
+        float level = 0.0f;             //envelope level, the gain of the voice: moves to velocity, then to 0 in the release
+        float step = 0.0f;              //envelope change per sample for the current attack or release
+        bool releasing = false;
+        bool active = false;
+        uint64_t startedAt = 0;         //note-on count when the note started, smaller is older
+    };
+
+    static constexpr int scratchSize = 64;      //samples rendered per voice at a time in the block functions
+
+    //moves the envelope on one sample and returns the gain of the voice
+    float nextGain(Voice& voice) const
+    {
+        if (voice.releasing)
+        {
+            voice.level = std::max(voice.level - voice.step, 0.0f);
+        }
+        else if (voice.level < voice.velocity)
+        {
+            voice.level = std::min(voice.level + voice.step, voice.velocity);
+        }
+        else
+        {
+            voice.level = std::max(voice.level - voice.step, voice.velocity);      //a stolen voice that was louder
+        }
+        return voice.level;
+    }
+
+    //starts a voice's release, which reaches 0 in the release time from wherever the envelope is
+    void release(Voice& voice) const
+    {
+        if (!voice.releasing)
+        {
+            voice.releasing = true;
+            voice.step = voice.level * releaseStep;
+        }
+    }
+
+    //a free voice if there is one, otherwise the voice to steal
+    int findVoice() const
+    {
+        if (numActive < MaxVoices)
+        {
+            for (int i = 0; i < MaxVoices; i++)
+            {
+                if (!voices[i].active)
+                {
+                    return i;
+                }
+            }
+        }
+
+        int best = activeList[0];
+        for (int i = 1; i < numActive; i++)
+        {
+            if (isBetterToSteal(voices[activeList[i]], voices[best]))
+            {
+                best = activeList[i];
+            }
+        }
+        return best;
+    }
+
+    //true if a should be stolen before b
+    bool isBetterToSteal(const Voice& a, const Voice& b) const
+    {
+        if (a.releasing != b.releasing)
+        {
+            return a.releasing;
+        }
+
+        if (stealing == VoiceStealing::quietest && a.level != b.level)
+        {
+            return a.level < b.level;
+        }
+
+        return a.startedAt < b.startedAt;
+    }
+
+    //takes voices whose release has finished out of the render list, keeping the rest in note-on order
+    void removeFinishedVoices()
+    {
+        int kept = 0;
+        for (int i = 0; i < numActive; i++)
+        {
+            Voice& voice = voices[activeList[i]];
+            if (voice.releasing && voice.level <= 0.0f)
+            {
+                voice.active = false;
+            }
+            else
+            {
+                activeList[kept++] = activeList[i];
+            }
+        }
+        numActive = kept;
+    }
+
+    void updateEnvelopeSteps()
+    {
+        attackStep = attackTime > 0.0f ? 1.0f / (attackTime * sampleRate) : 1.0f;
+        releaseStep = releaseTime > 0.0f ? 1.0f / (releaseTime * sampleRate) : 1.0f;
+    }
+
+    Voice voices[MaxVoices];            //the pool, created once
+    int activeList[MaxVoices] = {};     //indices of the sounding voices
+    int numActive = 0;
+    uint64_t noteCounter = 0;
+
+    VoiceStealing stealing = VoiceStealing::oldest;
+    float sampleRate = 44100.0f;
+    float attackTime = 0.005f;
+    float releaseTime = 0.05f;
+    float attackStep = 1.0f;
+    float releaseStep = 1.0f;
+};
@@ -1,224 +1,938 @@
-/*
-  ==============================================================================
-
-    am_Chords.h
-    Created: 3 Nov 2022 3:53:26pm
-    Author:  Andrew McGillivray
-
-  ==============================================================================
-*/
-
-/**
-*3 classes outputting major chords and minor chords in different wave forms, and cluster chords 
-*/
-
-#pragma once
-
-#include "Oscillators.h"
-#include <vector>
-#include <JuceHeader.h>
-
-/**
-*A class that can make major or minor chords out of sawtooth waves.
-*/
-class Chord
-{
-public:
-
-    //create a chord of a chosen oscillator and frequency
-    /**
-    * @param sample rate in Hz
-    * @param frequency of base note in Hz
-    * @param choice of wave for the chord:
-    * @param type of chord: 0 = major, 1 = minor
-    * @param number of octaves in chord
-    */
-    void setUp(float _sampleRate, float baseFrequency, int waveChoice, int chordChoice, int octaves)
-    {
-        chordCount = octaves * 3;
-
-        if (chordChoice > 1)
-        {
-            chordChoice = 1;
-        }
-
-        if (chordChoice < 0)
-        {
-            chordChoice = 0;
-        }
-
-        //major chord
-        if (chordChoice == 0)
-        {
-            for (int i = 0; i < chordCount; i += 3)                       //will create a major chord for however many octaves are chosen
-            {
-                //root note
-                chord.push_back(Oscillator());
-                chord[i].setUp(_sampleRate, baseFrequency * (i + 1), waveChoice);
-
-                //major third
-                chord.push_back(Oscillator());
-                chord[i + 1].setUp(_sampleRate, baseFrequency * (i + 1) * 1.26, waveChoice);
-
-                //major fifth
-                chord.push_back(Oscillator());
-                chord[i + 2].setUp(_sampleRate, baseFrequency * (i + 1) * 1.5, waveChoice);
-            }
-        }
-
-        //minor chord
-        if (chordChoice == 1)
-        {
-            for (int i = 0; i < chordCount; i += 3)                       //will create a major chord for however many octaves are chosen
-            {
-                //root note
-                chord.push_back(Oscillator());
-                chord[i].setUp(_sampleRate, baseFrequency * (i + 1), waveChoice);
-
-                //minor third
-                chord.push_back(Oscillator());
-                chord[i + 1].setUp(_sampleRate, baseFrequency * (i + 1) * 1.189, waveChoice);
-
-                //major fifth
-                chord.push_back(Oscillator());
-                chord[i + 2].setUp(_sampleRate, baseFrequency * (i + 1) * 1.5, waveChoice);
-            }
-        }
-    }
-
-
-    //the following is created for phasor waves only:
-    //set the number of octaves involved in the chord. Must be set before sample rate. Initial value of 1.
-    void setOctaves(int octaveNumber)
-    {
-        chordCount = octaveNumber * 3;
-    }
-
-    /**
-    * set the sample rate for all oscillators involved
-    * @param sample rate in Hz
-    */
-    void setSampleRate(float _sampleRate)
-    {
-        for (int i = 0; i < chordCount; i++)                  //creates a triad of waves
-        {
-            chord.push_back(Oscillator());
-            chord[i].setSampleRate(_sampleRate);            //creates a new oscillator and sets the sample rate
-        }
-    }
-
-    /**
-    *creates a major chord from an input value
-    *@param base frequency value in Hz
-    */
-    void setMajorBaseFrequency(float input)
-    {
-        for (int i = 0; i < chordCount; i += 3)                       //will create a major chord for however many octaves are chosen
-        {
-            chord[i].setFrequency(input * (i + 1));                 //root note
-            chord[i + 1].setFrequency(input * (i + 1) * 1.26);      //major third
-            chord[i + 2].setFrequency(input * (i + 1) * 1.5);       //major fifth
-        }
-    }
-
-    /**
-    *creates a minor chord from an input value
-    *@param base frequency value in Hz
-    */
-    void setMinorBaseFrequency(float input)                         
-    {
-        for (int i = 0; i < chordCount; i += 3)                     //will create a minor chord for however many octaves are chosen
-        {
-            chord[i].setFrequency(input * (i + 1));                 //root note
-            chord[i + 1].setFrequency(input * (i + 1) * 1.189);     //minor third
-            chord[i + 2].setFrequency(input * (i + 1) * 1.5);       //major fifth
-        }
-    }
-
-    //finds the output of the chord
-    float process()
-    {
-        float mix = 0;
-        for (int i = 0; i < chordCount; i++)
-        {
-            mix += chord[i].process() / (float(chordCount) * (i+1)); //adds the output of each oscillator together, with each additional note decreasing in amplitude 
-        }
-        return mix;
-    }
-
-private:
-    std::vector<Oscillator> chord;      //vector to contain the chords
-    int chordCount = 3;           //number of chords involved
-
-};
-
-
-class clusterChord
-{
-public:
-
-    void setUpCluster(float _sampleRate, int numOfChords, int waveIndex)
-    {
-        clusterCount = numOfChords;
-        
-        for (int i = 0; i < clusterCount; i++)
-        {
-            randomVal = (1000 * random.nextFloat() + 300);          //choose a random base frequency in the range 300 to 1300Hz
-            cluster.push_back(Chord());
-
-            if (i % 2 == 0)                                         //chord creation will alternate between major and minor
-            {
-                cluster[i].setUp(_sampleRate, randomVal, waveIndex, 0, 1);        //uses the random base frequency to create a major chord
-            }
-            else
-            {
-                cluster[i].setUp(_sampleRate, randomVal, waveIndex, 1, 1);        //uses the random base frequency to create a minor chord
-            }
-        }
-    }
-
-
-    void setChordNumber(int input)
-    {
-        clusterCount = input;
-    }
-
-    //creates the randomized cluster chord
-    void setSampleRate(float sampleRate)
-    {
-        for (int i = 0; i < clusterCount; i++)
-        {
-            randomVal = (1000 * random.nextFloat() + 300);          //choose a random base frequency in the range 300 to 1300Hz
-            cluster.push_back(Chord());                          
-            cluster[i].setSampleRate(sampleRate);                   //create a new chord
-
-            if (i % 2 == 0)                                         //chord creation will alternate between major and minor
-            {
-                cluster[i].setMajorBaseFrequency(randomVal);        //uses the random base frequency to create a major chord
-            }
-            else
-            {
-                cluster[i].setMinorBaseFrequency(randomVal);        //uses the random base frequency to create a minor chord
-            }
-        }
-    }
-
-    //outputs the cluster chord
-    float process()
-    {
-        float clusterSample = 0.0f;
-        for (int j = 0; j < clusterCount; j++)
-        {
-            clusterSample += cluster[j].process() / clusterCount;
-        }
-
-        return clusterSample;
-    }
-
-private:
-
-    std::vector<Chord> cluster;
-    float randomVal;
-    float clusterCount = 1;
-    juce::Random random;
-};
\ No newline at end of file
+/*
+  ==============================================================================
+
+    am_Chords.h
+    Created: 3 Nov 2022 3:53:26pm
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*3 classes outputting major chords and minor chords in different wave forms, and cluster chords 
+*
+*Chord and clusterChord keep their notes in a std::vector, which only allocates when it grows past the largest size it
+*has had. FixedChord<MaxOctaves> and FixedClusterChord<MaxChords> are the same classes with their notes stored inline
+*(FixedVector), so they never allocate after construction and can be set up again at a new sample rate at any time.
+*/
+
+#pragma once
+
+#include "am_Oscillators.h"
+#include "am_OscillatorBank.h"
+#include "am_FixedVector.h"
+#include "am_Profiler.h"
+#include "am_RenderThreadPool.h"
+#include "am_Random.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+*A class that can make major or minor chords out of sawtooth waves.
+*@tparam container for the notes: std::vector<Oscillator> (Chord) or FixedVector<Oscillator, N> (FixedChord)
+*/
+template <class Voices>
+class BasicChord
+{
+public:
+
+    BasicChord()
+    {
+        if (FixedCapacity<Voices>::value > 0)
+        {
+            bank.reserve(FixedCapacity<Voices>::value);     //so useOscillatorBank() never allocates either
+        }
+    }
+
+    //create a chord of a chosen oscillator and frequency
+    /**
+    * @param sample rate in Hz
+    * @param frequency of base note in Hz
+    * @param choice of wave for the chord:
+    * @param type of chord: 0 = major, 1 = minor
+    * @param number of octaves in chord
+    */
+    void setUp(float _sampleRate, float baseFrequency, int waveChoice, int chordChoice, int octaves)
+    {
+        resizeChord(octaves * 3);
+
+        if (chordChoice > 1)
+        {
+            chordChoice = 1;
+        }
+
+        if (chordChoice < 0)
+        {
+            chordChoice = 0;
+        }
+
+        //major chord
+        if (chordChoice == 0)
+        {
+            for (int i = 0; i < chordCount; i += 3)                       //will create a major chord for however many octaves are chosen
+            {
+                //root note
+                chord[i].setUp(_sampleRate, baseFrequency * (i + 1), waveChoice);
+
+                //major third
+                chord[i + 1].setUp(_sampleRate, baseFrequency * (i + 1) * 1.26, waveChoice);
+
+                //major fifth
+                chord[i + 2].setUp(_sampleRate, baseFrequency * (i + 1) * 1.5, waveChoice);
+            }
+        }
+
+        //minor chord
+        if (chordChoice == 1)
+        {
+            for (int i = 0; i < chordCount; i += 3)                       //will create a major chord for however many octaves are chosen
+            {
+                //root note
+                chord[i].setUp(_sampleRate, baseFrequency * (i + 1), waveChoice);
+
+                //minor third
+                chord[i + 1].setUp(_sampleRate, baseFrequency * (i + 1) * 1.189, waveChoice);
+
+                //major fifth
+                chord[i + 2].setUp(_sampleRate, baseFrequency * (i + 1) * 1.5, waveChoice);
+            }
+        }
+
+        applyVoiceSettings();
+
+        if (usingBank)
+        {
+            rebuildBank();
+        }
+    }
+
+
+    //the following is created for phasor waves only:
+    //set the number of octaves involved in the chord. Must be set before sample rate. Initial value of 1.
+    void setOctaves(int octaveNumber)
+    {
+        chordCount = octaveNumber * 3;
+    }
+
+    /**
+    * set the sample rate for all oscillators involved. Can be called again (e.g. when the host sample rate changes):
+    * notes that are already set up keep their frequencies, and a glide carries on to its target.
+    * @param sample rate in Hz
+    */
+    void setSampleRate(float _sampleRate)
+    {
+        resizeChord(chordCount);
+
+        for (int i = 0; i < chordCount; i++)                  //creates a triad of waves
+        {
+            chord[i].setSampleRate(_sampleRate);              //rescales the phase increment, glide included
+        }
+
+        applyVoiceSettings();
+
+        if (usingBank && bank.getNumOscillators() == chordCount)
+        {
+            bank.setSampleRate(_sampleRate);                  //the bank holds the phases and glides while it is in use
+        }
+        else if (usingBank)
+        {
+            rebuildBank();
+        }
+    }
+
+    /**
+    *creates a major chord from an input value
+    *@param base frequency value in Hz
+    */
+    void setMajorBaseFrequency(float input)
+    {
+        for (int i = 0; i < chordCount; i += 3)                       //will create a major chord for however many octaves are chosen
+        {
+            chord[i].setFrequency(input * (i + 1));                 //root note
+            chord[i + 1].setFrequency(input * (i + 1) * 1.26);      //major third
+            chord[i + 2].setFrequency(input * (i + 1) * 1.5);       //major fifth
+        }
+
+        if (usingBank)
+        {
+            syncBankFrequencies();
+        }
+    }
+
+    /**
+    *creates a minor chord from an input value
+    *@param base frequency value in Hz
+    */
+    void setMinorBaseFrequency(float input)                         
+    {
+        for (int i = 0; i < chordCount; i += 3)                     //will create a minor chord for however many octaves are chosen
+        {
+            chord[i].setFrequency(input * (i + 1));                 //root note
+            chord[i + 1].setFrequency(input * (i + 1) * 1.189);     //minor third
+            chord[i + 2].setFrequency(input * (i + 1) * 1.5);       //major fifth
+        }
+
+        if (usingBank)
+        {
+            syncBankFrequencies();
+        }
+    }
+
+    /**
+    *glides a major chord to a new base frequency. Every note's target is worked out once here, then each note steps
+    *its phase increment once per sample while rendering (no per-sample setter calls or divisions).
+    *@param base frequency to reach in Hz
+    *@param length of the glide in samples
+    *@param RampShape::exponential (even in pitch) or RampShape::linear (even in Hz)
+    */
+    void rampMajorBaseFrequency(float input, int numSamples, RampShape shape = RampShape::exponential)
+    {
+        rampBaseFrequency(input, 1.26, numSamples, shape);
+    }
+
+    /**
+    *glides a minor chord to a new base frequency (see rampMajorBaseFrequency())
+    *@param base frequency to reach in Hz
+    *@param length of the glide in samples
+    *@param RampShape::exponential (even in pitch) or RampShape::linear (even in Hz)
+    */
+    void rampMinorBaseFrequency(float input, int numSamples, RampShape shape = RampShape::exponential)
+    {
+        rampBaseFrequency(input, 1.189, numSamples, shape);
+    }
+
+    //true while a glide is moving (in the bank, while it is in use)
+    bool isRamping() const
+    {
+        if (usingBank)
+        {
+            return bank.isRamping();
+        }
+
+        for (int i = 0; i < chordCount && i < int(chord.size()); i++)
+        {
+            if (chord[i].isRamping())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+    *choose whether the chord is rendered by an OscillatorBank (SIMD, all notes at once) instead of one Oscillator at a time.
+    *The bank output matches the scalar chord to within float rounding. Call after the chord has been set up.
+    *@param true to render with the bank
+    */
+    void useOscillatorBank(bool shouldUseBank)
+    {
+        usingBank = shouldUseBank;
+
+        if (usingBank)
+        {
+            rebuildBank();
+        }
+    }
+
+    /**
+    *adds every note of this chord to a bank, each weighted the same way process() weights it
+    *@param bank to add the notes to
+    *@param extra gain applied to every note (e.g. 1 / number of chords in a cluster)
+    */
+    void addVoicesToBank(OscillatorBank& target, float gainScale) const
+    {
+        for (int i = 0; i < chordCount && i < int(chord.size()); i++)
+        {
+            const int index = target.addOscillator(chord[i].getFrequency(), gainScale / (float(chordCount) * (i + 1)));
+            target.setPhase(index, chord[i].getPhase());
+            target.setPhaseWidth(index, chord[i].getPhaseWidth());
+            target.rampFrequency(index, chord[i].getTargetFrequency(), chord[i].getFrequencyRampSamples(), chord[i].getFrequencyRampShape());
+        }
+    }
+
+    /**
+    *choose how sine waves are calculated for every note of the chord (see am_FastSine.h for the error of each)
+    *@param SineMode::exact (std::sin), SineMode::polynomial or SineMode::table
+    */
+    void setSineMode(SineMode mode)
+    {
+        sineMode = mode;
+        applyVoiceSettings();
+    }
+
+    SineMode getSineMode() const
+    {
+        return sineMode;
+    }
+
+    /**
+    *choose band-limited (PolyBLEP) square, triangle and sawtooth waves for every note of the chord
+    *@param true for band-limited, false for the original naive waves
+    */
+    void setBandLimited(bool shouldBandLimit)
+    {
+        bandLimited = shouldBandLimit;
+        applyVoiceSettings();
+    }
+
+    bool isBandLimited() const
+    {
+        return bandLimited;
+    }
+
+    //wave index shared by every note of the chord
+    int getWaveIndex() const
+    {
+        return chord.empty() ? 0 : chord[0].getWaveIndex();
+    }
+
+    float getSampleRate() const
+    {
+        return chord.empty() ? 44100.0f : chord[0].getSampleRate();
+    }
+
+    static constexpr char snapshotTag[5] = "CHRD";
+
+    /**
+    *saves or restores every note (phases and glides included) and the bank if it is in use (see am_Snapshot.h).
+    *Chord and FixedChord snapshots are the same, so either restores into the other if it has room for the notes.
+    *@param SnapshotWriter or SnapshotReader
+    */
+    template <class Archive>
+    void serialise(Archive& archive)
+    {
+        archive.objects(chord);
+        archive.value(chordCount);
+        archive.value(sineMode);
+        archive.value(bandLimited);
+        archive.value(usingBank);
+
+        if (usingBank)
+        {
+            bank.serialise(archive);
+        }
+
+        if (Archive::loading && !archive.check(chordCount >= 0 && chordCount <= int(chord.size()) && FastSine::isValidMode(sineMode)))
+        {
+            chordCount = int(chord.size());         //a failed restore falls back to the notes that were restored
+            sineMode = AM_DEFAULT_SINE_MODE;
+            usingBank = false;
+        }
+    }
+
+    //finds the output of the chord
+    float process()
+    {
+        if (usingBank)
+        {
+            return bank.process();
+        }
+
+        float mix = 0;
+        for (int i = 0; i < chordCount; i++)
+        {
+            mix += chord[i].process() / (float(chordCount) * (i+1)); //adds the output of each oscillator together, with each additional note decreasing in amplitude 
+        }
+        return mix;
+    }
+
+    /**
+    *fills a buffer with the chord, overwriting what is already there.
+    *Sample-identical to calling process() numSamples times.
+    *@param buffer to write into
+    *@param number of samples to write
+    */
+    void processBlock(float* out, int numSamples)
+    {
+        AM_PROFILE_MODULE(ProfiledModule::chord, numSamples);
+
+        if (usingBank)
+        {
+            bank.processBlock(out, numSamples);
+            return;
+        }
+
+        for (int start = 0; start < numSamples; start += scratchSize)
+        {
+            mixChunk(out + start, std::min(scratchSize, numSamples - start));
+        }
+    }
+
+    /**
+    *adds the chord on top of what is already in the buffer (out[i] += process())
+    *@param buffer to add into
+    *@param number of samples to add
+    */
+    void processBlockAdd(float* out, int numSamples)
+    {
+        AM_PROFILE_MODULE(ProfiledModule::chord, numSamples);
+
+        if (usingBank)
+        {
+            bank.processBlockAdd(out, numSamples);
+            return;
+        }
+
+        float mix[scratchSize];
+
+        for (int start = 0; start < numSamples; start += scratchSize)
+        {
+            const int chunk = std::min(scratchSize, numSamples - start);
+            mixChunk(mix, chunk);
+
+            for (int i = 0; i < chunk; i++)
+            {
+                out[start + i] += mix[i];
+            }
+        }
+    }
+
+    /**
+    *moves on numSamples without rendering, leaving every note (or the bank) as if the chord had been rendered.
+    *See Oscillator::skipSamples() and OscillatorBank::skipSamples() for what it costs.
+    *@param number of samples to skip
+    */
+    void skipSamples(int64_t numSamples)
+    {
+        if (usingBank)
+        {
+            bank.skipSamples(numSamples);
+            return;
+        }
+
+        for (int i = 0; i < chordCount; i++)
+        {
+            chord[i].skipSamples(numSamples);
+        }
+    }
+
+private:
+
+    static constexpr int scratchSize = 64;      //samples rendered per oscillator at a time in the block functions
+
+    //starts a glide on every note, to the same frequencies setMajor/MinorBaseFrequency() would give
+    void rampBaseFrequency(float input, double third, int numSamples, RampShape shape)
+    {
+        for (int i = 0; i < chordCount; i += 3)
+        {
+            const float targets[3] = { float(input * (i + 1)), float(input * (i + 1) * third), float(input * (i + 1) * 1.5) };
+
+            for (int n = 0; n < 3; n++)
+            {
+                if (usingBank && i + n < bank.getNumOscillators())
+                {
+                    bank.rampFrequency(i + n, targets[n], numSamples, shape);
+                    chord[i + n].setFrequency(targets[n]);          //the bank glides; the note only keeps where it ends
+                }
+                else
+                {
+                    chord[i + n].rampFrequency(targets[n], numSamples, shape);
+                }
+            }
+        }
+    }
+
+    //sets the number of notes, without allocating for a FixedChord (whose note count is clamped to its capacity)
+    void resizeChord(int numNotes)
+    {
+        chord.resize(numNotes);
+        chordCount = int(chord.size());
+    }
+
+    //renders up to scratchSize samples of the chord into mix, summing the oscillators in the same order as process()
+    void mixChunk(float* mix, int numSamples)
+    {
+        float voice[scratchSize];
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            mix[i] = 0;
+        }
+
+        for (int i = 0; i < chordCount; i++)
+        {
+            chord[i].processBlock(voice, numSamples);
+            const float divisor = float(chordCount) * (i + 1);
+
+            for (int j = 0; j < numSamples; j++)
+            {
+                mix[j] += voice[j] / divisor;
+            }
+        }
+    }
+
+    //passes the sine mode and band limiting on to every note and the bank
+    void applyVoiceSettings()
+    {
+        for (auto& note : chord)
+        {
+            note.setSineMode(sineMode);
+            note.setBandLimited(bandLimited);
+        }
+        bank.setSineMode(sineMode);
+        bank.setBandLimited(bandLimited);
+    }
+
+    /**
+    *copies the notes into the bank, keeping their current phases and glides. The notes are not rendered while the bank
+    *is in use, so each one is left at the end of its glide: a later rebuild must not start the glide again.
+    */
+    void rebuildBank()
+    {
+        bank.clear();
+        bank.setSampleRate(getSampleRate());
+        bank.setWaveIndex(getWaveIndex());
+        addVoicesToBank(bank, 1.0f);
+
+        for (int i = 0; i < chordCount; i++)
+        {
+            chord[i].setFrequency(chord[i].getTargetFrequency());
+        }
+    }
+
+    //updates the bank after the base frequency changes without resetting its phases
+    void syncBankFrequencies()
+    {
+        if (bank.getNumOscillators() != chordCount)
+        {
+            rebuildBank();
+            return;
+        }
+
+        for (int i = 0; i < chordCount; i++)
+        {
+            bank.setFrequency(i, chord[i].getFrequency());
+        }
+    }
+
+    Voices chord;                       //container for the notes of the chord
+    int chordCount = 3;           //number of chords involved
+
+    OscillatorBank bank;                //SIMD backend, only used after useOscillatorBank(true)
+    bool usingBank = false;
+    SineMode sineMode = AM_DEFAULT_SINE_MODE;
+    bool bandLimited = false;
+};
+
+///a chord that keeps its notes in a std::vector
+using Chord = BasicChord<std::vector<Oscillator>>;
+
+///a chord of up to MaxOctaves octaves with its notes stored inline. Never allocates after construction.
+template <int MaxOctaves>
+using FixedChord = BasicChord<FixedVector<Oscillator, MaxOctaves * 3>>;
+
+
+/**
+*A cluster of one-octave chords with random base frequencies, alternating major and minor.
+*@tparam container for the chords: std::vector<Chord> (clusterChord) or FixedVector<FixedChord<1>, N> (FixedClusterChord)
+*/
+template <class Chords>
+class BasicClusterChord
+{
+public:
+
+    BasicClusterChord()
+    {
+        if (FixedCapacity<Chords>::value > 0)
+        {
+            bank.reserve(FixedCapacity<Chords>::value * 3);
+        }
+    }
+
+    void setUpCluster(float _sampleRate, int numOfChords, int waveIndex)
+    {
+        resizeCluster(numOfChords);
+        
+        for (int i = 0; i < clusterCount; i++)
+        {
+            randomVal = (1000 * random.nextFloat() + 300);          //choose a random base frequency in the range 300 to 1300Hz
+
+            if (i % 2 == 0)                                         //chord creation will alternate between major and minor
+            {
+                cluster[i].setUp(_sampleRate, randomVal, waveIndex, 0, 1);        //uses the random base frequency to create a major chord
+            }
+            else
+            {
+                cluster[i].setUp(_sampleRate, randomVal, waveIndex, 1, 1);        //uses the random base frequency to create a minor chord
+            }
+        }
+
+        applyVoiceSettings();
+
+        if (usingBank)
+        {
+            rebuildBank();
+        }
+    }
+
+
+    void setChordNumber(int input)
+    {
+        clusterCount = input;
+    }
+
+    /**
+    *choose the seed for the random base frequencies. The same seed always gives the same cluster; without one, every
+    *cluster is different. Takes effect the next time the cluster is set up.
+    *@param seed
+    */
+    void setRandomSeed(uint64_t seed)
+    {
+        random.setSeed(seed);
+    }
+
+    //creates the randomized cluster chord. Can be called again to start a new cluster at a new sample rate.
+    void setSampleRate(float sampleRate)
+    {
+        resizeCluster(int(clusterCount));
+
+        for (int i = 0; i < clusterCount; i++)
+        {
+            randomVal = (1000 * random.nextFloat() + 300);          //choose a random base frequency in the range 300 to 1300Hz
+            cluster[i].setOctaves(1);
+            cluster[i].setSampleRate(sampleRate);                   //set up the chord
+            if (i % 2 == 0)                                         //chord creation will alternate between major and minor
+            {
+                cluster[i].setMajorBaseFrequency(randomVal);        //uses the random base frequency to create a major chord
+            }
+            else
+            {
+                cluster[i].setMinorBaseFrequency(randomVal);        //uses the random base frequency to create a minor chord
+            }
+        }
+
+        applyVoiceSettings();
+
+        if (usingBank)
+        {
+            rebuildBank();
+        }
+    }
+
+    /**
+    *choose whether the whole cluster is rendered by one OscillatorBank holding every note of every chord, so a large
+    *cluster costs a few vector operations per sample. Call after the cluster has been set up.
+    *@param true to render with the bank
+    */
+    void useOscillatorBank(bool shouldUseBank)
+    {
+        usingBank = shouldUseBank;
+
+        if (usingBank)
+        {
+            rebuildBank();
+        }
+    }
+
+    /**
+    *choose how sine waves are calculated for every chord in the cluster (see am_FastSine.h for the error of each)
+    *@param SineMode::exact (std::sin), SineMode::polynomial or SineMode::table
+    */
+    void setSineMode(SineMode mode)
+    {
+        sineMode = mode;
+        applyVoiceSettings();
+    }
+
+    /**
+    *choose band-limited (PolyBLEP) square, triangle and sawtooth waves for every chord in the cluster
+    *@param true for band-limited, false for the original naive waves
+    */
+    void setBandLimited(bool shouldBandLimit)
+    {
+        bandLimited = shouldBandLimit;
+        applyVoiceSettings();
+    }
+
+    /**
+    *render the chords of the cluster on a thread pool in processBlock() and processBlockAdd(). Every chord renders into
+    *its own buffer and the buffers are mixed in chord order afterwards, so the output is bit-identical to rendering on
+    *one thread, whatever the number of threads. Allocates the chord buffers, so call it outside playback.
+    *@param pool to render on, or nullptr to render on the calling thread again
+    *@param most samples processed per pool job (longer blocks are split)
+    */
+    void setRenderThreadPool(RenderThreadPool* pool, int maxBlockSize)
+    {
+        threadPool = pool;
+
+        if (threadPool != nullptr)
+        {
+            const int maxChords = FixedCapacity<Chords>::value > 0 ? FixedCapacity<Chords>::value : int(cluster.size());
+            chordBuffers.assign(size_t(std::max(maxChords, 1)) * std::max(maxBlockSize, 1), 0.0f);
+            parallelBlockSize = std::max(maxBlockSize, 1);
+        }
+    }
+
+    static constexpr char snapshotTag[5] = "CLST";
+
+    /**
+    *saves or restores every chord with its random base frequency and phases, the bank if it is in use, and where the
+    *random generator is, so setting up the cluster again after a restore gives the same new frequencies it would have
+    *(see am_Snapshot.h). The thread pool is not saved; call setRenderThreadPool() again if the cluster has grown.
+    *@param SnapshotWriter or SnapshotReader
+    */
+    template <class Archive>
+    void serialise(Archive& archive)
+    {
+        archive.objects(cluster);
+        archive.value(clusterCount);
+        archive.value(sineMode);
+        archive.value(bandLimited);
+        random.serialise(archive);
+        archive.value(usingBank);
+
+        if (usingBank)
+        {
+            bank.serialise(archive);
+        }
+
+        if (Archive::loading && !archive.check(clusterCount >= 0 && clusterCount <= float(cluster.size())
+            && clusterCount == float(int(clusterCount)) && FastSine::isValidMode(sineMode)))
+        {
+            clusterCount = float(cluster.size());
+            sineMode = AM_DEFAULT_SINE_MODE;
+            usingBank = false;
+        }
+    }
+
+    //outputs the cluster chord
+    float process()
+    {
+        if (usingBank)
+        {
+            return bank.process();
+        }
+
+        float clusterSample = 0.0f;
+        for (int j = 0; j < clusterCount; j++)
+        {
+            clusterSample += cluster[j].process() / clusterCount;
+        }
+
+        return clusterSample;
+    }
+
+    /**
+    *fills a buffer with the cluster chord, overwriting what is already there.
+    *Sample-identical to calling process() numSamples times.
+    *@param buffer to write into
+    *@param number of samples to write
+    */
+    void processBlock(float* out, int numSamples)
+    {
+        AM_PROFILE_MODULE(ProfiledModule::clusterChord, numSamples);
+
+        if (usingBank)
+        {
+            bank.processBlock(out, numSamples);
+            return;
+        }
+
+        if (canRenderParallel())
+        {
+            renderParallel<false>(out, numSamples);
+            return;
+        }
+
+        for (int start = 0; start < numSamples; start += scratchSize)
+        {
+            mixChunk(out + start, std::min(scratchSize, numSamples - start));
+        }
+    }
+
+    /**
+    *adds the cluster chord on top of what is already in the buffer (out[i] += process())
+    *@param buffer to add into
+    *@param number of samples to add
+    */
+    void processBlockAdd(float* out, int numSamples)
+    {
+        AM_PROFILE_MODULE(ProfiledModule::clusterChord, numSamples);
+
+        if (usingBank)
+        {
+            bank.processBlockAdd(out, numSamples);
+            return;
+        }
+
+        if (canRenderParallel())
+        {
+            renderParallel<true>(out, numSamples);
+            return;
+        }
+
+        float mix[scratchSize];
+
+        for (int start = 0; start < numSamples; start += scratchSize)
+        {
+            const int chunk = std::min(scratchSize, numSamples - start);
+            mixChunk(mix, chunk);
+
+            for (int i = 0; i < chunk; i++)
+            {
+                out[start + i] += mix[i];
+            }
+        }
+    }
+
+    /**
+    *moves on numSamples without rendering, leaving every chord (or the bank) as if the cluster had been rendered
+    *@param number of samples to skip
+    */
+    void skipSamples(int64_t numSamples)
+    {
+        if (usingBank)
+        {
+            bank.skipSamples(numSamples);
+            return;
+        }
+
+        for (int j = 0; j < clusterCount; j++)
+        {
+            cluster[j].skipSamples(numSamples);
+        }
+    }
+
+private:
+
+    static constexpr int scratchSize = 64;      //samples rendered per chord at a time in the block functions
+
+    //true if a pool is set and the chord buffers are big enough for the current cluster
+    bool canRenderParallel() const
+    {
+        return threadPool != nullptr && clusterCount >= 1 && int(clusterCount) <= int(cluster.size())
+            && size_t(clusterCount) * parallelBlockSize <= chordBuffers.size();
+    }
+
+    //renders every chord on the pool into its own buffer, then mixes them in the same order and with the same
+    //arithmetic as mixChunk()
+    template <bool Add>
+    void renderParallel(float* out, int numSamples)
+    {
+        const int numChords = int(clusterCount);
+
+        for (int start = 0; start < numSamples; start += parallelBlockSize)
+        {
+            const int block = std::min(parallelBlockSize, numSamples - start);
+
+            auto renderChord = [this, block](int j)
+            {
+                cluster[j].processBlock(chordBuffers.data() + size_t(j) * parallelBlockSize, block);
+            };
+            threadPool->run(numChords, renderChord);
+
+            float mix[scratchSize];
+            for (int offset = 0; offset < block; offset += scratchSize)
+            {
+                const int chunk = std::min(scratchSize, block - offset);
+
+                for (int i = 0; i < chunk; i++)
+                {
+                    mix[i] = 0.0f;
+                }
+
+                for (int j = 0; j < numChords; j++)
+                {
+                    const float* chordOut = chordBuffers.data() + size_t(j) * parallelBlockSize + offset;
+                    for (int i = 0; i < chunk; i++)
+                    {
+                        mix[i] += chordOut[i] / clusterCount;
+                    }
+                }
+
+                for (int i = 0; i < chunk; i++)
+                {
+                    if (Add)
+                    {
+                        out[start + offset + i] += mix[i];
+                    }
+                    else
+                    {
+                        out[start + offset + i] = mix[i];
+                    }
+                }
+            }
+        }
+    }
+
+    //sets the number of chords, without allocating for a FixedClusterChord (whose chord count is clamped to its capacity)
+    void resizeCluster(int numChords)
+    {
+        cluster.resize(numChords);
+        clusterCount = float(cluster.size());
+    }
+
+    //renders up to scratchSize samples of the cluster into mix, summing the chords in the same order as process()
+    void mixChunk(float* mix, int numSamples)
+    {
+        float chordOut[scratchSize];
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            mix[i] = 0.0f;
+        }
+
+        for (int j = 0; j < clusterCount; j++)
+        {
+            cluster[j].processBlock(chordOut, numSamples);
+
+            for (int i = 0; i < numSamples; i++)
+            {
+                mix[i] += chordOut[i] / clusterCount;
+            }
+        }
+    }
+
+
+    //passes the sine mode and band limiting on to every chord and the bank
+    void applyVoiceSettings()
+    {
+        for (auto& member : cluster)
+        {
+            member.setSineMode(sineMode);
+            member.setBandLimited(bandLimited);
+        }
+        bank.setSineMode(sineMode);
+        bank.setBandLimited(bandLimited);
+    }
+
+    //copies every note of every chord into the bank, scaled by the cluster mix
+    void rebuildBank()
+    {
+        bank.clear();
+
+        if (cluster.empty())
+        {
+            return;
+        }
+
+        bank.setSampleRate(cluster[0].getSampleRate());
+        bank.setWaveIndex(cluster[0].getWaveIndex());
+
+        for (int j = 0; j < clusterCount && j < int(cluster.size()); j++)
+        {
+            cluster[j].addVoicesToBank(bank, 1.0f / clusterCount);
+        }
+    }
+
+    Chords cluster;                     //container for the chords of the cluster
+    OscillatorBank bank;                //SIMD backend, only used after useOscillatorBank(true)
+    bool usingBank = false;
+    SineMode sineMode = AM_DEFAULT_SINE_MODE;
+    bool bandLimited = false;
+    float randomVal;
+    float clusterCount = 1;
+    SeededRandom random;
+
+    RenderThreadPool* threadPool = nullptr;     //only used after setRenderThreadPool()
+    std::vector<float> chordBuffers;            //one parallelBlockSize buffer per chord
+    int parallelBlockSize = 0;
+};
+
+///a cluster that keeps its chords in a std::vector
+using clusterChord = BasicClusterChord<std::vector<Chord>>;
+
+///a cluster of up to MaxChords chords stored inline. Never allocates after construction.
+template <int MaxChords>
+using FixedClusterChord = BasicClusterChord<FixedVector<FixedChord<1>, MaxChords>>;
\ No newline at end of file
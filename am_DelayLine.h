@@ -0,0 +1,451 @@
+/*
+  ==============================================================================
+
+    am_DelayLine.h
+    Created: 17 Oct 2026 3:10:22pm
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Simd.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+*How a delay line stores its samples. Each is a struct with the sample type and conversions to and from float, one
+*sample or a whole span at a time; the span versions are what the block functions use, and the single sample versions
+*give exactly the same values.
+*
+*1) Float32Storage - plain floats, 4 bytes a sample. Lossless, and the block functions read the buffer in place.
+*2) Float16Storage - IEEE half floats, 2 bytes a sample. About 66dB of signal to noise at any level (11 bit mantissa),
+*                    converted with F16C on machines with AVX2 (see am_Simd) and bit-identical portable code elsewhere.
+*3) Int16Storage   - 16 bit fixed point with triangular dither, 2 bytes a sample. 96dB below full scale, but it clips
+*                    at +-1 and quiet signals lose resolution, so keep what goes into the line near full scale.
+*
+*The 2 byte formats halve a delay line's memory and the bandwidth streaming it through cache, for patches where the
+*quantisation noise inside the delay is inaudible.
+*/
+struct Float32Storage
+{
+    using Sample = float;
+    static constexpr bool readsInPlace = true;          //the buffer can be read as floats with no conversion
+    static constexpr uint32_t snapshotId = 0;           //names the format in snapshots (am_Snapshot.h)
+
+    static float decode(Sample sample)
+    {
+        return sample;
+    }
+
+    static Sample encode(float value, uint32_t /*position*/)
+    {
+        return value;
+    }
+
+    static void decode(const Sample* source, float* dest, int numSamples)
+    {
+        std::copy(source, source + numSamples, dest);
+    }
+
+    static void encode(const float* source, Sample* dest, int numSamples, uint32_t /*position*/)
+    {
+        std::copy(source, source + numSamples, dest);
+    }
+};
+
+struct Float16Storage
+{
+    using Sample = uint16_t;
+    static constexpr bool readsInPlace = false;
+    static constexpr uint32_t snapshotId = 1;
+
+    static float decode(Sample sample)
+    {
+        float value;
+        decode(&sample, &value, 1);
+        return value;
+    }
+
+    static Sample encode(float value, uint32_t position)
+    {
+        Sample sample;
+        encode(&value, &sample, 1, position);
+        return sample;
+    }
+
+    static void decode(const Sample* source, float* dest, int numSamples)
+    {
+#if AM_SIMD_X86
+        if (hasF16c())
+        {
+            decodeF16c(source, dest, numSamples);
+            return;
+        }
+#endif
+        for (int i = 0; i < numSamples; i++)
+        {
+            dest[i] = halfToFloat(source[i]);
+        }
+    }
+
+    ///rounds to the nearest half float, ties to even. position is unused (no dither).
+    static void encode(const float* source, Sample* dest, int numSamples, uint32_t /*position*/)
+    {
+#if AM_SIMD_X86
+        if (hasF16c())
+        {
+            encodeF16c(source, dest, numSamples);
+            return;
+        }
+#endif
+        for (int i = 0; i < numSamples; i++)
+        {
+            dest[i] = floatToHalf(source[i]);
+        }
+    }
+
+    //portable conversions, branch free so the loops above vectorize. They give the same bits as F16C for all finite values.
+
+    static float halfToFloat(Sample half)
+    {
+        const uint32_t shiftedExponent = 0x7c00u << 13;
+        uint32_t bits = uint32_t(half & 0x7fffu) << 13;
+        const uint32_t exponent = bits & shiftedExponent;
+        bits += (127u - 15u) << 23;                                         //rebias the exponent
+
+        bits += exponent == shiftedExponent ? (128u - 16u) << 23 : 0u;      //infinity and NaN keep the top exponent
+        const bool subnormal = exponent == 0;
+        bits += subnormal ? 1u << 23 : 0u;
+
+        float value = bitsToFloat(bits);
+        value -= subnormal ? bitsToFloat(113u << 23) : 0.0f;               //renormalise a half subnormal
+        return bitsToFloat(floatToBits(value) | (uint32_t(half & 0x8000u) << 16));
+    }
+
+    static Sample floatToHalf(float value)
+    {
+        uint32_t bits = floatToBits(value);
+        const uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        //results that are subnormal as halves: let the float adder do the rounding
+        const float subnormalMagic = bitsToFloat(((127u - 15u) + (23u - 10u) + 1u) << 23);
+        const uint32_t subnormalResult = floatToBits(bitsToFloat(bits) + subnormalMagic) - floatToBits(subnormalMagic);
+
+        //normal results: rebias, then round to nearest even on the 13 bits dropped
+        const uint32_t mantissaOdd = (bits >> 13) & 1u;
+        const uint32_t normalResult = (bits + ((15u - 127u) << 23) + 0xfffu + mantissaOdd) >> 13;
+
+        const uint32_t overflowResult = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;   //NaN or infinity
+
+        uint32_t half = bits >= (127u + 16u) << 23 ? overflowResult : (bits < 113u << 23 ? subnormalResult : normalResult);
+        return Sample(half | (sign >> 16));
+    }
+
+private:
+    static float bitsToFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static uint32_t floatToBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+#if AM_SIMD_X86
+    static bool hasF16c()
+    {
+        static const bool available = detectInstructionSet() >= InstructionSet::avx2;
+        return available;
+    }
+
+    AM_TARGET_F16C static void decodeF16c(const Sample* source, float* dest, int numSamples)
+    {
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(halves));
+        }
+        if (i < numSamples)                                                 //the last few through a padded vector
+        {
+            alignas(16) Sample halves[8] = {};
+            alignas(32) float values[8];
+            std::copy(source + i, source + numSamples, halves);
+            _mm256_store_ps(values, _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(halves))));
+            std::copy(values, values + (numSamples - i), dest + i);
+        }
+    }
+
+    AM_TARGET_F16C static void encodeF16c(const float* source, Sample* dest, int numSamples)
+    {
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), halves);
+        }
+        if (i < numSamples)
+        {
+            alignas(32) float values[8] = {};
+            alignas(16) Sample halves[8];
+            std::copy(source + i, source + numSamples, values);
+            _mm_store_si128(reinterpret_cast<__m128i*>(halves), _mm256_cvtps_ph(_mm256_load_ps(values), _MM_FROUND_TO_NEAREST_INT));
+            std::copy(halves, halves + (numSamples - i), dest + i);
+        }
+    }
+#endif
+};
+
+struct Int16Storage
+{
+    using Sample = int16_t;
+    static constexpr bool readsInPlace = false;
+    static constexpr uint32_t snapshotId = 2;
+
+    static float decode(Sample sample)
+    {
+        return float(sample) * (1.0f / 32768.0f);
+    }
+
+    ///rounds to 16 bits with triangular dither. The dither comes from a hash of position (the number of samples
+    ///written so far), so a block gives the same samples as writing them one at a time.
+    static Sample encode(float value, uint32_t position)
+    {
+        //offset to [0, 65535] so truncating rounds to nearest, then back. Clamping after the offset lets the span loop
+        //below vectorize (clamping first and then adding makes GCC branch). 0 goes first in max() so NaN becomes 0.
+        const float offset = std::min(std::max(0.0f, value * 32768.0f + dither(position) + 32768.5f), 65535.0f);
+        return Sample(int(offset) - 32768);
+    }
+
+    static void decode(const Sample* source, float* dest, int numSamples)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            dest[i] = decode(source[i]);
+        }
+    }
+
+    static void encode(const float* source, Sample* dest, int numSamples, uint32_t position)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            dest[i] = encode(source[i], position + uint32_t(i));
+        }
+    }
+
+private:
+    ///triangular noise in (-1, 1) steps: the difference of two uniform numbers taken from one 32 bit hash
+    static float dither(uint32_t position)
+    {
+        uint32_t hash = position;
+        hash ^= hash >> 16;
+        hash *= 0x7feb352du;
+        hash ^= hash >> 15;
+        hash *= 0x846ca68bu;
+        hash ^= hash >> 16;
+        return float(int(hash & 0xffffu) - int(hash >> 16)) * (1.0f / 65536.0f);
+    }
+};
+
+/**
+*The delay core used by DoubleCombFilter and MultiTapDelay: a circular buffer whose size is a power of two, so every
+*index wraps with a single AND instead of a compare and subtract. Samples are stored as Storage::Sample (see above);
+*DelayLine is the plain float one.
+*
+*Reads happen through Taps, which hold the delay as a whole number of samples plus a fraction, so each read is two
+*neighbouring samples and one linear interpolation. Every index is masked, so a read can never leave the buffer.
+*
+*For block processing, contiguousSpan() says how many samples a tap can be read as a plain array (no wrap and no overlap
+*with the samples about to be written), which lets the caller run simple loops the compiler can vectorize.
+*
+*@tparam Float32Storage, Float16Storage or Int16Storage
+*/
+template <class Storage>
+class BasicDelayLine
+{
+public:
+    using Sample = typename Storage::Sample;
+
+    ///longest span readSpan() converts at once, so callers can size their scratch arrays (maxReadSpan + 1 floats)
+    static constexpr int maxReadSpan = Storage::readsInPlace ? INT_MAX : 256;
+
+    ///a read position at a fixed delay behind the write position
+    struct Tap
+    {
+        int offset = 1;             //whole samples behind the write position of the older of the two samples read
+        float fraction = 1.0f;      //weight of the newer of the two samples
+    };
+
+    ///allocate and clear the buffer so it can hold at least maxDelaySamples of delay
+    void setMaxDelaySamples(int maxDelaySamples)
+    {
+        int newSize = 1;
+        while (newSize < maxDelaySamples + 2)       //room for the delay plus the interpolation neighbour
+        {
+            newSize *= 2;
+        }
+
+        buffer.assign(newSize, Storage::encode(0.0f, 0));
+        mask = newSize - 1;
+        maxDelay = std::max(0, maxDelaySamples);
+        writeIndex = 0;
+        written = 0;
+    }
+
+    ///longest delay (in samples) a tap can have
+    int getMaxDelaySamples() const
+    {
+        return maxDelay;
+    }
+
+    ///true once setMaxDelaySamples() has been called
+    bool isReady() const
+    {
+        return !buffer.empty();
+    }
+
+    ///fill the buffer with silence
+    void clear()
+    {
+        std::fill(buffer.begin(), buffer.end(), Storage::encode(0.0f, 0));
+    }
+
+    ///make a tap for a delay in samples, clamped to [0, max delay]
+    Tap makeTap(float delaySamples) const
+    {
+        delaySamples = std::min(std::max(delaySamples, 0.0f), float(maxDelay));
+
+        const int whole = int(delaySamples);
+        Tap tap;
+        tap.offset = whole + 1;
+        tap.fraction = 1.0f - (delaySamples - whole);
+        return tap;
+    }
+
+    ///interpolated read at a tap
+    float read(const Tap& tap) const
+    {
+        const int indexOne = (writeIndex - tap.offset) & mask;
+        const int indexTwo = (indexOne + 1) & mask;
+        return interpolate(Storage::decode(buffer[indexOne]), Storage::decode(buffer[indexTwo]), tap.fraction);
+    }
+
+    ///store a sample at the write position and move on
+    void write(float input)
+    {
+        buffer[writeIndex] = Storage::encode(input, written++);
+        writeIndex = (writeIndex + 1) & mask;
+    }
+
+    ///linear interpolation between two neighbouring samples, shared by the scalar and block paths so they always agree
+    static float interpolate(float valOne, float valTwo, float fraction)
+    {
+        return (1 - fraction) * valOne + fraction * valTwo;
+    }
+
+
+    //Block Functions
+
+    /**
+    *how many samples from now a tap can be read as a contiguous array: neither the tap (and its neighbour) nor the
+    *write position wrap, and none of the samples read were written inside the span. Can be 0, in which case the caller
+    *should do a single sample with read()/write().
+    */
+    int contiguousSpan(const Tap& tap) const
+    {
+        const int readStart = (writeIndex - tap.offset) & mask;
+        const int noWrap = mask - readStart;                                //keeps readStart + span within the buffer
+        const int noOverlap = tap.offset > 1 ? tap.offset - 1 : 0;          //keeps reads behind the samples being written
+        const int noLapping = mask - tap.offset;                            //keeps the writes short of the oldest sample read
+        return std::min({ noWrap, noOverlap, noLapping });
+    }
+
+    ///samples that can be written before the write position wraps
+    int writableSpan() const
+    {
+        return mask + 1 - writeIndex;
+    }
+
+    /**
+    *the samples a tap reads over the next numSamples as floats: numSamples + 1 of them, from the older sample of the
+    *first read. numSamples must be no more than contiguousSpan(tap) or maxReadSpan. Float storage returns the buffer
+    *itself; the others convert into scratch (which must hold numSamples + 1 floats) and return that.
+    */
+    const float* readSpan(const Tap& tap, int numSamples, float* scratch) const
+    {
+        const Sample* first = buffer.data() + ((writeIndex - tap.offset) & mask);
+
+        if constexpr (Storage::readsInPlace)
+        {
+            return first;
+        }
+        else
+        {
+            Storage::decode(first, scratch, numSamples + 1);
+            return scratch;
+        }
+    }
+
+    ///copy a block into the buffer (numSamples must be no more than writableSpan()) and move on
+    void writeBlock(const float* input, int numSamples)
+    {
+        Storage::encode(input, buffer.data() + writeIndex, numSamples, written);
+        writeIndex = (writeIndex + numSamples) & mask;
+        written += uint32_t(numSamples);
+    }
+
+    /**
+    *saves or restores the buffer contents and write position (see am_Snapshot.h). The samples are stored as they are,
+    *so a snapshot only restores into a delay line with the same Storage. A restore that fails leaves the line empty.
+    */
+    template <class Archive>
+    void serialise(Archive& archive)
+    {
+        uint32_t format = Storage::snapshotId;
+        archive.value(format);
+        archive.check(format == Storage::snapshotId);
+        archive.array(buffer);
+        archive.value(maxDelay);
+        archive.value(writeIndex);
+        archive.value(written);
+
+        if (Archive::loading)
+        {
+            const size_t size = buffer.size();
+            const bool powerOfTwo = size <= size_t(INT_MAX) && (size & (size - 1)) == 0;
+
+            const bool valid = powerOfTwo && maxDelay >= 0 && size_t(maxDelay) + 2 <= size && writeIndex >= 0 && size_t(writeIndex) < size;
+
+            if (archive.check(valid || size == 0) && size > 0)
+            {
+                mask = int(size) - 1;
+            }
+            else
+            {
+                buffer.clear();                     //not set up when it was saved, or the restore failed
+                mask = 0;
+                maxDelay = 0;
+                writeIndex = 0;
+            }
+        }
+    }
+
+private:
+    std::vector<Sample> buffer;     //stores delay data, size is a power of two
+    int mask = 0;                   //size - 1
+    int maxDelay = 0;               //longest delay in samples
+    int writeIndex = 0;             //write position
+    uint32_t written = 0;           //samples written so far (wrapping), which picks the dither
+};
+
+using DelayLine = BasicDelayLine<Float32Storage>;
@@ -1,214 +1,683 @@
-//Can be altered to create a chorus class
-
-/*
-  ==============================================================================
-
-    am_DoubleCombFilter.h
-    Created: 10 Dec 2022 12:01:20am
-    Author:  Andrew McGillivray
-
-  ==============================================================================
-*/
-#pragma once
-
-
-class DoubleCombFilter
-{
-    
-public:
-
-    //destructor
-    ~DoubleCombFilter()
-    {
-        if (delayLine != nullptr)
-        {
-            delete[] delayLine;
-        }
-    }
-    
-    /// set the sample rate (Hz)
-    void setSampleRate(float sampleRateIn)
-    {
-        sampleRate = sampleRateIn;
-    }
-
-    ///set the maximum size of the delay line
-    void setMaxDelay(int maxDelayIn)
-    {
-        maxLength = maxDelayIn * sampleRate;             
-        
-        //free up data
-        if (delayLine != nullptr)
-            delete[] delayLine;
-        
-        delayLine = new float[maxLength]; //create array
-        
-        //initialise array
-        for (int i=0; i<maxLength; i++)
-        {
-            delayLine[i] = 0.0;
-        }
-    }
-    
-    
-    ///set the delay time in seconds
-    void setDelayTimes(float delayTimeOneIn, float delayTimeTwoIn)
-    {
-        delayTimeOne = delayTimeOneIn * sampleRate;
-        delayTimeTwo = delayTimeTwoIn * sampleRate;
-        
-        // set read indexes
-        readIndexOne = writeIndex - delayTimeOne;
-        readIndexTwo = writeIndex - delayTimeTwo;
-        
-        if (readIndexOne < 0)
-        {
-            readIndexOne = readIndexOne + maxLength;
-        }
-
-        if (readIndexTwo < 0)
-        {
-            readIndexTwo = readIndexTwo + maxLength;
-        }
-        
-    }
-    
-    ///use delay line
-    float process(float input)
-    {
-
-        // read in current value
-        float outputSampleOne = linearInterpolationOne();
-        float outputSampleTwo = linearInterpolationTwo();
-
-        float outputSampleTotal = input + (outputSampleOne * feedbackOne) + (outputSampleTwo * feedbackTwo);
-
-        // store value in delay line
-        delayLine[writeIndex] = input;
-
-
-        // find next read and write values;
-        readIndexOne += 1;
-        if (readIndexOne >= maxLength)
-        {
-            readIndexOne -= maxLength;
-        }
-
-        readIndexTwo += 1;
-        if (readIndexTwo >= maxLength)
-        {
-            readIndexTwo -= maxLength;
-        }
-
-        writeIndex += 1;
-        if (writeIndex >= maxLength)
-        {
-            writeIndex -= maxLength;
-        }
-
-        return outputSampleTotal;
-
-    }
-    
-    ///uses linear interpolation to find the correct sample
-    float linearInterpolationOne()
-    {  
-        //find relevant indexes
-        int indexOne = int(readIndexOne);        // e.g. 2
-        int indexTwo = indexOne + 1;            // e.g. 3
-        
-        //failsafe on index two
-        if (indexTwo > maxLength)
-        {
-            indexTwo -= maxLength;
-        }
-        
-        //read values
-        float valOne = delayLine[indexOne];          // e.g. data[2]
-        float valTwo = delayLine[indexTwo];          // e.g. data[3]
-        
-        // calculate difference
-        float difference = readIndexOne - indexOne;   // e.g. 2.3 - 2 = 0.3
-        
-        // work out interpolated sample between two indexes
-        float interpolatedSample = (1 - difference) * valOne + difference * valTwo;
-        
-        
-        return interpolatedSample;
-    }
-
-    ///uses linear interpolation to find the correct sample
-    float linearInterpolationTwo()
-    {
-        //find relevant indexes
-        int indexOne = int(readIndexTwo);        // e.g. 2
-        int indexTwo = indexOne + 1;            // e.g. 3
-
-        //failsafe on index two
-        if (indexTwo > maxLength)
-        {
-            indexTwo -= maxLength;
-        }
-
-        //read values
-        float valOne = delayLine[indexOne];          // e.g. data[2]
-        float valTwo = delayLine[indexTwo];          // e.g. data[3]
-
-        // calculate difference
-        float difference = readIndexTwo - indexOne;   // e.g. 2.3 - 2 = 0.3
-
-        // work out interpolated sample between two indexes
-        float interpolatedSample = (1 - difference) * valOne + difference * valTwo;
-
-
-        return interpolatedSample;
-    }
-    
-    ///sets the feedback in the interval [0, 1]
-    void setFeedback(float feedbackInOne, float feedbackInTwo)
-    {
-        feedbackOne = feedbackInOne;
-        feedbackTwo = feedbackInTwo;
-
-        //failsafes
-        if (feedbackOne < 0)
-        {
-            feedbackOne = 0;
-        }
-        if (feedbackOne > 1.0)
-        {
-            feedbackOne = 1.0;
-        }
-
-        if (feedbackTwo < 0)
-        {
-            feedbackTwo = 0;
-        }
-        if (feedbackTwo > 1.0)
-        {
-            feedbackTwo = 1.0;
-        }
-    }
-    
-    
-    
-    
-private:
-    
-    float readIndexOne = 0;  //read position 1
-    float readIndexTwo = 0;  //read position 2
-    int writeIndex = 0; //write position
-    
-    int maxLength;           //maximum possible delay time
-    
-    float* delayLine = nullptr;  //stores delay data
-    
-    //delay times
-    int delayTimeOne;  
-    int delayTimeTwo;
-    
-    
-    float feedbackOne = 0.5;     //must be in [0, 1]
-    float feedbackTwo = 0.5;     //must be in [0, 1]
-    float sampleRate;
-};
+//Can be altered to create a chorus class
+
+/*
+  ==============================================================================
+
+    am_DoubleCombFilter.h
+    Created: 10 Dec 2022 12:01:20am
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_DelayLine.h"
+#include "am_Denormals.h"
+#include "am_ParameterRamp.h"
+#include "am_Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+
+/**
+*Two comb filters reading from one shared delay line: output = input + feedbackOne * (input delayed by time one)
+*+ feedbackTwo * (input delayed by time two).
+*
+*The delay line is a power-of-two ring buffer (see am_DelayLine.h) with masked indexes and integer plus fractional read
+*positions, so reads can never go out of bounds and the block functions run over plain contiguous spans. Storage picks
+*how it keeps its samples: DoubleCombFilter is the float one, BasicDoubleCombFilter<Float16Storage> and
+*BasicDoubleCombFilter<Int16Storage> use half the memory. Only what goes through the delay line is quantised; the dry
+*input in the output is untouched.
+*
+*Resizing: setMaxDelay() allocates, so only call it while audio is stopped (e.g. in prepareToPlay). To change the
+*size or sample rate while audio is running, call prepareMaxDelay() from a background thread instead. The audio thread
+*swaps the new buffer in at the start of its next block without locking or allocating, and the old buffer is freed back
+*on the background thread by the next prepareMaxDelay() or releaseRetiredBuffer().
+*
+*Silence: the filter tracks how long its input has been below a threshold. Once that is longer than the longest delay,
+*everything in the delay line it can read is below the threshold too, so it bypasses itself (output = input, nothing
+*read or written) until a louder sample arrives. The block functions also flush denormals to 0 while they run (see
+*am_Denormals.h), which process() does not; apart from denormal values the two give the same samples.
+*
+*@tparam Float32Storage, Float16Storage or Int16Storage
+*/
+template <class Storage>
+class BasicDoubleCombFilter
+{
+    using Line = BasicDelayLine<Storage>;
+    
+public:
+
+    BasicDoubleCombFilter() = default;
+
+    ///copies the settings and delay line contents. A resize that has not been picked up yet is not copied.
+    BasicDoubleCombFilter(const BasicDoubleCombFilter& other)
+    {
+        copySettingsFrom(other);
+    }
+
+    BasicDoubleCombFilter(BasicDoubleCombFilter&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    BasicDoubleCombFilter& operator=(const BasicDoubleCombFilter& other)
+    {
+        if (this != &other)
+        {
+            copySettingsFrom(other);
+        }
+        return *this;
+    }
+
+    BasicDoubleCombFilter& operator=(BasicDoubleCombFilter&& other) noexcept
+    {
+        if (this != &other)
+        {
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    //destructor
+    ~BasicDoubleCombFilter()
+    {
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+    }
+    
+    /// set the sample rate (Hz)
+    void setSampleRate(float sampleRateIn)
+    {
+        sampleRate = sampleRateIn;
+        updateTaps();
+    }
+
+    ///set the maximum size of the delay line in seconds. Allocates: not for use while audio is running.
+    void setMaxDelay(int maxDelayIn)
+    {
+        delayLine.setMaxDelaySamples(int(maxDelayIn * sampleRate));
+        updateTaps();
+    }
+
+    /**
+    *real-time safe resize: builds a new (silent) delay line for a new maximum delay and sample rate on the calling
+    *thread, which must not be the audio thread. The audio thread adopts it at the start of its next process call.
+    *Only one thread should call this at a time.
+    *@param maximum delay in seconds
+    *@param sample rate in Hz the new delay line will run at
+    */
+    void prepareMaxDelay(int maxDelayIn, float sampleRateIn)
+    {
+        releaseRetiredBuffer();
+
+        PendingBuffer* fresh = new PendingBuffer();
+        fresh->sampleRate = sampleRateIn;
+        fresh->line.setMaxDelaySamples(int(maxDelayIn * sampleRateIn));
+
+        delete pending.exchange(fresh, std::memory_order_acq_rel);     //an earlier request the audio thread never picked up
+    }
+
+    ///frees the buffer the audio thread swapped out. Call from a background thread (prepareMaxDelay() also does this).
+    void releaseRetiredBuffer()
+    {
+        delete retired.exchange(nullptr, std::memory_order_acq_rel);
+    }
+    
+    
+    ///set the delay time in seconds
+    void setDelayTimes(float delayTimeOneIn, float delayTimeTwoIn)
+    {
+        delayTimeOne = delayTimeOneIn;
+        delayTimeTwo = delayTimeTwoIn;
+        updateTaps();
+    }
+    
+    ///use delay line
+    float process(float input)
+    {
+        adoptPendingBuffer();
+        return processSample(input);
+    }
+
+    /**
+    *set how quiet the input must be to count as silence for the bypass (see the class description)
+    *@param threshold as an absolute sample value, 0 to never bypass
+    */
+    void setTailThreshold(float threshold)
+    {
+        tailThreshold = threshold;
+    }
+
+    ///true while the filter is bypassing itself because its input and delay line are silent
+    bool isBypassed() const
+    {
+        return delayLine.isReady() && silentRun >= tailSamples;
+    }
+
+    ///how many of the latest input samples the output can depend on. Running a filter fresh from reset() over at least
+    ///this much input (of a stretch that is not bypassed) leaves it giving the same output as one that saw everything.
+    int getTailSamples() const
+    {
+        return tailSamples;
+    }
+
+    ///empties the delay line, as if nothing had gone through the filter yet. Settings and feedback ramps are kept.
+    void reset()
+    {
+        delayLine.clear();
+        silentRun = 0;
+    }
+
+    ///use delay line on a block of samples, writing into out. Gives process()'s samples on each input, apart from denormals (see above).
+    void processBlock(const float* input, float* out, int numSamples)
+    {
+        adoptPendingBuffer();
+        render<false>(input, out, numSamples);
+    }
+
+    ///use delay line on a block of samples in place
+    void processBlock(float* buffer, int numSamples)
+    {
+        adoptPendingBuffer();
+        render<false>(buffer, buffer, numSamples);
+    }
+
+    ///use delay line on a block of samples, adding the result on top of out (out[i] += process(input[i]))
+    void processBlockAdd(const float* input, float* out, int numSamples)
+    {
+        adoptPendingBuffer();
+        render<true>(input, out, numSamples);
+    }
+    
+    ///uses linear interpolation to find the delayed sample for comb one
+    float linearInterpolationOne()
+    {
+        return delayLine.read(tapOne);
+    }
+
+    ///uses linear interpolation to find the delayed sample for comb two
+    float linearInterpolationTwo()
+    {
+        return delayLine.read(tapTwo);
+    }
+    
+    ///sets the feedback in the interval [0, 1]
+    void setFeedback(float feedbackInOne, float feedbackInTwo)
+    {
+        feedbackOne = feedbackInOne;
+        feedbackTwo = feedbackInTwo;
+
+        //failsafes
+        if (feedbackOne < 0)
+        {
+            feedbackOne = 0;
+        }
+        if (feedbackOne > 1.0)
+        {
+            feedbackOne = 1.0;
+        }
+
+        if (feedbackTwo < 0)
+        {
+            feedbackTwo = 0;
+        }
+        if (feedbackTwo > 1.0)
+        {
+            feedbackTwo = 1.0;
+        }
+
+        feedbackRampOne.setCurrent(feedbackOne);
+        feedbackRampTwo.setCurrent(feedbackTwo);
+        feedbackRamping = false;
+    }
+
+    /**
+    *move both feedback values to new targets over a number of samples, one step per sample inside the block loop
+    *@param feedback value for delay 1 to reach, clamped to [0, 1]
+    *@param feedback value for delay 2 to reach, clamped to [0, 1]
+    *@param length of the ramp in samples
+    *@param RampShape::linear or RampShape::exponential
+    */
+    void rampFeedback(float targetOne, float targetTwo, int numSamples, RampShape shape = RampShape::linear)
+    {
+        feedbackRampOne.setCurrent(feedbackOne);
+        feedbackRampTwo.setCurrent(feedbackTwo);
+        feedbackRampOne.rampTo(std::min(std::max(targetOne, 0.0f), 1.0f), numSamples, shape);
+        feedbackRampTwo.rampTo(std::min(std::max(targetTwo, 0.0f), 1.0f), numSamples, shape);
+
+        feedbackOne = feedbackRampOne.getCurrent();
+        feedbackTwo = feedbackRampTwo.getCurrent();
+        feedbackRamping = feedbackRampOne.isRamping() || feedbackRampTwo.isRamping();
+    }
+
+    ///the settings a GUI changes, as one set that can be handed to the audio thread whole (see am_ParameterExchange.h)
+    struct Parameters
+    {
+        float delayTimeOne = 0.0f;      //seconds
+        float delayTimeTwo = 0.0f;
+        float feedbackOne = 0.5f;       //clamped to [0, 1]
+        float feedbackTwo = 0.5f;
+    };
+
+    ///applies a whole set as setDelayTimes() and setFeedback() do, so a feedback ramp stops. Does not allocate. The
+    ///taps are only moved if the delay times changed, so the silence bypass is not reset by every feedback change.
+    void setParameters(const Parameters& parameters)
+    {
+        if (parameters.delayTimeOne != delayTimeOne || parameters.delayTimeTwo != delayTimeTwo)
+        {
+            setDelayTimes(parameters.delayTimeOne, parameters.delayTimeTwo);
+        }
+        setFeedback(parameters.feedbackOne, parameters.feedbackTwo);
+    }
+
+    ///the current set (targets, for a feedback ramp that is still moving)
+    Parameters getParameters() const
+    {
+        Parameters parameters;
+        parameters.delayTimeOne = delayTimeOne;
+        parameters.delayTimeTwo = delayTimeTwo;
+        parameters.feedbackOne = feedbackRamping ? feedbackRampOne.getTarget() : feedbackOne;
+        parameters.feedbackTwo = feedbackRamping ? feedbackRampTwo.getTarget() : feedbackTwo;
+        return parameters;
+    }
+
+    static constexpr char snapshotTag[5] = "DCMB";
+
+    /**
+    *saves or restores the settings, the feedback ramps and the whole delay line, so a restored filter carries on with
+    *the same echoes (see am_Snapshot.h). Restoring allocates, so only do it while audio is stopped.
+    *@param SnapshotWriter or SnapshotReader
+    */
+    template <class Archive>
+    void serialise(Archive& archive)
+    {
+        delayLine.serialise(archive);
+        archive.value(delayTimeOne);
+        archive.value(delayTimeTwo);
+        archive.value(feedbackOne);
+        archive.value(feedbackTwo);
+        archive.value(sampleRate);
+        archive.value(tailThreshold);
+        feedbackRampOne.serialise(archive);
+        feedbackRampTwo.serialise(archive);
+
+        int run = silentRun;
+        archive.value(run);
+
+        if (Archive::loading)
+        {
+            updateTaps();
+            silentRun = std::min(std::max(run, 0), tailSamples);
+            feedbackRamping = feedbackRampOne.isRamping() || feedbackRampTwo.isRamping();
+        }
+    }
+
+
+    
+    
+private:
+
+    ///a delay line built off the audio thread, waiting to be swapped in
+    struct PendingBuffer
+    {
+        Line line;
+        float sampleRate = 44100.0f;
+    };
+
+    ///one sample through the delay line, keeping track of silence for the bypass
+    float processSample(float input)
+    {
+        if (feedbackRamping)
+        {
+            advanceFeedback();
+        }
+
+        if (!delayLine.isReady())
+        {
+            return input;
+        }
+
+        const bool quiet = std::fabs(input) < tailThreshold;
+        if (quiet && silentRun >= tailSamples)
+        {
+            return input;                                   //bypassed
+        }
+        silentRun = quiet ? std::min(silentRun + 1, tailSamples) : 0;
+
+        return combSample(input);
+    }
+
+    ///the filter itself: read both taps, write the input
+    float combSample(float input)
+    {
+        // read in current value
+        float outputSampleOne = linearInterpolationOne();
+        float outputSampleTwo = linearInterpolationTwo();
+
+        float outputSampleTotal = input + (outputSampleOne * feedbackOne) + (outputSampleTwo * feedbackTwo);
+
+        // store value in delay line and move on
+        delayLine.write(input);
+
+        return outputSampleTotal;
+    }
+
+    ///audio thread: swap in a buffer from prepareMaxDelay() if there is one. Never allocates or frees; if the last
+    ///swapped-out buffer has not been released yet it simply waits for a later block.
+    void adoptPendingBuffer()
+    {
+        if (pending.load(std::memory_order_relaxed) == nullptr || retired.load(std::memory_order_acquire) != nullptr)
+        {
+            return;
+        }
+
+        PendingBuffer* fresh = pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (fresh == nullptr)
+        {
+            return;
+        }
+
+        std::swap(delayLine, fresh->line);              //swaps the vectors' pointers, no copying
+        std::swap(sampleRate, fresh->sampleRate);
+        updateTaps();
+
+        retired.store(fresh, std::memory_order_release);
+    }
+
+    ///recalculates the read taps after the delay times, sample rate or the buffer size change
+    void updateTaps()
+    {
+        tapOne = delayLine.makeTap(delayTimeOne * sampleRate);
+        tapTwo = delayLine.makeTap(delayTimeTwo * sampleRate);
+        tailSamples = std::max(tapOne.offset, tapTwo.offset) + 1;     //every sample either tap can read
+        silentRun = 0;                                                  //the delay line has to be checked again for the new taps
+    }
+
+    void copySettingsFrom(const BasicDoubleCombFilter& other)
+    {
+        delayLine = other.delayLine;
+        tapOne = other.tapOne;
+        tapTwo = other.tapTwo;
+        delayTimeOne = other.delayTimeOne;
+        delayTimeTwo = other.delayTimeTwo;
+        feedbackOne = other.feedbackOne;
+        feedbackTwo = other.feedbackTwo;
+        feedbackRampOne = other.feedbackRampOne;
+        feedbackRampTwo = other.feedbackRampTwo;
+        feedbackRamping = other.feedbackRamping;
+        sampleRate = other.sampleRate;
+        tailThreshold = other.tailThreshold;
+        tailSamples = other.tailSamples;
+        silentRun = other.silentRun;
+    }
+
+    void moveFrom(BasicDoubleCombFilter& other)
+    {
+        delayLine = std::move(other.delayLine);
+        tapOne = other.tapOne;
+        tapTwo = other.tapTwo;
+        delayTimeOne = other.delayTimeOne;
+        delayTimeTwo = other.delayTimeTwo;
+        feedbackOne = other.feedbackOne;
+        feedbackTwo = other.feedbackTwo;
+        feedbackRampOne = other.feedbackRampOne;
+        feedbackRampTwo = other.feedbackRampTwo;
+        feedbackRamping = other.feedbackRamping;
+        sampleRate = other.sampleRate;
+        tailThreshold = other.tailThreshold;
+        tailSamples = other.tailSamples;
+        silentRun = other.silentRun;
+
+        delete pending.exchange(other.pending.exchange(nullptr));
+        delete retired.exchange(other.retired.exchange(nullptr));
+    }
+
+    ///block version of process(). Splits the block into bypassed parts and parts that go through the filter, at the
+    ///same samples process() would switch.
+    template <bool Add>
+    void render(const float* input, float* out, int numSamples)
+    {
+        AM_PROFILE_MODULE(ProfiledModule::doubleCombFilter, numSamples);
+        ScopedFlushDenormals noDenormals;
+
+        if (!delayLine.isReady())
+        {
+            renderFiltered<Add>(input, out, numSamples);
+            return;
+        }
+
+        while (numSamples > 0)
+        {
+            int part = isBypassed() ? quietSpan(input, numSamples) : 0;
+
+            if (part > 0)
+            {
+                renderBypassed<Add>(input, out, part);
+            }
+            else
+            {
+                part = samplesUntilBypass(input, numSamples);
+                renderFiltered<Add>(input, out, part);
+            }
+
+            input += part;
+            out += part;
+            numSamples -= part;
+        }
+    }
+
+    ///number of samples at the start of input that are below the tail threshold
+    int quietSpan(const float* input, int numSamples) const
+    {
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)                          //16 at a time, which vectorizes
+        {
+            int quiet = 0;
+            for (int k = 0; k < 16; k++)
+            {
+                quiet += std::fabs(input[i + k]) < tailThreshold ? 1 : 0;
+            }
+            if (quiet < 16)
+            {
+                break;
+            }
+        }
+        while (i < numSamples && std::fabs(input[i]) < tailThreshold)
+        {
+            i++;
+        }
+        return i;
+    }
+
+    ///how many samples go through the filter before the bypass starts (all of them if it does not), updating silentRun
+    int samplesUntilBypass(const float* input, int numSamples)
+    {
+        int quiet = 0;
+        for (int i = 0; i < numSamples; i++)                          //vectorizes, unlike the scan below
+        {
+            quiet += std::fabs(input[i]) < tailThreshold ? 1 : 0;
+        }
+
+        if (silentRun + quiet < tailSamples)                           //too few quiet samples to reach the bypass
+        {
+            if (quiet == numSamples)
+            {
+                silentRun += quiet;
+            }
+            else
+            {
+                silentRun = numSamples - 1;
+                while (std::fabs(input[silentRun]) < tailThreshold)
+                {
+                    silentRun--;
+                }
+                silentRun = numSamples - 1 - silentRun;                 //quiet samples after the last loud one
+            }
+            return numSamples;
+        }
+
+        int run = silentRun;
+        for (int i = 0; i < numSamples; i++)
+        {
+            run = std::fabs(input[i]) < tailThreshold ? std::min(run + 1, tailSamples) : 0;
+            if (run >= tailSamples)
+            {
+                silentRun = run;
+                return i + 1;
+            }
+        }
+        silentRun = run;
+        return numSamples;
+    }
+
+    ///output = input while bypassed. The feedback ramps still move on.
+    template <bool Add>
+    void renderBypassed(const float* input, float* out, int numSamples)
+    {
+        for (int i = 0; i < numSamples && feedbackRamping; i++)
+        {
+            advanceFeedback();
+        }
+
+        if (Add)
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                out[i] += input[i];
+            }
+        }
+        else if (out != input)
+        {
+            std::copy(input, input + numSamples, out);
+        }
+    }
+
+    ///the filter over a block. Works through it in spans where neither tap nor the write position wraps, so the inner
+    ///loop is plain array arithmetic the compiler can vectorize.
+    template <bool Add>
+    void renderFiltered(const float* input, float* out, int numSamples)
+    {
+        if (feedbackRamping && numSamples > 0)
+        {
+            const int rampPart = std::min(numSamples, std::max(feedbackRampOne.getRemainingSamples(), feedbackRampTwo.getRemainingSamples()));
+            renderBlock<Add, true>(input, out, rampPart);
+            input += rampPart;
+            out += rampPart;
+            numSamples -= rampPart;
+        }
+
+        if (numSamples > 0)
+        {
+            renderBlock<Add, false>(input, out, numSamples);
+        }
+    }
+
+    ///moves the feedback ramps on one sample
+    void advanceFeedback()
+    {
+        feedbackOne = feedbackRampOne.next();
+        feedbackTwo = feedbackRampTwo.next();
+        feedbackRamping = feedbackRampOne.isRamping() || feedbackRampTwo.isRamping();
+    }
+
+    template <bool Add, bool Ramping>
+    void renderBlock(const float* input, float* out, int numSamples)
+    {
+        if (!delayLine.isReady())
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                if (Ramping)
+                {
+                    advanceFeedback();
+                }
+                out[i] = Add ? out[i] + input[i] : input[i];
+            }
+            return;
+        }
+
+        float fbOne = feedbackOne;
+        float fbTwo = feedbackTwo;
+        const float fractionOne = tapOne.fraction;
+        const float fractionTwo = tapTwo.fraction;
+
+        //converted samples, for storage that cannot be read in place
+        float scratchOne[Storage::readsInPlace ? 1 : Line::maxReadSpan + 1];
+        float scratchTwo[Storage::readsInPlace ? 1 : Line::maxReadSpan + 1];
+
+        int done = 0;
+        while (done < numSamples)
+        {
+            const int span = std::min({ numSamples - done, delayLine.writableSpan(), Line::maxReadSpan,
+                                        delayLine.contiguousSpan(tapOne), delayLine.contiguousSpan(tapTwo) });
+
+            if (span < 1)
+            {
+                //a tap is about to wrap (or is less than two samples long): do one sample the ordinary way
+                if (Ramping && feedbackRamping)
+                {
+                    advanceFeedback();
+                }
+                const float outputSample = combSample(input[done]);
+                out[done] = Add ? out[done] + outputSample : outputSample;
+                fbOne = feedbackOne;
+                fbTwo = feedbackTwo;
+                done += 1;
+                continue;
+            }
+
+            //none of the samples read in this span are written in it, so the input can go in first (this also makes in place safe)
+            const float* tapOneData = delayLine.readSpan(tapOne, span, scratchOne);
+            const float* tapTwoData = delayLine.readSpan(tapTwo, span, scratchTwo);
+            const float* in = input + done;
+            delayLine.writeBlock(in, span);
+
+            float* dest = out + done;
+            for (int i = 0; i < span; i++)
+            {
+                if constexpr (Ramping)
+                {
+                    advanceFeedback();
+                    fbOne = feedbackOne;
+                    fbTwo = feedbackTwo;
+                }
+
+                const float outputSampleOne = Line::interpolate(tapOneData[i], tapOneData[i + 1], fractionOne);
+                const float outputSampleTwo = Line::interpolate(tapTwoData[i], tapTwoData[i + 1], fractionTwo);
+                const float outputSampleTotal = in[i] + (outputSampleOne * fbOne) + (outputSampleTwo * fbTwo);
+                dest[i] = Add ? dest[i] + outputSampleTotal : outputSampleTotal;
+            }
+
+            done += span;
+        }
+    }
+
+    Line delayLine;                 //stores delay data
+    typename Line::Tap tapOne;      //read position 1
+    typename Line::Tap tapTwo;      //read position 2
+    
+    //delay times in seconds
+    float delayTimeOne = 0;
+    float delayTimeTwo = 0;
+    
+    
+    float feedbackOne = 0.5;     //must be in [0, 1]
+    float feedbackTwo = 0.5;     //must be in [0, 1]
+    float sampleRate = 44100.0f;
+
+    float tailThreshold = 1.0e-6f;  //input below this (-120dB) counts as silence
+    int tailSamples = 2;            //samples of silence needed before the delay line is silent too
+    int silentRun = 0;              //samples of silence so far, up to tailSamples
+
+    ParameterRamp feedbackRampOne;
+    ParameterRamp feedbackRampTwo;
+    bool feedbackRamping = false;
+
+    std::atomic<PendingBuffer*> pending { nullptr };   //built by prepareMaxDelay(), waiting for the audio thread
+    std::atomic<PendingBuffer*> retired { nullptr };   //swapped out by the audio thread, waiting to be freed
+};
+
+using DoubleCombFilter = BasicDoubleCombFilter<Float32Storage>;
\ No newline at end of file
@@ -1,119 +1,441 @@
-/*
-  ==============================================================================
-
-    am_Duration.h
-    Created: 28 Oct 2022 11:12:52am
-    Author:  Andrew McGillivray
-
-  ==============================================================================
-*/
-
-#pragma once
-#include "Oscillators.h"
-
-/**
-Duration Class
-*
-*Allows an input sound to be 'turned on' between chosen seconds in a decided window
-*Note: this allows gain to be 1.0dB when 'turned on' and 0.0dB when 'turned off'
-*/
-class DurationWave
-{
-public:
-
-	//Sets up a complete duration wave
-	void setUpDuration(float _sampleRate, float totalDurationInSeconds, float startValueInSeconds, float endValueInSeconds)
-	{
-		osc.setUp(_sampleRate, 1/totalDurationInSeconds, 0);
-		duration = totalDurationInSeconds;
-		start = startValueInSeconds / duration;
-		end = endValueInSeconds / duration;
-	}
-
-	/**
-	*set the sample rate for the duration wave
-	*@param sample rate of phasor in Hz. Must be matched with the class affected by the wave
-	*/
-	void setSampleRate(float _sampleRate)
-	{
-		osc.setSampleRate(_sampleRate);
-	}
-
-	/**
-	*Choose the length of piece (in seconds) the duration will be set in
-	*Note: a piece length shorter than what will be heard will result in repetition of the sound
-	*@param piece length in seconds
-	*/
-	void setPieceLength(float durationInSeconds)
-	{
-		duration = durationInSeconds;
-		osc.setFrequency(1 / durationInSeconds); //sets a phasor which will increase from 0 to 1 over the duration set
-	}
-
-	/**
-	*Choose when (in seconds) the start and end values within the piece length for which the sound will be heard
-	*@param start value in seconds
-	*@param end value in seconds
-	*/
-	void setWindow(float startValueInSeconds, float endValueInSeconds)
-	{
-		start = startValueInSeconds / duration;			 //a fraction between 0 and 1 which will be used to compare vs the phasor to start the sound
-		end = endValueInSeconds / duration;				 //a fraction between 0 and 1 which will be used to compare vs the phasor to end the sound
-	
-		
-	}
-
-	/**
-	*will give 1.0dB of gain when within the set window and 0.0dB elsewhere.
-	*/
-	float process()
-	{
-		sample = osc.process();									//starts the phasor on a ramp from 0 to 1.
-		if (sample >= start)									// if the phasor decimal reaches the start decimal
-		{	
-			fadeIn = fadeIn + 0.00005;							//a 0.5s short fadein to avoid clicks
-			outVal = fadeIn;									//outputs the fadein
-
-			if (fadeIn >= 1.0f)									//overwrites the fadein to stay at 1.0dB and not clip
-			{
-			    outVal = 1.0f;									//outputs a constant gain
-			}
-
-			if (sample >= end - 0.001)									//if the phasor reaches the end decimal
-			{
-				fadeOut = fadeOut - 0.00005;				//a 0.5s short fadeout to avoid clicks
-				outVal = fadeOut;								//outputs the fadeout
-				fadeIn = 0.0f;									//resets the fadein
-
-				if (fadeOut <= 0.0f)
-				{
-					outVal = 0.0f;								//keeps the gain at 0.0dB
-					
-				}
-			}
-		}
-		else
-		{
-			outVal = 0.0f;										//zero gain before start time
-		}
-
-		return outVal;											//return the gain
-	}
-
-private:
-	Oscillator osc;												//phasor to compare vs start/end times
-	float sample;												//value to compare against start/end times
-
-	//without initialising start and end times, the gain will always be 1.0dB
-	float start;										//failsafe on start time
-	float end;											//failsafe end time
-
-	float outVal;
-	float duration;												//length of piece
-	
-	float fadeIn = 0.0f;										//initalise fadein
-	float fadeOut = 1.0f;										//initialise fadeout
-	
-
-};
-
+/*
+  ==============================================================================
+
+    am_Duration.h
+    Created: 28 Oct 2022 11:12:52am
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "am_FixedPhase.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+Duration Class
+*
+*Allows an input sound to be 'turned on' between chosen seconds in a decided window
+*Note: this allows gain to be 1.0dB when 'turned on' and 0.0dB when 'turned off'
+*
+*The window is timed by a fixed-point phasor (see am_FixedPhase.h), so it stays sample-accurate over pieces hours long.
+*
+*Most of a piece is usually silent. getSilentSamplesAhead() works out from the window how many of the next samples will
+*be 0, so a render loop can skip the sources it gates for that long and call skipSamples() instead of process().
+*/
+class DurationWave
+{
+public:
+
+	//Sets up a complete duration wave
+	void setUpDuration(float _sampleRate, float totalDurationInSeconds, float startValueInSeconds, float endValueInSeconds)
+	{
+		sampleRate = _sampleRate;
+		duration = totalDurationInSeconds;
+		updateIncrement();
+		updateFadeStep();
+		start = double(startValueInSeconds) / duration;
+		end = double(endValueInSeconds) / duration;
+	}
+
+	/**
+	*set the sample rate for the duration wave
+	*@param sample rate of phasor in Hz. Must be matched with the class affected by the wave
+	*/
+	void setSampleRate(float _sampleRate)
+	{
+		sampleRate = _sampleRate;
+		updateIncrement();
+		updateFadeStep();
+	}
+
+	/**
+	*Choose the length of piece (in seconds) the duration will be set in
+	*Note: a piece length shorter than what will be heard will result in repetition of the sound
+	*@param piece length in seconds
+	*/
+	void setPieceLength(float durationInSeconds)
+	{
+		duration = durationInSeconds;
+		updateIncrement();										//sets a phasor which will increase from 0 to 1 over the duration set
+	}
+
+	/**
+	*Choose when (in seconds) the start and end values within the piece length for which the sound will be heard
+	*@param start value in seconds
+	*@param end value in seconds
+	*/
+	void setWindow(float startValueInSeconds, float endValueInSeconds)
+	{
+		start = double(startValueInSeconds) / duration;	 //a fraction between 0 and 1 which will be used to compare vs the phasor to start the sound
+		end = double(endValueInSeconds) / duration;		 //a fraction between 0 and 1 which will be used to compare vs the phasor to end the sound
+	
+		
+	}
+
+	/**
+	*Choose how long the fade in and fade out at the edges of the window take (0.5 seconds unless set)
+	*@param fade time in seconds
+	*/
+	void setFadeTime(float fadeTimeInSeconds)
+	{
+		fadeTime = fadeTimeInSeconds;
+		updateFadeStep();
+	}
+
+	/**
+	*how many of the next samples will certainly be silent (0 gain), because they are before the window or after the
+	*fade out. A render loop can skip whatever is gated for that long. Fade ins and outs are never counted as silent.
+	*@return number of silent samples from the next one on, 0 if the next sample is not silent
+	*/
+	int64_t getSilentSamplesAhead() const
+	{
+		const uint64_t increment = phasor.getIncrement();
+		uint64_t next = phasor.getValue() + increment;
+		int64_t silent = 0;
+
+		if (!isBeforeStart(next))
+		{
+			//after the end, silent once the fade out is over, until the phasor wraps round to the next piece
+			if (FixedPhase::toDouble(next) < end - 0.001 || fadeOut - fadeStep > 0.0f)
+			{
+				return 0;
+			}
+
+			silent = samplesUntilAtLeast(next, ~uint64_t(0), increment);
+			next += uint64_t(silent) * increment;
+
+			if (!isBeforeStart(next))
+			{
+				return silent;
+			}
+		}
+
+		if (start >= 1.0)													//the window never opens
+		{
+			return INT64_MAX;
+		}
+		return addClamped(silent, samplesUntilAtLeast(next, startThreshold(), increment));
+	}
+
+	/**
+	*moves on numSamples, leaving everything as if process() had been called numSamples times. Silent stretches
+	*(see getSilentSamplesAhead()) and the middle of the window, where the gain holds at 1, are skipped in one go; only
+	*the fades are stepped.
+	*
+	*However far it goes this costs at most one fade in and one fade out. The fades forget where they started once they
+	*have had time to finish (see settleSamples()), so a long skip jumps the phasor straight to a fade's length before
+	*the end and only steps through that last stretch.
+	*@param number of samples to skip
+	*/
+	void skipSamples(int64_t numSamples)
+	{
+		const int64_t settle = settleSamples();
+
+		if (settle >= 0 && numSamples > settle)
+		{
+			phasor.skip(uint64_t(numSamples - settle));
+			numSamples = settle;
+		}
+
+		while (numSamples > 0)
+		{
+			const int64_t silent = std::min(getSilentSamplesAhead(), numSamples);
+			const int64_t steady = silent > 0 ? 0 : std::min(steadySamplesAhead(), numSamples);
+
+			if (silent > 0)
+			{
+				skipSilence(silent);
+				numSamples -= silent;
+			}
+			else if (steady > 0)
+			{
+				phasor.skip(uint64_t(steady));
+				numSamples -= steady;
+			}
+			else
+			{
+				process();
+				numSamples--;
+			}
+		}
+	}
+
+	/**
+	*will give 1.0dB of gain when within the set window and 0.0dB elsewhere.
+	*/
+	float process()
+	{
+		return gainAt(FixedPhase::toDouble(phasor.advance()));	//moves the phasor on its ramp from 0 to 1
+	}
+
+	/**
+	*fills a buffer with the gain, overwriting what is already there.
+	*Sample-identical to calling process() numSamples times.
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		for (int chunkStart = 0; chunkStart < numSamples; chunkStart += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - chunkStart);
+
+			if (getSilentSamplesAhead() >= chunk)
+			{
+				std::fill(out + chunkStart, out + chunkStart + chunk, 0.0f);
+				skipSilence(chunk);
+				continue;
+			}
+
+			for (int i = chunkStart; i < chunkStart + chunk; i++)
+			{
+				out[i] = gainAt(FixedPhase::toDouble(phasor.advance()));
+			}
+		}
+	}
+
+	/**
+	*multiplies the buffer by the gain, i.e. gates a sound that has already been rendered (buffer[i] *= process())
+	*@param buffer to gate in place
+	*@param number of samples to gate
+	*/
+	void applyBlock(float* buffer, int numSamples)
+	{
+		float gains[scratchSize];
+
+		for (int chunkStart = 0; chunkStart < numSamples; chunkStart += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - chunkStart);
+			processBlock(gains, chunk);
+
+			for (int i = 0; i < chunk; i++)
+			{
+				buffer[chunkStart + i] *= gains[i];
+			}
+		}
+	}
+
+	/**
+	*adds the gain on top of what is already in the buffer (out[i] += process())
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		float gains[scratchSize];
+
+		for (int chunkStart = 0; chunkStart < numSamples; chunkStart += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - chunkStart);
+			processBlock(gains, chunk);
+
+			for (int i = 0; i < chunk; i++)
+			{
+				out[chunkStart + i] += gains[i];
+			}
+		}
+	}
+
+	//the settings a GUI changes, as one set that can be handed to the audio thread whole (see am_ParameterExchange.h)
+	struct Parameters
+	{
+		float pieceLength = 1.0f;				//seconds
+		float windowStart = 0.0f;				//seconds into the piece
+		float windowEnd = 2.0f;
+		float fadeTime = 0.5f;					//seconds
+	};
+
+	//applies a whole set through setPieceLength(), setWindow() and setFadeTime(). Does not allocate.
+	void setParameters(const Parameters& parameters)
+	{
+		setPieceLength(parameters.pieceLength);
+		setWindow(parameters.windowStart, parameters.windowEnd);
+		setFadeTime(parameters.fadeTime);
+	}
+
+	Parameters getParameters() const
+	{
+		Parameters parameters;
+		parameters.pieceLength = duration;
+		parameters.windowStart = float(start * duration);
+		parameters.windowEnd = float(end * duration);
+		parameters.fadeTime = fadeTime;
+		return parameters;
+	}
+
+	static constexpr char snapshotTag[5] = "DURW";
+
+	/**
+	*saves or restores the window, the exact position in the piece and the fades part way through (see am_Snapshot.h)
+	*@param SnapshotWriter or SnapshotReader
+	*/
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		phasor.serialise(archive);
+		archive.value(sampleRate);
+		archive.value(start);
+		archive.value(end);
+		archive.value(duration);
+		archive.value(fadeTime);
+		archive.value(fadeStep);
+		archive.value(fadeIn);
+		archive.value(fadeOut);
+
+		if (Archive::loading && !archive.check(duration > 0.0f && sampleRate > 0.0f))		//updateIncrement() divides by both
+		{
+			duration = 1.0f;
+			sampleRate = 44100.0f;
+		}
+	}
+
+private:
+	static constexpr int scratchSize = 64;						//samples gated at a time in applyBlock, and checked for silence in processBlock
+
+	//one cycle of the phasor per piece length
+	void updateIncrement()
+	{
+		phasor.setIncrement(1.0 / (double(duration) * double(sampleRate)));
+	}
+
+	//the fades move 1 / (fade time in samples) each sample
+	void updateFadeStep()
+	{
+		fadeStep = float(1.0 / std::max(double(fadeTime) * double(sampleRate), 1.0));
+	}
+
+	bool isBeforeStart(uint64_t phasorValue) const
+	{
+		return FixedPhase::toDouble(phasorValue) < start;
+	}
+
+	//the lowest raw phasor value that gainAt() sees as having reached the start, for start in (0, 1)
+	uint64_t startThreshold() const
+	{
+		if (start <= 0.0)
+		{
+			return 0;
+		}
+		return uint64_t(std::ceil(std::ldexp(start, 53))) << 11;			//toDouble() keeps the top 53 bits
+	}
+
+	//how many values from value on, stepping by increment, are below threshold (0 if value is not below it)
+	static int64_t samplesUntilAtLeast(uint64_t value, uint64_t threshold, uint64_t increment)
+	{
+		if (value >= threshold)
+		{
+			return 0;
+		}
+		if (increment == 0)
+		{
+			return INT64_MAX;
+		}
+		const uint64_t steps = (threshold - value - 1) / increment + 1;
+		return steps > uint64_t(INT64_MAX) ? INT64_MAX : int64_t(steps);
+	}
+
+	static int64_t addClamped(int64_t a, int64_t b)
+	{
+		return a > INT64_MAX - b ? INT64_MAX : a + b;
+	}
+
+	//the lowest raw phasor value that gainAt() sees as having reached the fade out, or ~0 if the window never ends
+	uint64_t endThreshold() const
+	{
+		const double fadeOutPoint = end - 0.001;
+
+		if (fadeOutPoint <= 0.0)
+		{
+			return 0;
+		}
+		const double scaled = fadeOutPoint < 1.0 ? std::ceil(std::ldexp(fadeOutPoint, 53)) : 9007199254740992.0;
+		return scaled < 9007199254740992.0 ? uint64_t(scaled) << 11 : ~uint64_t(0);
+	}
+
+	//how many of the next samples are inside the window with the fade in over, where process() only moves the phasor
+	int64_t steadySamplesAhead() const
+	{
+		const uint64_t increment = phasor.getIncrement();
+		const uint64_t next = phasor.getValue() + increment;
+
+		if (fadeIn != 1.0f || fadeOut != 1.0f || isBeforeStart(next))
+		{
+			return 0;
+		}
+		return samplesUntilAtLeast(next, endThreshold(), increment);
+	}
+
+	/**
+	*how many process() calls leave the fades the same whatever they were before, or -1 if a fade can stall. Every
+	*change between before the window, the window and the fade out resets one fade and clears the other, and a fade
+	*that runs uninterrupted from anywhere in [0, 1] reaches its end within 2 / fadeStep samples (each float add
+	*moves it at least half a step while the step is at least one float ulp below 1).
+	*/
+	int64_t settleSamples() const
+	{
+		if (!(fadeStep >= 1.0f / 16777216.0f))
+		{
+			return -1;
+		}
+		return 2 * int64_t(std::ceil(1.0 / double(fadeStep))) + 2;
+	}
+
+	//moves on a number of samples that are all silent, leaving the fades where process() would have
+	void skipSilence(int64_t numSamples)
+	{
+		phasor.skip(uint64_t(numSamples));
+		outVal = 0.0f;
+		fadeIn = 0.0f;
+		fadeOut = isBeforeStart(phasor.getValue()) ? 1.0f : 0.0f;
+	}
+
+	//steps the fades on from the current phasor value and returns the gain
+	float gainAt(double phasorValue)
+	{
+		if (phasorValue >= start)								// if the phasor decimal reaches the start decimal
+		{	
+			fadeIn = std::min(fadeIn + fadeStep, 1.0f);			//a short fadein to avoid clicks, then a constant gain
+			outVal = fadeIn;									//outputs the fadein
+
+			if (phasorValue >= end - 0.001)						//if the phasor reaches the end decimal
+			{
+				fadeOut = std::max(fadeOut - fadeStep, 0.0f);	//a short fadeout to avoid clicks, then 0.0dB
+				outVal = fadeOut;								//outputs the fadeout
+				fadeIn = 0.0f;									//resets the fadein
+			}
+			else
+			{
+				fadeOut = 1.0f;									//ready for the fadeout, also when the piece repeats
+			}
+		}
+		else
+		{
+			outVal = 0.0f;										//zero gain before start time
+			fadeIn = 0.0f;										//ready to fade in again when the piece repeats
+			fadeOut = 1.0f;
+		}
+
+		return outVal;											//return the gain
+	}
+
+	FixedPhase phasor;											//phasor to compare vs start/end times
+	float sampleRate = 44100.0f;
+
+	//without initialising start and end times, the gain will always be 1.0dB
+	double start = 0.0;									//failsafe on start time
+	double end = 2.0;									//failsafe end time
+
+	float outVal;
+	float duration = 1.0f;										//length of piece
+	
+	float fadeTime = 0.5f;										//seconds
+	float fadeStep = 1.0f / 22050.0f;							//fade change per sample
+	float fadeIn = 0.0f;										//initalise fadein
+	float fadeOut = 1.0f;										//initialise fadeout
+	
+
+};
+
@@ -0,0 +1,405 @@
+/*
+  ==============================================================================
+
+    am_FDNReverb.h
+    Created: 17 Oct 2026 7:03:55pm
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Denormals.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+//how the lines of an FDNReverb are mixed back into each other
+enum class FdnMixing
+{
+    hadamard = 0,       //every line feeds every other with the same weight, the densest. N log N adds.
+    householder         //each line mostly feeds itself and a little of all the others. 2N adds, builds up more slowly.
+};
+
+/**
+*A feedback delay network reverb: NumLines delay lines (8 or 16 are sensible) whose outputs are damped, scaled for the
+*decay time and mixed through an orthogonal matrix before going back in with the input. The tail gets denser as it goes
+*on, where chained comb filters stay sparse.
+*
+*All the lines live in one allocation, one power-of-two ring after another, sharing a write position. Nothing a line
+*reads in the next (shortest line length) samples has been written yet, so the lines are rendered in spans that long:
+*each line's span is read straight out of its ring, and the damping, decay gains, mixing and writing back are plain
+*loops over the span, which the compiler vectorizes. The damping is the average of each line's output with its
+*previous one (a zero at Nyquist when full), so no sample waits on the one before as it would with a one-pole filter.
+*8 lines cost about as much as one DoubleCombFilter::process() per sample, 16 lines about three.
+*
+*The line lengths are primes spread between 20 and 80ms times the room size, so no two lines share a resonance. The
+*block functions flush denormals to 0 while they run (see am_Denormals.h), which process() does not; apart from
+*denormal values the two give the same samples. setSampleRate() allocates, so only call it while audio is stopped.
+*
+*@tparam number of delay lines, a power of two
+*/
+template <int NumLines>
+class FDNReverb
+{
+    static_assert(NumLines >= 2 && (NumLines & (NumLines - 1)) == 0, "FDNReverb needs a power of two of lines");
+
+public:
+    static constexpr int numLines = NumLines;
+    static constexpr float shortestLine = 0.02f;        //seconds at room size 1
+    static constexpr float longestLine = 0.08f;
+
+    ///set the sample rate (Hz) and allocate the lines for it. Not for use while audio is running.
+    void setSampleRate(float sampleRateIn)
+    {
+        sampleRate = sampleRateIn;
+
+        lineSize = 1;
+        while (lineSize < int(longestLine * sampleRate) * 2)     //room for the longest line after rounding up to a prime
+        {
+            lineSize *= 2;
+        }
+
+        buffer.assign(size_t(lineSize) * NumLines, 0.0f);
+        mask = lineSize - 1;
+        writeIndex = 0;
+        updateLines();
+    }
+
+    ///set the room size in [0.05, 1], which scales every line length
+    void setSize(float sizeIn)
+    {
+        size = std::min(std::max(sizeIn, 0.05f), 1.0f);
+        updateLines();
+    }
+
+    ///set how long the tail takes to fall by 60dB, in seconds (the lows; the damping makes the highs shorter)
+    void setDecayTime(float seconds)
+    {
+        decayTime = std::max(seconds, 0.01f);
+        updateGains();
+    }
+
+    ///set how much the high frequencies are damped each time round the lines, in [0, 1]
+    void setDamping(float dampingIn)
+    {
+        damping = 0.5f * std::min(std::max(dampingIn, 0.0f), 1.0f);
+    }
+
+    ///hadamard (the default) or householder
+    void setMixing(FdnMixing mixingIn)
+    {
+        mixing = mixingIn;
+        updateGains();
+    }
+
+    ///set how much of the input is heard in the output (1 by default)
+    void setDryGain(float gain)
+    {
+        dryGain = gain;
+    }
+
+    ///set how much of the reverb is heard in the output (0.5 by default)
+    void setWetGain(float gain)
+    {
+        wetGain = gain;
+        updateWeights();
+    }
+
+    ///empty the lines, cutting off the tail
+    void clear()
+    {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+    }
+
+    ///one sample through the reverb
+    float process(float input)
+    {
+        float out;
+        render<false>(&input, &out, 1);
+        return out;
+    }
+
+    ///reverb a block of samples, writing into out
+    void processBlock(const float* input, float* out, int numSamples)
+    {
+        ScopedFlushDenormals noDenormals;
+        render<false>(input, out, numSamples);
+    }
+
+    ///reverb a block of samples in place
+    void processBlock(float* buffer, int numSamples)
+    {
+        ScopedFlushDenormals noDenormals;
+        render<false>(buffer, buffer, numSamples);
+    }
+
+    ///reverb a block of samples, adding the result on top of out (out[i] += process(input[i]))
+    void processBlockAdd(const float* input, float* out, int numSamples)
+    {
+        ScopedFlushDenormals noDenormals;
+        render<true>(input, out, numSamples);
+    }
+
+private:
+    static constexpr int scratchSize = 128;             //samples rendered at a time in the block functions
+
+    template <bool Add>
+    void render(const float* input, float* out, int numSamples)
+    {
+        if (buffer.empty())
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                out[i] = Add ? out[i] + dryGain * input[i] : dryGain * input[i];
+            }
+            return;
+        }
+
+        for (int start = 0; start < numSamples; )
+        {
+            const int span = std::min({ numSamples - start, scratchSize, lengths[0] });    //lengths[0] is the shortest
+            renderSpan<Add>(input + start, out + start, span);
+            start += span;
+        }
+    }
+
+    ///renders up to the shortest line length, so every sample read was written before the span
+    template <bool Add>
+    void renderSpan(const float* input, float* out, int span)
+    {
+        alignas(64) float lines[NumLines][scratchSize];
+        float wet[scratchSize];
+        std::fill(wet, wet + span, 0.0f);
+
+        //take each line's output, adding it to the wet signal, then damp and scale it for the decay time
+        for (int k = 0; k < NumLines; k++)
+        {
+            float wrapped[scratchSize + 1];
+            const float* previous = readPointer(k, (writeIndex - lengths[k] - 1) & mask, span + 1, wrapped);
+            const float* current = previous + 1;
+            float* line = lines[k];
+            const float weight = outputWeights[k];
+            const float gain = gains[k];
+
+            for (int i = 0; i < span; i++)
+            {
+                wet[i] += weight * current[i];
+                line[i] = (current[i] + damping * (previous[i] - current[i])) * gain;
+            }
+        }
+
+        //mix them into each other and write them back with the input
+        if (mixing == FdnMixing::hadamard)
+        {
+            hadamard(lines, span);
+        }
+        else
+        {
+            householder(lines, span);
+        }
+
+        for (int k = 0; k < NumLines; k++)
+        {
+            writeLine(k, lines[k], inputWeights[k], input, span);
+        }
+        writeIndex = (writeIndex + span) & mask;
+
+        for (int i = 0; i < span; i++)
+        {
+            const float outputSample = dryGain * input[i] + wet[i];        //in place safe: input[i] is read before out[i] is written
+            out[i] = Add ? out[i] + outputSample : outputSample;
+        }
+    }
+
+    ///numSamples of a line from a position, straight from the ring, or copied into wrapped if the ring wraps in them
+    const float* readPointer(int line, int position, int numSamples, float* wrapped) const
+    {
+        const float* ring = buffer.data() + size_t(line) * lineSize;
+        const int first = lineSize - position;
+
+        if (first >= numSamples)
+        {
+            return ring + position;
+        }
+
+        std::copy(ring + position, ring + lineSize, wrapped);
+        std::copy(ring, ring + (numSamples - first), wrapped + first);
+        return wrapped;
+    }
+
+    ///writes source + weight * input into a line at the write position, in two parts if the ring wraps
+    void writeLine(int line, const float* source, float weight, const float* input, int numSamples)
+    {
+        float* ring = buffer.data() + size_t(line) * lineSize;
+        const int first = std::min(numSamples, lineSize - writeIndex);
+
+        float* dest = ring + writeIndex;
+        for (int i = 0; i < first; i++)
+        {
+            dest[i] = source[i] + weight * input[i];
+        }
+        for (int i = first; i < numSamples; i++)
+        {
+            ring[i - first] = source[i] + weight * input[i];
+        }
+    }
+
+    ///the unnormalised fast Walsh-Hadamard transform of every sample (the 1 / sqrt(NumLines) is in the gains). Two
+    ///stages at a time, so each sample is loaded and stored half as often.
+    static void hadamard(float (&lines)[NumLines][scratchSize], int span)
+    {
+        int quarter = 1;
+        for (; quarter * 4 <= NumLines; quarter *= 4)
+        {
+            for (int start = 0; start < NumLines; start += 4 * quarter)
+            {
+                for (int k = start; k < start + quarter; k++)
+                {
+                    float* a = lines[k];
+                    float* b = lines[k + quarter];
+                    float* c = lines[k + 2 * quarter];
+                    float* d = lines[k + 3 * quarter];
+                    for (int i = 0; i < span; i++)
+                    {
+                        const float sumAB = a[i] + b[i];
+                        const float differenceAB = a[i] - b[i];
+                        const float sumCD = c[i] + d[i];
+                        const float differenceCD = c[i] - d[i];
+                        a[i] = sumAB + sumCD;
+                        b[i] = differenceAB + differenceCD;
+                        c[i] = sumAB - sumCD;
+                        d[i] = differenceAB - differenceCD;
+                    }
+                }
+            }
+        }
+
+        if (quarter < NumLines)                         //one stage left over when NumLines is an odd power of two
+        {
+            for (int k = 0; k < quarter; k++)
+            {
+                float* top = lines[k];
+                float* bottom = lines[k + quarter];
+                for (int i = 0; i < span; i++)
+                {
+                    const float a = top[i];
+                    const float b = bottom[i];
+                    top[i] = a + b;
+                    bottom[i] = a - b;
+                }
+            }
+        }
+    }
+
+    ///reflect every sample about the all-ones vector: each line minus 2 / NumLines of their sum
+    static void householder(float (&lines)[NumLines][scratchSize], int span)
+    {
+        float reflection[scratchSize];
+        std::fill(reflection, reflection + span, 0.0f);
+
+        for (int k = 0; k < NumLines; k++)
+        {
+            for (int i = 0; i < span; i++)
+            {
+                reflection[i] += lines[k][i];
+            }
+        }
+        for (int i = 0; i < span; i++)
+        {
+            reflection[i] *= 2.0f / float(NumLines);
+        }
+
+        for (int k = 0; k < NumLines; k++)
+        {
+            for (int i = 0; i < span; i++)
+            {
+                lines[k][i] -= reflection[i];
+            }
+        }
+    }
+
+    ///picks the line lengths for the sample rate and room size, shortest first
+    void updateLines()
+    {
+        const int maxLength = std::max(mask - 1, 1);        //room for the damping's extra sample
+        int previous = 1;
+
+        for (int k = 0; k < NumLines; k++)
+        {
+            //spread the lengths evenly on a log scale between the shortest and longest
+            const float seconds = shortestLine * std::pow(longestLine / shortestLine, float(k) / float(NumLines - 1));
+            int length = std::max(int(seconds * size * sampleRate), previous + 1);
+
+            while (!isPrime(length))
+            {
+                length++;
+            }
+
+            lengths[k] = std::min(length, maxLength);
+            previous = lengths[k];
+        }
+
+        updateGains();
+    }
+
+    ///each line loses 60dB in decayTime, however long it is
+    void updateGains()
+    {
+        const float normalise = mixing == FdnMixing::hadamard ? 1.0f / std::sqrt(float(NumLines)) : 1.0f;
+
+        for (int k = 0; k < NumLines; k++)
+        {
+            gains[k] = normalise * std::pow(10.0f, -3.0f * float(lengths[k]) / (decayTime * sampleRate));
+        }
+
+        updateWeights();
+    }
+
+    ///the input goes into every line and the output takes from every line, with signs so they do not all start in step
+    void updateWeights()
+    {
+        const float scale = 1.0f / std::sqrt(float(NumLines));
+
+        for (int k = 0; k < NumLines; k++)
+        {
+            inputWeights[k] = (k % 3 == 0 ? -scale : scale);
+            outputWeights[k] = (k % 2 == 0 ? wetGain * scale : -wetGain * scale);
+        }
+    }
+
+    static bool isPrime(int n)
+    {
+        if (n < 2)
+        {
+            return false;
+        }
+        for (int d = 2; d * d <= n; d++)
+        {
+            if (n % d == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<float> buffer;                  //NumLines rings of lineSize samples, one after the other
+    int lineSize = 0;                           //a power of two
+    int mask = 0;                               //lineSize - 1
+    int writeIndex = 0;                         //write position, the same in every line
+
+    std::array<int, NumLines> lengths {};       //in samples, shortest first
+    std::array<float, NumLines> gains {};       //decay gain of each line
+    std::array<float, NumLines> inputWeights {};
+    std::array<float, NumLines> outputWeights {};
+
+    FdnMixing mixing = FdnMixing::hadamard;
+    float sampleRate = 44100.0f;
+    float size = 1.0f;
+    float decayTime = 2.0f;
+    float damping = 0.15f;
+    float dryGain = 1.0f;
+    float wetGain = 0.5f;
+};
@@ -0,0 +1,441 @@
+/*
+  ==============================================================================
+
+	am_FMEngine.h
+	Created: 17 Oct 2026 10:05:47pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_FastSine.h"
+#include "am_Simd.h"
+#include <algorithm>
+
+/**
+*The routing of an FMEngine: which operators modulate which, which are heard, and which feed back into themselves.
+*
+*Operators are numbered from 0. A modulator must have a higher number than the operator it modulates, so the engine
+*can render them from the last to the first. Feedback is an operator modulating itself with its own output from the
+*previous sample, as on the DX7.
+*/
+template <int NumOperators>
+struct FMRouting
+{
+	static constexpr int numOperators = NumOperators;
+
+	bool modulates[NumOperators][NumOperators] = {};		//modulates[from][to], from above to
+	bool carrier[NumOperators] = {};						//mixed into the output
+	bool feedback[NumOperators] = {};						//modulated by its own previous output
+};
+
+/**
+*Ready-made algorithms. An algorithm is any type with a constexpr routing() function returning an FMRouting, so
+*others can be written the same way.
+*/
+
+//N operators in one chain, N-1 -> ... -> 1 -> 0, with feedback on the top one. The harshest, brightest sound.
+template <int N>
+struct FMStack
+{
+	static constexpr FMRouting<N> routing()
+	{
+		FMRouting<N> r;
+		for (int op = 1; op < N; op++)
+		{
+			r.modulates[op][op - 1] = true;
+		}
+		r.carrier[0] = true;
+		r.feedback[N - 1] = true;
+		return r;
+	}
+};
+
+//N / 2 two-operator pairs (1 -> 0, 3 -> 2, ...) all heard together, with feedback on the last modulator
+template <int N>
+struct FMPairs
+{
+	static_assert(N % 2 == 0, "FMPairs needs an even number of operators");
+
+	static constexpr FMRouting<N> routing()
+	{
+		FMRouting<N> r;
+		for (int op = 0; op < N; op += 2)
+		{
+			r.modulates[op + 1][op] = true;
+			r.carrier[op] = true;
+		}
+		r.feedback[N - 1] = true;
+		return r;
+	}
+};
+
+//N modulators into one carrier (operator 0) at once, with feedback on the carrier
+template <int N>
+struct FMBranches
+{
+	static constexpr FMRouting<N> routing()
+	{
+		FMRouting<N> r;
+		for (int op = 1; op < N; op++)
+		{
+			r.modulates[op][0] = true;
+		}
+		r.carrier[0] = true;
+		r.feedback[0] = true;
+		return r;
+	}
+};
+
+//N unmodulated sines heard together (additive), with no feedback
+template <int N>
+struct FMParallel
+{
+	static constexpr FMRouting<N> routing()
+	{
+		FMRouting<N> r;
+		for (int op = 0; op < N; op++)
+		{
+			r.carrier[op] = true;
+		}
+		return r;
+	}
+};
+
+/**
+*A multi-operator FM (phase modulation) engine. It generalises PhiModulator to any number of sine operators, routed by
+*an algorithm fixed at compile time, e.g. FMEngine<FMStack<6>>.
+*
+*Each operator is a sine at baseFrequency * ratio. Its output is level * sin(2 pi phase + sum of its modulators'
+*outputs), so the level of a modulator is its modulation index in radians (PhiModulator's index) and the level of a
+*carrier is its gain in the mix.
+*
+*The routing is a compile-time constant, so the loops over it are unrolled and connections that are not there cost
+*nothing. Every operator without feedback is rendered a block at a time: its phase is accumulated, its modulators
+*(already rendered, because they have higher numbers) are added in, and the sines of the whole block are taken in one
+*pass. With SineMode::polynomial that pass runs 4, 8 or 16 samples per SSE2, AVX2 or AVX-512 instruction (chosen at
+*runtime, like OscillatorBank), so a 6 operator stack costs about the same as six vectorized sine blocks instead of six
+*Oscillator::process() call chains. An operator with feedback depends on its previous sample, so only that one is
+*rendered sample by sample.
+*/
+template <class Algorithm>
+class FMEngine
+{
+public:
+
+	static constexpr int numOperators = decltype(Algorithm::routing())::numOperators;
+
+	FMEngine()
+	{
+		setInstructionSet(detectInstructionSet());
+		std::fill(ratio, ratio + numOperators, 1.0f);
+		std::fill(level, level + numOperators, 1.0f);
+		std::fill(feedbackAmount, feedbackAmount + numOperators, 0.0f);
+		reset();
+	}
+
+	/**
+	*set up the whole engine
+	*@param sample rate in Hz
+	*@param base frequency in Hz, which every operator's ratio multiplies
+	*/
+	void setUp(float _sampleRate, float _baseFrequency)
+	{
+		sampleRate = _sampleRate;
+		setFrequency(_baseFrequency);
+	}
+
+	//set the sample rate in Hz
+	void setSampleRate(float _sampleRate)
+	{
+		sampleRate = _sampleRate;
+		updateDeltas();
+	}
+
+	//set the base frequency in Hz, e.g. the note being played
+	void setFrequency(float _baseFrequency)
+	{
+		baseFrequency = _baseFrequency;
+		updateDeltas();
+	}
+
+	/**
+	*set the frequency of one operator as a multiple of the base frequency
+	*@param operator number
+	*@param ratio, e.g. 1, 2, 3.5
+	*/
+	void setRatio(int op, float _ratio)
+	{
+		ratio[op] = _ratio;
+		updateDeltas();
+	}
+
+	/**
+	*set the output level of one operator: its modulation index in radians for a modulator, its gain for a carrier
+	*@param operator number
+	*@param level
+	*/
+	void setLevel(int op, float _level)
+	{
+		level[op] = _level;
+	}
+
+	/**
+	*set how much an operator with feedback in the routing modulates itself (ignored for the others)
+	*@param operator number
+	*@param feedback in radians per unit of output, 0 for none
+	*/
+	void setFeedback(int op, float amount)
+	{
+		feedbackAmount[op] = amount;
+	}
+
+	/**
+	*choose how the sines are calculated. SineMode::polynomial is the one that vectorizes.
+	*@param SineMode::exact (std::sin), SineMode::polynomial or SineMode::table
+	*/
+	void setSineMode(SineMode mode)
+	{
+		sineMode = mode;
+
+		if (sineMode == SineMode::table)
+		{
+			FastSine::getTable();
+		}
+	}
+
+	/**
+	*choose which instruction set renders the polynomial sines. Anything the machine cannot run is lowered to the best
+	*it can.
+	*@param instruction set to use
+	*/
+	void setInstructionSet(InstructionSet requested)
+	{
+		static const InstructionSet supported = detectInstructionSet();
+		instructionSet = std::min(requested, supported);
+	}
+
+	//restarts every operator at phase 0 and clears the feedback
+	void reset()
+	{
+		std::fill(phase, phase + numOperators, 0.0f);
+		std::fill(lastOutput, lastOutput + numOperators, 0.0f);
+	}
+
+
+	//Output Functions
+
+	//outputs one sample of the mixed carriers
+	float process()
+	{
+		float out;
+		processBlock(&out, 1);
+		return out;
+	}
+
+	/**
+	*fills a buffer with the mixed carriers, overwriting what is already there.
+	*Sample-identical to calling process() numSamples times.
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		render(out, numSamples, false);
+	}
+
+	/**
+	*adds the mixed carriers on top of what is already in the buffer (out[i] += process())
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		render(out, numSamples, true);
+	}
+
+private:
+	static constexpr FMRouting<numOperators> routing = Algorithm::routing();
+	static constexpr int scratchSize = 64;						//samples rendered per pass over the operators
+	static constexpr int maxLanes = 16;							//widest vector (AVX-512); scratchSize is a multiple of it
+
+	static constexpr bool modulatorsAboveTargets()
+	{
+		for (int from = 0; from < numOperators; from++)
+		{
+			for (int to = from; to < numOperators; to++)
+			{
+				if (routing.modulates[from][to])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	static_assert(modulatorsAboveTargets(), "FMEngine: a modulator must have a higher number than the operator it modulates (use feedback for an operator modulating itself)");
+
+	void updateDeltas()
+	{
+		for (int op = 0; op < numOperators; op++)
+		{
+			phaseDelta[op] = baseFrequency * ratio[op] / sampleRate;
+		}
+	}
+
+	void render(float* out, int numSamples, bool add)
+	{
+		alignas(64) float outputs[numOperators][scratchSize];
+
+		for (int start = 0; start < numSamples; start += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - start);
+
+			for (int op = numOperators - 1; op >= 0; op--)		//modulators before the operators they modulate
+			{
+				renderOperator(op, outputs, chunk);
+			}
+
+			for (int i = 0; i < chunk; i++)
+			{
+				float sum = 0.0f;
+				for (int op = 0; op < numOperators; op++)
+				{
+					if (routing.carrier[op])
+					{
+						sum += outputs[op][i];
+					}
+				}
+				out[start + i] = add ? out[start + i] + sum : sum;
+			}
+		}
+	}
+
+	//renders one operator for a chunk into outputs[op]. Every operator it is modulated by is already in outputs.
+	void renderOperator(int op, float (*outputs)[scratchSize], int numSamples)
+	{
+		alignas(64) float angle[scratchSize];
+
+		float p = phase[op];
+		const float delta = phaseDelta[op];
+		for (int i = 0; i < numSamples; i++)
+		{
+			p += delta;
+			if (p > 1.0f)
+			{
+				p -= 1.0f;
+			}
+			angle[i] = p * 6.28318f;							//radians, the same angle as Oscillator
+		}
+		phase[op] = p;
+
+		for (int from = op + 1; from < numOperators; from++)
+		{
+			if (routing.modulates[from][op])
+			{
+				for (int i = 0; i < numSamples; i++)
+				{
+					angle[i] += outputs[from][i];
+				}
+			}
+		}
+
+		float* result = outputs[op];
+		const float gain = level[op];
+
+		if (routing.feedback[op])
+		{
+			const float amount = feedbackAmount[op];
+			float previous = lastOutput[op];
+			for (int i = 0; i < numSamples; i++)
+			{
+				previous = gain * FastSine::sinTurns((angle[i] + amount * previous) * 0.159154943f, sineMode);
+				result[i] = previous;
+			}
+			lastOutput[op] = previous;
+		}
+		else
+		{
+			for (int i = 0; i < numSamples; i++)
+			{
+				angle[i] *= 0.159154943f;						//to turns for the sine engines
+			}
+			sineBlock(angle, result, numSamples);
+			for (int i = 0; i < numSamples; i++)
+			{
+				result[i] *= gain;
+			}
+		}
+	}
+
+	/**
+	*sines of a chunk of angles in turns. The vector polynomial always runs over whole vectors (the padding is worked
+	*out and ignored), so every sample comes out the same whether it was rendered alone or in a longer block.
+	*@param angles in turns, with room for scratchSize
+	*@param buffer to write into, with room for scratchSize
+	*@param number of samples
+	*/
+	void sineBlock(float* turns, float* out, int numSamples)
+	{
+		if (sineMode != SineMode::polynomial)
+		{
+			FastSine::sinTurnsBlock(turns, out, numSamples, sineMode);
+			return;
+		}
+
+		const int padded = ((numSamples + maxLanes - 1) / maxLanes) * maxLanes;
+		std::fill(turns + numSamples, turns + padded, 0.0f);
+
+		switch (instructionSet)
+		{
+#if AM_SIMD_X86
+			case InstructionSet::avx512: polynomialAvx512(turns, out, padded); break;
+			case InstructionSet::avx2: polynomialAvx2(turns, out, padded); break;
+			case InstructionSet::sse2: polynomialSse2(turns, out, padded); break;
+#endif
+			default: FastSine::polynomialBlock(turns, out, numSamples); break;
+		}
+	}
+
+#if AM_SIMD_X86
+
+	AM_TARGET_SSE2 static void polynomialSse2(const float* turns, float* out, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i += 4)
+		{
+			_mm_store_ps(out + i, FastSine::polynomialSse2(_mm_load_ps(turns + i)));
+		}
+	}
+
+	AM_TARGET_AVX2 static void polynomialAvx2(const float* turns, float* out, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i += 8)
+		{
+			_mm256_store_ps(out + i, FastSine::polynomialAvx2(_mm256_load_ps(turns + i)));
+		}
+	}
+
+	AM_TARGET_AVX512 static void polynomialAvx512(const float* turns, float* out, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i += 16)
+		{
+			_mm512_store_ps(out + i, FastSine::polynomialAvx512(_mm512_load_ps(turns + i)));
+		}
+	}
+
+#endif
+
+	float sampleRate = 44100.0f;
+	float baseFrequency = 0.0f;
+	SineMode sineMode = AM_DEFAULT_SINE_MODE;
+	InstructionSet instructionSet = InstructionSet::scalar;
+
+	float phase[numOperators];
+	float phaseDelta[numOperators] = {};
+	float ratio[numOperators];
+	float level[numOperators];
+	float feedbackAmount[numOperators];
+	float lastOutput[numOperators];								//previous sample of each operator, for feedback
+};
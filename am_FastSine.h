@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+	am_FastSine.h
+	Created: 17 Oct 2026 11:04:37am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Simd.h"
+#include <cmath>
+
+/**
+*Sine engines of different precision, for trading accuracy against speed.
+*All of them take the angle in turns (1.0 = one full cycle = 2 pi radians), which makes the range reduction cheap.
+*
+*Max absolute error against std::sin, measured over [-64, 64] turns in float:
+*1) exact       - std::sin in double precision, rounded to float. Reference.
+*2) polynomial  - 9th order minimax polynomial on a quarter cycle. Max error 1.7e-7 (float rounding dominates,
+*                 the polynomial itself is good to 3.3e-9). Branch-free, so block and SIMD versions vectorize.
+*3) table       - 2048 point table with linear interpolation. Max error 1.2e-6. One lookup per sample, so it does
+*                 not vectorize, but it is the cheapest option in plain SSE2 builds.
+*
+*Oscillator converts its phase (and phi modulation) to turns first, which adds up to about 3e-7 on top of these.
+*Rough cost of Oscillator::processBlock on a sine here: exact 13-17 ns/sample, table 4-6, polynomial 6 (SSE2 build)
+*or 2.4 (-march=native).
+*
+*The default for new oscillators can be chosen at compile time by defining AM_DEFAULT_SINE_MODE,
+*e.g. -DAM_DEFAULT_SINE_MODE=SineMode::polynomial
+*/
+enum class SineMode
+{
+	exact = 0,
+	polynomial,
+	table
+};
+
+#ifndef AM_DEFAULT_SINE_MODE
+#define AM_DEFAULT_SINE_MODE SineMode::exact
+#endif
+
+namespace FastSine
+{
+	//minimax coefficients for sin(2 pi t) = t * (c1 + c3 t^2 + c5 t^4 + c7 t^6 + c9 t^8) on t in [-0.25, 0.25]
+	constexpr float c1 = 6.283185160f;
+	constexpr float c3 = -41.34165503f;
+	constexpr float c5 = 81.60100407f;
+	constexpr float c7 = -76.54978230f;
+	constexpr float c9 = 39.53670608f;
+
+	constexpr int tableSize = 2048;								//must be a power of two
+
+	//one cycle of sine plus a guard point so interpolation never needs to wrap
+	struct SineTable
+	{
+		SineTable()
+		{
+			for (int i = 0; i <= tableSize; i++)
+			{
+				values[i] = float(std::sin(2.0 * 3.14159265358979323846 * i / tableSize));
+			}
+		}
+
+		float values[tableSize + 1];
+	};
+
+	//built the first time it is used. Call this from a setup function so the audio thread never builds it.
+	inline const SineTable& getTable()
+	{
+		static const SineTable table;
+		return table;
+	}
+
+	/**
+	*sin(2 pi x) using std::sin
+	*@param angle in turns
+	*/
+	inline float exact(float turns)
+	{
+		return float(std::sin(2.0 * 3.14159265358979323846 * turns));
+	}
+
+	/**
+	*sin(2 pi x) using the minimax polynomial. Valid for |x| < 2^31.
+	*@param angle in turns
+	*/
+	inline float polynomial(float turns)
+	{
+		float t = turns - float(int(turns));					//(-1, 1)
+		t = t > 0.5f ? t - 1.0f : t;							//[-0.5, 0.5]
+		t = t < -0.5f ? t + 1.0f : t;
+		t = t > 0.25f ? 0.5f - t : t;							//fold onto the quarter cycle, sin(pi - a) = sin(a)
+		t = t < -0.25f ? -0.5f - t : t;
+
+		const float t2 = t * t;
+		return t * (c1 + t2 * (c3 + t2 * (c5 + t2 * (c7 + t2 * c9))));
+	}
+
+	/**
+	*sin(2 pi x) using the interpolated table. Valid for |x| < 2^31.
+	*@param angle in turns
+	*/
+	inline float table(float turns)
+	{
+		float t = turns - float(int(turns));
+		t = t < 0.0f ? t + 1.0f : t;							//[0, 1]
+
+		const float position = t * tableSize;
+		const int index = int(position) & (tableSize - 1);
+		const float fraction = position - float(int(position));
+		const float* values = getTable().values;
+
+		return values[index] + fraction * (values[index + 1] - values[index]);
+	}
+
+	//true for one of the SineMode values, e.g. to check one read back from a snapshot
+	inline bool isValidMode(SineMode mode)
+	{
+		return mode == SineMode::exact || mode == SineMode::polynomial || mode == SineMode::table;
+	}
+
+	//sin(2 pi x) with the chosen engine
+	inline float sinTurns(float turns, SineMode mode)
+	{
+		switch (mode)
+		{
+			case SineMode::polynomial: return polynomial(turns);
+			case SineMode::table: return table(turns);
+			default: return exact(turns);
+		}
+	}
+
+	/**
+	*sin(2 pi x) for a whole buffer with the polynomial. The loop has no branches or dependencies so the compiler
+	*turns it into vector code.
+	*@param angles in turns
+	*@param buffer to write into (may be the same as the input)
+	*@param number of samples
+	*/
+	inline void polynomialBlock(const float* turns, float* out, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i++)
+		{
+			out[i] = polynomial(turns[i]);
+		}
+	}
+
+	//sin(2 pi x) for a whole buffer with the chosen engine
+	inline void sinTurnsBlock(const float* turns, float* out, int numSamples, SineMode mode)
+	{
+		switch (mode)
+		{
+			case SineMode::polynomial:
+				polynomialBlock(turns, out, numSamples);
+				break;
+			case SineMode::table:
+				for (int i = 0; i < numSamples; i++)
+				{
+					out[i] = table(turns[i]);
+				}
+				break;
+			default:
+				for (int i = 0; i < numSamples; i++)
+				{
+					out[i] = exact(turns[i]);
+				}
+				break;
+		}
+	}
+
+#if AM_SIMD_X86
+
+	//the polynomial on 4 lanes
+	AM_TARGET_SSE2 inline __m128 polynomialSse2(__m128 turns)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 quarter = _mm_set1_ps(0.25f);
+
+		__m128 t = _mm_sub_ps(turns, _mm_cvtepi32_ps(_mm_cvttps_epi32(turns)));
+		t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, half), one));
+		t = _mm_add_ps(t, _mm_and_ps(_mm_cmplt_ps(t, _mm_sub_ps(_mm_setzero_ps(), half)), one));
+
+		__m128 above = _mm_cmpgt_ps(t, quarter);
+		t = _mm_or_ps(_mm_and_ps(above, _mm_sub_ps(half, t)), _mm_andnot_ps(above, t));
+		__m128 below = _mm_cmplt_ps(t, _mm_sub_ps(_mm_setzero_ps(), quarter));
+		t = _mm_or_ps(_mm_and_ps(below, _mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), half), t)), _mm_andnot_ps(below, t));
+
+		const __m128 t2 = _mm_mul_ps(t, t);
+		__m128 p = _mm_add_ps(_mm_set1_ps(c7), _mm_mul_ps(t2, _mm_set1_ps(c9)));
+		p = _mm_add_ps(_mm_set1_ps(c5), _mm_mul_ps(t2, p));
+		p = _mm_add_ps(_mm_set1_ps(c3), _mm_mul_ps(t2, p));
+		p = _mm_add_ps(_mm_set1_ps(c1), _mm_mul_ps(t2, p));
+		return _mm_mul_ps(t, p);
+	}
+
+	//the polynomial on 8 lanes
+	AM_TARGET_AVX2 inline __m256 polynomialAvx2(__m256 turns)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 minusHalf = _mm256_set1_ps(-0.5f);
+		const __m256 quarter = _mm256_set1_ps(0.25f);
+		const __m256 minusQuarter = _mm256_set1_ps(-0.25f);
+
+		__m256 t = _mm256_sub_ps(turns, _mm256_round_ps(turns, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+		t = _mm256_sub_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, half, _CMP_GT_OQ), one));
+		t = _mm256_add_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, minusHalf, _CMP_LT_OQ), one));
+		t = _mm256_blendv_ps(t, _mm256_sub_ps(half, t), _mm256_cmp_ps(t, quarter, _CMP_GT_OQ));
+		t = _mm256_blendv_ps(t, _mm256_sub_ps(minusHalf, t), _mm256_cmp_ps(t, minusQuarter, _CMP_LT_OQ));
+
+		const __m256 t2 = _mm256_mul_ps(t, t);
+		__m256 p = _mm256_fmadd_ps(t2, _mm256_set1_ps(c9), _mm256_set1_ps(c7));
+		p = _mm256_fmadd_ps(t2, p, _mm256_set1_ps(c5));
+		p = _mm256_fmadd_ps(t2, p, _mm256_set1_ps(c3));
+		p = _mm256_fmadd_ps(t2, p, _mm256_set1_ps(c1));
+		return _mm256_mul_ps(t, p);
+	}
+
+	//the polynomial on 16 lanes
+	AM_TARGET_AVX512 inline __m512 polynomialAvx512(__m512 turns)
+	{
+		const __m512 one = _mm512_set1_ps(1.0f);
+		const __m512 half = _mm512_set1_ps(0.5f);
+		const __m512 minusHalf = _mm512_set1_ps(-0.5f);
+		const __m512 quarter = _mm512_set1_ps(0.25f);
+		const __m512 minusQuarter = _mm512_set1_ps(-0.25f);
+
+		__m512 t = _mm512_sub_ps(turns, _mm512_mask_roundscale_ps(turns, 0xffff, turns, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+		t = _mm512_mask_sub_ps(t, _mm512_cmp_ps_mask(t, half, _CMP_GT_OQ), t, one);
+		t = _mm512_mask_add_ps(t, _mm512_cmp_ps_mask(t, minusHalf, _CMP_LT_OQ), t, one);
+		t = _mm512_mask_sub_ps(t, _mm512_cmp_ps_mask(t, quarter, _CMP_GT_OQ), half, t);
+		t = _mm512_mask_sub_ps(t, _mm512_cmp_ps_mask(t, minusQuarter, _CMP_LT_OQ), minusHalf, t);
+
+		const __m512 t2 = _mm512_mul_ps(t, t);
+		__m512 p = _mm512_fmadd_ps(t2, _mm512_set1_ps(c9), _mm512_set1_ps(c7));
+		p = _mm512_fmadd_ps(t2, p, _mm512_set1_ps(c5));
+		p = _mm512_fmadd_ps(t2, p, _mm512_set1_ps(c3));
+		p = _mm512_fmadd_ps(t2, p, _mm512_set1_ps(c1));
+		return _mm512_mul_ps(t, p);
+	}
+
+#endif
+}
@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+	am_FixedPhase.h
+	Created: 17 Oct 2026 9:26:04pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//how an oscillator keeps its phase
+enum class PhaseMode
+{
+	floatingPoint = 0,		//a float wrapped with a compare (the original behaviour)
+	fixedPoint				//a FixedPhase accumulator: exact frequency and no drift over long sessions
+};
+
+/**
+*A fixed-point phase accumulator. The top 32 bits are the phase as a uint32 (0 to 2^32 is one cycle), so it wraps for
+*free when it overflows and never needs a compare. The bottom 32 bits carry the fraction of the increment a plain
+*uint32 would round away, which keeps very slow phasors exact: a one hour cycle at 48kHz is only about 25 steps of the
+*uint32 per sample, and rounding that would be out by seconds by the end.
+*
+*A float phase only has 24 bits, so its increment is rounded differently for every frequency and its error builds up
+*with every sample. Here the increment is exact to better than 1e-16 of a cycle and adding it builds up no error at all.
+*/
+class FixedPhase
+{
+public:
+
+	//set the phase increment in cycles per sample (frequency / sample rate). Negative increments run backwards.
+	void setIncrement(double turnsPerSample)
+	{
+		increment = fromTurns(turnsPerSample);
+	}
+
+	//jump to a phase in cycles. Only the fractional part is kept.
+	void setPhase(double turns)
+	{
+		value = fromTurns(turns);
+	}
+
+	//moves on one sample and returns the raw phase
+	uint64_t advance()
+	{
+		value += increment;
+		return value;
+	}
+
+	//moves on a number of samples at once (still exact)
+	void skip(uint64_t numSamples)
+	{
+		value += increment * numSamples;
+	}
+
+	//the raw phase, for loops that keep it in a local and store it back
+	void setValue(uint64_t raw)
+	{
+		value = raw;
+	}
+
+	uint64_t getValue() const
+	{
+		return value;
+	}
+
+	uint64_t getIncrement() const
+	{
+		return increment;
+	}
+
+	//the phase in [0, 1)
+	float getPhase() const
+	{
+		return toFloat(value);
+	}
+
+	/**
+	*converts cycles to the fixed-point format, wrapping into [0, 1) first
+	*@param cycles, e.g. a phase or an increment (frequency / sample rate)
+	*@return the raw fixed-point value
+	*/
+	static uint64_t fromTurns(double turns)
+	{
+		turns -= std::floor(turns);
+		const double scaled = turns * 4294967296.0;						//2^32, the uint32 part
+		const double whole = std::floor(scaled);
+		return (uint64_t(whole) << 32) + uint64_t((scaled - whole) * 4294967296.0 + 0.5);		//rounded; a carry adds into the top half
+	}
+
+	//a raw phase as a float in [0, 1). Only the top 24 bits fit in a float, so this is exact and never rounds up to 1.
+	static float toFloat(uint64_t fixed)
+	{
+		return float(uint32_t(fixed >> 40)) * (1.0f / 16777216.0f);
+	}
+
+	//a raw phase as a double in [0, 1), for comparisons that need every bit of a slow phasor
+	static double toDouble(uint64_t fixed)
+	{
+		return double(fixed >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	//saves or restores the exact phase and increment (see am_Snapshot.h)
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		archive.value(value);
+		archive.value(increment);
+	}
+
+private:
+	uint64_t value = 0;
+	uint64_t increment = 0;
+};
+
+/**
+*Skips a floating-point phase ahead exactly, for the oscillators that keep their phase as a float (PhaseMode::
+*floatingPoint and OscillatorBank). The result is bit for bit what stepping
+*	phase += delta; if (phase > 1) phase -= 1;
+*that many times gives, rounding included, without doing most of the adds:
+*
+*- Between two powers of 2 a float has a fixed spacing, so once an add has landed inside one every add after it moves
+*  the phase by the same whole number of spacings (an add that was a tie leaves the last bit even, and it stays even).
+*  The run up to the next power of 2 is then one multiply. Octaves less than 16 increments wide are just stepped.
+*- The phase after every wrap is a multiple of 2^-23 below delta, so there are at most delta * 2^23 of them and the
+*  sequence repeats, within about 2^23 samples. Once the repeat is found (Brent's cycle finding) whole periods are
+*  skipped at once, so a skip of any length costs at most a few periods.
+*/
+class FloatPhase
+{
+public:
+
+	/**
+	*@param phase to start from
+	*@param increment per sample. Increments outside (0, 1) are stepped one sample at a time.
+	*@param number of samples to move on
+	*@return the phase after numSamples samples
+	*/
+	static float skip(float phase, float delta, int64_t numSamples)
+	{
+		if (!(delta > 0.0f && delta < 1.0f))
+		{
+			for (; numSamples > 0; numSamples--)
+			{
+				phase = step(phase, delta);
+			}
+			return phase;
+		}
+
+		phase = advance(phase, delta, numSamples, true);					//to the first wrap
+
+		float tortoise = phase;
+		int64_t tortoiseLeft = numSamples;
+		int64_t power = 1;
+		int64_t cycles = 0;
+
+		while (numSamples > 0)
+		{
+			phase = advance(phase, delta, numSamples, true);
+			cycles++;
+
+			if (phase == tortoise)
+			{
+				numSamples %= tortoiseLeft - numSamples;					//whole periods
+				return advance(phase, delta, numSamples, false);
+			}
+
+			if (cycles == power)
+			{
+				tortoise = phase;
+				tortoiseLeft = numSamples;
+				power *= 2;
+				cycles = 0;
+			}
+		}
+		return phase;
+	}
+
+private:
+
+	static float step(float phase, float delta)
+	{
+		phase += delta;
+		return phase > 1.0f ? phase - 1.0f : phase;
+	}
+
+	static uint32_t bits(float value)
+	{
+		uint32_t result;
+		std::memcpy(&result, &value, sizeof(result));
+		return result;
+	}
+
+	/**
+	*moves on up to numSamples for an increment in (0, 1), jumping through the octaves
+	*@param phase to start from
+	*@param increment per sample
+	*@param samples to move on; the samples used are taken off it
+	*@param true to stop just after the next wrap
+	*@return the new phase
+	*/
+	static float advance(float phase, float delta, int64_t& numSamples, bool untilWrap)
+	{
+		const uint32_t wideExponent = (bits(delta) >> 23) + 4;				//octaves at least 16 increments wide
+
+		while (numSamples > 0)
+		{
+			const float previous = phase;
+			phase = step(phase, delta);
+			numSamples--;
+
+			if (!(phase >= previous))										//wrapped
+			{
+				if (untilWrap)
+				{
+					return phase;
+				}
+				continue;
+			}
+
+			const uint32_t exponent = bits(phase) >> 23;
+			if (exponent < wideExponent || exponent > 126 || (bits(previous) >> 23) != exponent || numSamples == 0)
+			{
+				continue;
+			}
+
+			//phase came from an add inside the octave, so one more add gives the spacing every later add moves it by
+			const uint32_t from = bits(phase);
+			const uint32_t to = bits(step(phase, delta));
+			if ((to >> 23) != exponent || to < from)
+			{
+				continue;
+			}
+
+			const uint32_t spacings = to - from;
+			const uint32_t room = 0x7fffff - (from & 0x7fffff);				//spacings left below the next power of 2
+			const int64_t jump = spacings == 0 ? numSamples : std::min<int64_t>(numSamples, room / spacings);
+			const uint32_t landed = from + uint32_t(jump) * spacings;
+
+			std::memcpy(&phase, &landed, sizeof(phase));
+			numSamples -= jump;
+		}
+		return phase;
+	}
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    am_FixedVector.h
+    Created: 17 Oct 2026 4:05:48pm
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+/**
+*A vector with a capacity fixed at compile time. The elements live inline (no heap), so resizing never allocates and
+*the whole thing sits in one block of memory next to the class that owns it.
+*
+*Meant as a drop-in for the std::vector members of the synthesis classes: resize(), size(), operator[] and range-for
+*work the same way. Differences: resize() clamps to the capacity, and elements are not destroyed or reset when the
+*size shrinks, so growing again brings back the same elements with whatever state they had (default constructed at
+*first). The classes using it set every element up again after a resize, so this costs nothing and keeps resizing free.
+*/
+template <class T, int Capacity>
+class FixedVector
+{
+public:
+
+    using value_type = T;
+
+    static constexpr int capacity = Capacity;
+
+    ///set the number of elements in use, clamped to [0, Capacity]
+    void resize(int newSize)
+    {
+        numElements = std::min(std::max(newSize, 0), Capacity);
+    }
+
+    void clear()
+    {
+        numElements = 0;
+    }
+
+    int size() const
+    {
+        return numElements;
+    }
+
+    bool empty() const
+    {
+        return numElements == 0;
+    }
+
+    T& operator[](int index)
+    {
+        return elements[index];
+    }
+
+    const T& operator[](int index) const
+    {
+        return elements[index];
+    }
+
+    T* begin()
+    {
+        return elements.data();
+    }
+
+    T* end()
+    {
+        return elements.data() + numElements;
+    }
+
+    const T* begin() const
+    {
+        return elements.data();
+    }
+
+    const T* end() const
+    {
+        return elements.data() + numElements;
+    }
+
+private:
+    std::array<T, Capacity> elements {};
+    int numElements = 0;
+};
+
+///how many elements a container can hold without allocating, 0 for containers that grow (std::vector)
+template <class Container>
+struct FixedCapacity
+{
+    static constexpr int value = 0;
+};
+
+template <class T, int Capacity>
+struct FixedCapacity<FixedVector<T, Capacity>>
+{
+    static constexpr int value = Capacity;
+};
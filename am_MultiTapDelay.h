@@ -0,0 +1,297 @@
+/*
+  ==============================================================================
+
+    am_MultiTapDelay.h
+    Created: 17 Oct 2026 6:12:40pm
+    Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_DelayLine.h"
+#include "am_Denormals.h"
+#include <algorithm>
+#include <array>
+
+/**
+*Up to MaxTaps taps reading from one shared delay line, each with its own delay time, feedback and output gain:
+*
+*   output = dryGain * input + sum of gain[k] * tap[k]
+*   written into the delay line = input + sum of feedback[k] * tap[k]
+*
+*This is DoubleCombFilter with any number of taps and with real feedback. Rhythmic delays and dense combs that would
+*take several DoubleCombFilters (each with its own buffer) use one buffer here.
+*
+*The block functions work through the block in spans where no tap and not the write position wrap (see
+*DelayLine::contiguousSpan()). In each span every tap is read as a plain array into two sums, one for the output and
+*one for the feedback, so the loops vectorize along the samples. The taps' settings are stored as arrays, one entry
+*per tap. Feedback cannot be shorter than a span, so a tap's delay is at least one sample.
+*
+*The feedbacks are each clamped to [-1, 1], but the delay is only stable while their absolute values add up to less
+*than 1. setMaxDelay() allocates, so only call it while audio is stopped (e.g. in prepareToPlay).
+*
+*@tparam most taps the delay can have
+*@tparam how the delay line stores its samples (see am_DelayLine.h), Float16Storage or Int16Storage for half the memory
+*/
+template <int MaxTaps, class Storage = Float32Storage>
+class MultiTapDelay
+{
+    static_assert(MaxTaps > 0, "MultiTapDelay needs at least one tap");
+    using Line = BasicDelayLine<Storage>;
+
+public:
+    static constexpr int maxTaps = MaxTaps;
+
+    ///set the sample rate (Hz)
+    void setSampleRate(float sampleRateIn)
+    {
+        sampleRate = sampleRateIn;
+        updateTaps();
+    }
+
+    ///set the maximum size of the delay line in seconds. Allocates: not for use while audio is running.
+    void setMaxDelay(float maxDelayIn)
+    {
+        delayLine.setMaxDelaySamples(int(maxDelayIn * sampleRate));
+        updateTaps();
+    }
+
+    ///set how many of the taps are used, from 0 to MaxTaps. Taps keep their settings while they are not used.
+    void setNumTaps(int numTapsIn)
+    {
+        numTaps = std::min(std::max(numTapsIn, 0), MaxTaps);
+    }
+
+    int getNumTaps() const
+    {
+        return numTaps;
+    }
+
+    /**
+    *set everything about one tap
+    *@param tap index, from 0 to MaxTaps - 1
+    *@param delay time in seconds, at least one sample and at most the maximum delay
+    *@param feedback in [-1, 1]
+    *@param gain of the tap in the output
+    */
+    void setTap(int index, float delayTime, float feedback, float gain)
+    {
+        setTapTime(index, delayTime);
+        setTapFeedback(index, feedback);
+        setTapGain(index, gain);
+    }
+
+    ///set a tap's delay time in seconds
+    void setTapTime(int index, float delayTime)
+    {
+        if (index >= 0 && index < MaxTaps)
+        {
+            delayTimes[index] = delayTime;
+            updateTap(index);
+        }
+    }
+
+    ///set how much of a tap is fed back into the delay line, clamped to [-1, 1]
+    void setTapFeedback(int index, float feedback)
+    {
+        if (index >= 0 && index < MaxTaps)
+        {
+            feedbacks[index] = std::min(std::max(feedback, -1.0f), 1.0f);
+        }
+    }
+
+    ///set how much of a tap is heard in the output
+    void setTapGain(int index, float gain)
+    {
+        if (index >= 0 && index < MaxTaps)
+        {
+            gains[index] = gain;
+        }
+    }
+
+    ///set how much of the input is heard in the output (1 by default, like DoubleCombFilter)
+    void setDryGain(float gain)
+    {
+        dryGain = gain;
+    }
+
+    ///fill the delay line with silence
+    void clear()
+    {
+        delayLine.clear();
+    }
+
+    ///use the delay line on one sample
+    float process(float input)
+    {
+        if (!delayLine.isReady())
+        {
+            return dryGain * input;
+        }
+
+        float wet = 0.0f;
+        float feedback = 0.0f;
+
+        for (int k = 0; k < numTaps; k++)
+        {
+            const float tapSample = delayLine.read(taps[k]);
+            wet += gains[k] * tapSample;
+            feedback += feedbacks[k] * tapSample;
+        }
+
+        delayLine.write(input + feedback);
+        return dryGain * input + wet;
+    }
+
+    ///use the delay line on a block of samples, writing into out. Sample-identical to calling process() on each input.
+    void processBlock(const float* input, float* out, int numSamples)
+    {
+        render<false>(input, out, numSamples);
+    }
+
+    ///use the delay line on a block of samples in place
+    void processBlock(float* buffer, int numSamples)
+    {
+        render<false>(buffer, buffer, numSamples);
+    }
+
+    ///use the delay line on a block of samples, adding the result on top of out (out[i] += process(input[i]))
+    void processBlockAdd(const float* input, float* out, int numSamples)
+    {
+        render<true>(input, out, numSamples);
+    }
+
+private:
+    static constexpr int scratchSize = 256;         //samples summed at a time in the block functions
+    static_assert(scratchSize <= Line::maxReadSpan, "a span must fit the delay line's conversion scratch");
+
+    ///recalculates the read taps after the sample rate or the buffer size change
+    void updateTaps()
+    {
+        for (int k = 0; k < MaxTaps; k++)
+        {
+            updateTap(k);
+        }
+    }
+
+    void updateTap(int index)
+    {
+        const float delaySamples = std::min(std::max(delayTimes[index] * sampleRate, 1.0f), float(delayLine.getMaxDelaySamples()));
+        taps[index] = delayLine.makeTap(delaySamples);
+    }
+
+    ///block version of process(), in spans where every tap can be read as a plain array
+    template <bool Add>
+    void render(const float* input, float* out, int numSamples)
+    {
+        ScopedFlushDenormals noDenormals;
+
+        if (!delayLine.isReady())
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                out[i] = Add ? out[i] + dryGain * input[i] : dryGain * input[i];
+            }
+            return;
+        }
+
+        float wet[scratchSize];
+        float feedback[scratchSize];
+
+        int done = 0;
+        while (done < numSamples)
+        {
+            int span = std::min({ numSamples - done, delayLine.writableSpan(), scratchSize });
+            for (int k = 0; k < numTaps; k++)
+            {
+                span = std::min(span, delayLine.contiguousSpan(taps[k]));
+            }
+
+            if (span < 1)
+            {
+                //a tap is about to wrap: do one sample the ordinary way
+                const float outputSample = process(input[done]);
+                out[done] = Add ? out[done] + outputSample : outputSample;
+                done += 1;
+                continue;
+            }
+
+            std::fill(wet, wet + span, 0.0f);
+            std::fill(feedback, feedback + span, 0.0f);
+
+            //none of the samples read in this span are written in it, so the taps can be read one after the other,
+            //four to a pass so the sums stay in registers for longer
+            int k = 0;
+            for (; k + 4 <= numTaps; k += 4)
+            {
+                sumTaps<4>(k, wet, feedback, span);
+            }
+            for (; k < numTaps; k++)
+            {
+                sumTaps<1>(k, wet, feedback, span);
+            }
+
+            const float* in = input + done;
+            for (int i = 0; i < span; i++)
+            {
+                feedback[i] = in[i] + feedback[i];
+            }
+            delayLine.writeBlock(feedback, span);
+
+            float* dest = out + done;
+            for (int i = 0; i < span; i++)
+            {
+                const float outputSample = dryGain * in[i] + wet[i];        //in place safe: in[i] is read before dest[i] is written
+                dest[i] = Add ? dest[i] + outputSample : outputSample;
+            }
+
+            done += span;
+        }
+    }
+
+    ///adds taps first to first + Group - 1 into the output and feedback sums of a span, in the same order as process()
+    template <int Group>
+    void sumTaps(int first, float* wet, float* feedback, int span) const
+    {
+        float scratch[Group][Storage::readsInPlace ? 1 : scratchSize + 1];      //converted samples, if they cannot be read in place
+        const float* tapData[Group];
+        float fraction[Group];
+        float gain[Group];
+        float tapFeedback[Group];
+
+        for (int g = 0; g < Group; g++)
+        {
+            tapData[g] = delayLine.readSpan(taps[first + g], span, scratch[g]);
+            fraction[g] = taps[first + g].fraction;
+            gain[g] = gains[first + g];
+            tapFeedback[g] = feedbacks[first + g];
+        }
+
+        for (int i = 0; i < span; i++)
+        {
+            float wetSum = wet[i];
+            float feedbackSum = feedback[i];
+
+            for (int g = 0; g < Group; g++)
+            {
+                const float tapSample = Line::interpolate(tapData[g][i], tapData[g][i + 1], fraction[g]);
+                wetSum += gain[g] * tapSample;
+                feedbackSum += tapFeedback[g] * tapSample;
+            }
+
+            wet[i] = wetSum;
+            feedback[i] = feedbackSum;
+        }
+    }
+
+    Line delayLine;                                         //stores delay data, shared by all the taps
+    std::array<typename Line::Tap, MaxTaps> taps {};        //read positions
+    std::array<float, MaxTaps> delayTimes {};       //in seconds
+    std::array<float, MaxTaps> feedbacks {};        //each in [-1, 1]
+    std::array<float, MaxTaps> gains {};
+
+    int numTaps = 0;
+    float dryGain = 1.0f;
+    float sampleRate = 44100.0f;
+};
@@ -0,0 +1,780 @@
+/*
+  ==============================================================================
+
+	am_OscillatorBank.h
+	Created: 17 Oct 2026 9:20:51am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_FastSine.h"
+#include "am_FixedPhase.h"
+#include "am_ParameterRamp.h"
+#include "am_PolyBlep.h"
+#include "am_Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+*A bank of oscillators that all share one wave index, stored as structure-of-arrays (phase, phase delta, pulse width
+*and gain each in their own contiguous array) so 4, 8 or 16 of them can be run per SSE2, AVX2 or AVX-512 instruction.
+*
+*The output of the bank is the gain-weighted sum of every oscillator, which is exactly what Chord and clusterChord
+*need. Phases advance and wrap exactly like Oscillator::process(), but the sum is done in a different order so the
+*output is very close to, not bit-identical with, the scalar classes.
+*
+*The instruction set is detected at runtime and can be lowered with setInstructionSet() (e.g. to compare results).
+*/
+class OscillatorBank
+{
+public:
+
+	OscillatorBank()
+	{
+		setInstructionSet(detectInstructionSet());
+	}
+
+	/**
+	*set the sample rate for every oscillator in the bank. Frequencies already set are kept, and ramps carry on to their
+	*targets in the samples they have left.
+	*@param sample rate in Hz
+	*/
+	void setSampleRate(float _sampleRate)
+	{
+		const float rescale = sampleRate / _sampleRate;
+		sampleRate = _sampleRate;
+
+		for (int i = 0; i < numOscillators; i++)
+		{
+			if (rampLeft[i] > 0)
+			{
+				phaseDelta[i] *= rescale;							//the ratio of an exponential ramp does not change
+				deltaStep[i] *= rescale;
+			}
+			else
+			{
+				setFrequency(i, freq[i]);
+			}
+		}
+	}
+
+	//set the wave index for the whole bank: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+	void setWaveIndex(int waveIndex)
+	{
+		waveIndexVal = waveIndex;
+	}
+
+	/**
+	*choose how sine waves are calculated. SineMode::polynomial is the only one that runs fully in vector registers.
+	*@param SineMode::exact (std::sin), SineMode::polynomial or SineMode::table
+	*/
+	void setSineMode(SineMode mode)
+	{
+		sineMode = mode;
+
+		if (sineMode == SineMode::table)
+		{
+			FastSine::getTable();
+		}
+	}
+
+	SineMode getSineMode() const
+	{
+		return sineMode;
+	}
+
+	/**
+	*choose band-limited (PolyBLEP) square, triangle and sawtooth waves. These are rendered by the scalar path, so a
+	*band-limited bank trades the SIMD speed-up for alias-free output.
+	*@param true for band-limited, false for the naive waves
+	*/
+	void setBandLimited(bool shouldBandLimit)
+	{
+		bandLimited = shouldBandLimit;
+	}
+
+	bool isBandLimited() const
+	{
+		return bandLimited;
+	}
+
+	//makes room for a number of oscillators up front so addOscillator() never allocates
+	void reserve(int maxOscillators)
+	{
+		const int padded = paddedSize(maxOscillators);
+		if (padded > int(phase.size()))
+		{
+			resizeArrays(padded);
+		}
+	}
+
+	//removes every oscillator (keeps the memory)
+	void clear()
+	{
+		std::fill(phase.begin(), phase.end(), 0.0f);
+		std::fill(phaseDelta.begin(), phaseDelta.end(), 0.0f);
+		std::fill(pw.begin(), pw.end(), 0.5f);
+		std::fill(gain.begin(), gain.end(), 0.0f);
+		std::fill(freq.begin(), freq.end(), 0.0f);
+		std::fill(deltaRatio.begin(), deltaRatio.end(), 1.0f);
+		std::fill(deltaStep.begin(), deltaStep.end(), 0.0f);
+		std::fill(rampLeft.begin(), rampLeft.end(), 0);
+		numOscillators = 0;
+		rampSamplesLeft = 0;
+	}
+
+	/**
+	*adds an oscillator to the bank
+	*@param frequency in Hz
+	*@param gain the oscillator is mixed in with
+	*@return index of the new oscillator
+	*/
+	int addOscillator(float _freq, float _gain)
+	{
+		reserve(numOscillators + 1);
+		const int index = numOscillators++;
+		setFrequency(index, _freq);
+		setGain(index, _gain);
+		return index;
+	}
+
+	//set the frequency of one oscillator in Hz. Stops any frequency ramp on it.
+	void setFrequency(int index, float _freq)
+	{
+		const bool wasRamping = rampLeft[index] > 0;
+		stopRamp(index, _freq);
+
+		if (wasRamping)
+		{
+			updateRampSamplesLeft();
+		}
+	}
+
+	/**
+	*glide the frequency of one oscillator, one step per sample inside the vector loops (a multiply and an add on the
+	*phase increment, no division). Each oscillator stops on its own target, however many others are ramping.
+	*@param index of the oscillator
+	*@param frequency to reach in Hz
+	*@param length of the glide in samples
+	*@param RampShape::exponential or RampShape::linear
+	*/
+	void rampFrequency(int index, float targetFrequency, int numSamples, RampShape shape = RampShape::exponential)
+	{
+		if (numSamples <= 0)
+		{
+			setFrequency(index, targetFrequency);
+			return;
+		}
+
+		ParameterRamp ramp;
+		ramp.setCurrent(phaseDelta[index]);
+		ramp.rampTo(targetFrequency / sampleRate, numSamples, shape);
+
+		freq[index] = targetFrequency;
+		deltaRatio[index] = ramp.getRatio();
+		deltaStep[index] = ramp.getStep();
+		rampLeft[index] = numSamples;
+		updateRampSamplesLeft();
+	}
+
+	//true while any oscillator is still gliding to its target
+	bool isRamping() const
+	{
+		return rampSamplesLeft > 0;
+	}
+
+	//set the gain one oscillator is mixed in with
+	void setGain(int index, float _gain)
+	{
+		gain[index] = _gain;
+	}
+
+	//set the phase width of one oscillator (square wave only)
+	void setPhaseWidth(int index, float _pw)
+	{
+		pw[index] = _pw;
+	}
+
+	//set the current phase of one oscillator in [0, 1]
+	void setPhase(int index, float _phase)
+	{
+		phase[index] = _phase;
+	}
+
+	int getNumOscillators() const
+	{
+		return numOscillators;
+	}
+
+	/**
+	*choose which instruction set renders the bank. Anything the machine cannot run is lowered to the best it can.
+	*@param instruction set to use
+	*/
+	void setInstructionSet(InstructionSet requested)
+	{
+		static const InstructionSet supported = detectInstructionSet();
+		instructionSet = std::min(requested, supported);
+	}
+
+	InstructionSet getInstructionSet() const
+	{
+		return instructionSet;
+	}
+
+	/**
+	*saves or restores every oscillator, ramps included (see am_Snapshot.h). The instruction set is not saved: a
+	*restored bank keeps the one it has, so a snapshot moves between machines.
+	*@param SnapshotWriter or SnapshotReader
+	*/
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		archive.value(numOscillators);
+		archive.value(waveIndexVal);
+		archive.value(sampleRate);
+		archive.value(sineMode);
+		archive.value(bandLimited);
+		archive.array(phase);
+		archive.array(phaseDelta);
+		archive.array(pw);
+		archive.array(gain);
+		archive.array(freq);
+		archive.array(deltaRatio);
+		archive.array(deltaStep);
+		archive.array(rampLeft);
+
+		if (Archive::loading)
+		{
+			//every array is read up to the padded oscillator count
+			const size_t size = phase.size();
+			const bool sameSizes = phaseDelta.size() == size && pw.size() == size && gain.size() == size
+				&& freq.size() == size && deltaRatio.size() == size && deltaStep.size() == size && rampLeft.size() == size;
+
+			if (!archive.check(sameSizes && size % maxLanes == 0 && numOscillators >= 0 && size_t(numOscillators) <= size
+				&& size_t(paddedSize(numOscillators)) <= size
+				&& std::all_of(rampLeft.begin(), rampLeft.end(), [](int left) { return left >= 0; })
+				&& waveIndexVal >= 0 && waveIndexVal <= 4 && sampleRate > 0.0f && FastSine::isValidMode(sineMode)))
+			{
+				numOscillators = 0;
+				std::fill(rampLeft.begin(), rampLeft.end(), 0);
+				waveIndexVal = 0;
+				sampleRate = 44100.0f;
+				sineMode = AM_DEFAULT_SINE_MODE;
+			}
+			setSineMode(sineMode);
+			updateRampSamplesLeft();
+		}
+	}
+
+
+	//Output Functions
+
+	//outputs one sample of the summed bank
+	float process()
+	{
+		float out;
+		processBlock(&out, 1);
+		return out;
+	}
+
+	/**
+	*fills a buffer with the summed bank, overwriting what is already there
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		render(out, numSamples, false);
+	}
+
+	/**
+	*adds the summed bank on top of what is already in the buffer
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		render(out, numSamples, true);
+	}
+
+	/**
+	*moves on numSamples without rendering, leaving every oscillator as if the bank had rendered them, ramps included.
+	*Ramps are stepped; after them each phase jumps a power of 2 at a time (see FloatPhase), a few steps a cycle.
+	*@param number of samples to skip
+	*/
+	void skipSamples(int64_t numSamples)
+	{
+		while (numSamples > 0 && rampSamplesLeft > 0)
+		{
+			const int ramped = int(std::min<int64_t>(rampSamplesLeft, numSamples));
+
+			for (int k = 0; k < numOscillators; k++)
+			{
+				float p = phase[k];
+				float delta = phaseDelta[k];
+				for (int i = 0; i < ramped; i++)
+				{
+					delta = delta * deltaRatio[k] + deltaStep[k];
+					p += delta;
+					p = p > 1.0f ? p - 1.0f : p;
+				}
+				phase[k] = p;
+				phaseDelta[k] = delta;
+			}
+
+			numSamples -= ramped;
+			advanceRamps(ramped);
+		}
+
+		for (int k = 0; k < numOscillators; k++)
+		{
+			phase[k] = FloatPhase::skip(phase[k], phaseDelta[k], numSamples);
+		}
+	}
+
+private:
+
+	static constexpr int maxLanes = 16;					//widest vector (AVX-512). The arrays are always padded to this.
+	static constexpr int scratchSize = 64;				//samples rendered per pass over the bank
+	static constexpr float turnsPerPhase = 6.28318f * 0.159154943f;		//phase to sine angle in turns, matching Oscillator
+
+	//per wave constants so every non-sine wave is one branch-free formula:
+	//out = slope * (phase - centre) + fold * (|phase - 0.5| - 0.25) + square * (phase > pw ? -1 : 1)
+	struct Shape
+	{
+		float slope = 0.0f;
+		float centre = 0.0f;
+		float fold = 0.0f;
+		float square = 0.0f;
+	};
+
+	//sine of one lane when it cannot be done with the vector polynomial. Same angle as Oscillator uses.
+	float sineLane(float p) const
+	{
+		if (sineMode == SineMode::exact)
+		{
+			return std::sin(p * 2.0 * 3.14159);
+		}
+		return FastSine::sinTurns(p * turnsPerPhase, sineMode);
+	}
+
+	static int paddedSize(int count)
+	{
+		return ((count + maxLanes - 1) / maxLanes) * maxLanes;
+	}
+
+	void resizeArrays(int size)
+	{
+		deltaRatio.resize(size, 1.0f);
+		deltaStep.resize(size, 0.0f);
+		rampLeft.resize(size, 0);
+		phase.resize(size, 0.0f);
+		phaseDelta.resize(size, 0.0f);
+		pw.resize(size, 0.5f);
+		gain.resize(size, 0.0f);
+		freq.resize(size, 0.0f);
+	}
+
+	Shape getShape() const
+	{
+		Shape shape;
+		switch (waveIndexVal)
+		{
+			case 0: shape.slope = 1.0f; break;								//phasor
+			case 2: shape.square = 1.0f; break;								//square wave
+			case 3: shape.fold = 4.0f; break;								//triangle wave
+			case 4: shape.slope = 2.0f; shape.centre = 0.5f; break;			//sawtooth wave
+			default: break;
+		}
+		return shape;
+	}
+
+	void render(float* out, int numSamples, bool add)
+	{
+		for (int start = 0; start < numSamples;)
+		{
+			const bool ramping = rampSamplesLeft > 0;
+			const int chunk = std::min(ramping ? std::min(scratchSize, rampSamplesLeft) : scratchSize, numSamples - start);
+
+			if (numOscillators == 0)
+			{
+				if (!add)
+				{
+					std::fill(out + start, out + start + chunk, 0.0f);		//an empty bank is silent, but still moves on
+				}
+			}
+			else
+			{
+				const bool needsScalar = bandLimited && waveIndexVal >= 2 && waveIndexVal <= 4;
+
+				switch (needsScalar ? InstructionSet::scalar : instructionSet)
+				{
+#if AM_SIMD_X86
+					case InstructionSet::avx512: renderAvx512(out + start, chunk, add); break;
+					case InstructionSet::avx2: renderAvx2(out + start, chunk, add); break;
+					case InstructionSet::sse2: renderSse2(out + start, chunk, add); break;
+#endif
+					default: renderScalar(out + start, chunk, add); break;
+				}
+			}
+
+			start += chunk;
+
+			if (ramping)
+			{
+				advanceRamps(chunk);
+			}
+		}
+	}
+
+	//sets one oscillator's frequency and stops its ramp, leaving rampSamplesLeft to the caller
+	void stopRamp(int index, float _freq)
+	{
+		freq[index] = _freq;
+		phaseDelta[index] = _freq / sampleRate;
+		deltaRatio[index] = 1.0f;
+		deltaStep[index] = 0.0f;
+		rampLeft[index] = 0;
+	}
+
+	//rampSamplesLeft is the shortest ramp still running, so no chunk runs an oscillator past its target
+	void updateRampSamplesLeft()
+	{
+		rampSamplesLeft = 0;
+		for (int i = 0; i < numOscillators; i++)
+		{
+			if (rampLeft[i] > 0 && (rampSamplesLeft == 0 || rampLeft[i] < rampSamplesLeft))
+			{
+				rampSamplesLeft = rampLeft[i];
+			}
+		}
+	}
+
+	//counts numSamples (no more than rampSamplesLeft) off every ramp, landing the ones that end exactly on their targets
+	void advanceRamps(int numSamples)
+	{
+		for (int i = 0; i < numOscillators; i++)
+		{
+			if (rampLeft[i] > 0)
+			{
+				rampLeft[i] -= numSamples;
+				if (rampLeft[i] == 0)
+				{
+					stopRamp(i, freq[i]);
+				}
+			}
+		}
+		updateRampSamplesLeft();
+	}
+
+	//reference version, also used on non-x86 machines
+	void renderScalar(float* out, int numSamples, bool add)
+	{
+		float sums[scratchSize] = {};
+		const bool ramping = rampSamplesLeft > 0;
+		const Shape shape = getShape();
+		const bool sine = waveIndexVal == 1;
+		const bool polyBlep = bandLimited && waveIndexVal >= 2 && waveIndexVal <= 4;
+
+		for (int k = 0; k < numOscillators; k++)
+		{
+			float p = phase[k];
+			float delta = phaseDelta[k];
+			for (int i = 0; i < numSamples; i++)
+			{
+				if (ramping)
+				{
+					delta = delta * deltaRatio[k] + deltaStep[k];
+				}
+
+				p += delta;
+				if (p > 1.0f)
+				{
+					p -= 1.0f;
+				}
+
+				float value;
+				if (sine)
+				{
+					value = sineLane(p);
+				}
+				else if (polyBlep)
+				{
+					const float dt = std::fabs(delta);
+					value = waveIndexVal == 2 ? PolyBlep::square(p, pw[k], dt) : (waveIndexVal == 3 ? PolyBlep::triangle(p, dt) : PolyBlep::sawtooth(p, dt));
+				}
+				else
+				{
+					value = shape.slope * (p - shape.centre) + shape.fold * (std::fabs(p - 0.5f) - 0.25f) + shape.square * (p > pw[k] ? -1.0f : 1.0f);
+				}
+				sums[i] += gain[k] * value;
+			}
+			phase[k] = p;
+			phaseDelta[k] = delta;
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			out[i] = add ? out[i] + sums[i] : sums[i];
+		}
+	}
+
+#if AM_SIMD_X86
+
+	AM_TARGET_SSE2 void renderSse2(float* out, int numSamples, bool add)
+	{
+		const bool ramping = rampSamplesLeft > 0;
+		alignas(16) __m128 sums[scratchSize];
+		alignas(16) float lanes[4];
+
+		const Shape shape = getShape();
+		const bool sine = waveIndexVal == 1;
+		const bool vectorSine = sineMode == SineMode::polynomial;
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 quarter = _mm_set1_ps(0.25f);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 slope = _mm_set1_ps(shape.slope);
+		const __m128 centre = _mm_set1_ps(shape.centre);
+		const __m128 fold = _mm_set1_ps(shape.fold);
+		const __m128 square = _mm_set1_ps(shape.square);
+		const int used = ((numOscillators + 3) / 4) * 4;
+
+		for (int k = 0; k < used; k += 4)
+		{
+			__m128 p = _mm_loadu_ps(&phase[k]);
+			__m128 delta = _mm_loadu_ps(&phaseDelta[k]);
+			const __m128 ratio = _mm_loadu_ps(&deltaRatio[k]);
+			const __m128 step = _mm_loadu_ps(&deltaStep[k]);
+			const __m128 width = _mm_loadu_ps(&pw[k]);
+			const __m128 g = _mm_loadu_ps(&gain[k]);
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				if (ramping)
+				{
+					delta = _mm_add_ps(_mm_mul_ps(delta, ratio), step);
+				}
+
+				p = _mm_add_ps(p, delta);
+				p = _mm_sub_ps(p, _mm_and_ps(_mm_cmpgt_ps(p, one), one));		//wrap the phase
+
+				__m128 value;
+				if (sine && vectorSine)
+				{
+					value = FastSine::polynomialSse2(_mm_mul_ps(p, _mm_set1_ps(turnsPerPhase)));
+				}
+				else if (sine)
+				{
+					_mm_store_ps(lanes, p);
+					for (int l = 0; l < 4; l++)
+					{
+						lanes[l] = sineLane(lanes[l]);
+					}
+					value = _mm_load_ps(lanes);
+				}
+				else
+				{
+					const __m128 ramp = _mm_mul_ps(slope, _mm_sub_ps(p, centre));
+					const __m128 tri = _mm_mul_ps(fold, _mm_sub_ps(_mm_and_ps(_mm_sub_ps(p, half), absMask), quarter));
+					const __m128 sign = _mm_sub_ps(one, _mm_and_ps(_mm_cmpgt_ps(p, width), _mm_add_ps(one, one)));
+					value = _mm_add_ps(_mm_add_ps(ramp, tri), _mm_mul_ps(square, sign));
+				}
+
+				const __m128 weighted = _mm_mul_ps(g, value);
+				sums[i] = k == 0 ? weighted : _mm_add_ps(sums[i], weighted);
+			}
+			_mm_storeu_ps(&phase[k], p);
+			_mm_storeu_ps(&phaseDelta[k], delta);
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			__m128 s = _mm_add_ps(sums[i], _mm_movehl_ps(sums[i], sums[i]));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			const float total = _mm_cvtss_f32(s);
+			out[i] = add ? out[i] + total : total;
+		}
+	}
+
+	AM_TARGET_AVX2 void renderAvx2(float* out, int numSamples, bool add)
+	{
+		const bool ramping = rampSamplesLeft > 0;
+		alignas(32) __m256 sums[scratchSize];
+		alignas(32) float lanes[8];
+
+		const Shape shape = getShape();
+		const bool sine = waveIndexVal == 1;
+		const bool vectorSine = sineMode == SineMode::polynomial;
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 quarter = _mm256_set1_ps(0.25f);
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		const __m256 slope = _mm256_set1_ps(shape.slope);
+		const __m256 centre = _mm256_set1_ps(shape.centre);
+		const __m256 fold = _mm256_set1_ps(shape.fold);
+		const __m256 square = _mm256_set1_ps(shape.square);
+		const int used = ((numOscillators + 7) / 8) * 8;
+
+		for (int k = 0; k < used; k += 8)
+		{
+			__m256 p = _mm256_loadu_ps(&phase[k]);
+			__m256 delta = _mm256_loadu_ps(&phaseDelta[k]);
+			const __m256 ratio = _mm256_loadu_ps(&deltaRatio[k]);
+			const __m256 step = _mm256_loadu_ps(&deltaStep[k]);
+			const __m256 width = _mm256_loadu_ps(&pw[k]);
+			const __m256 g = _mm256_loadu_ps(&gain[k]);
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				if (ramping)
+				{
+					delta = _mm256_fmadd_ps(delta, ratio, step);
+				}
+
+				p = _mm256_add_ps(p, delta);
+				p = _mm256_sub_ps(p, _mm256_and_ps(_mm256_cmp_ps(p, one, _CMP_GT_OQ), one));	//wrap the phase
+
+				__m256 value;
+				if (sine && vectorSine)
+				{
+					value = FastSine::polynomialAvx2(_mm256_mul_ps(p, _mm256_set1_ps(turnsPerPhase)));
+				}
+				else if (sine)
+				{
+					_mm256_store_ps(lanes, p);
+					for (int l = 0; l < 8; l++)
+					{
+						lanes[l] = sineLane(lanes[l]);
+					}
+					value = _mm256_load_ps(lanes);
+				}
+				else
+				{
+					const __m256 ramp = _mm256_mul_ps(slope, _mm256_sub_ps(p, centre));
+					const __m256 tri = _mm256_mul_ps(fold, _mm256_sub_ps(_mm256_and_ps(_mm256_sub_ps(p, half), absMask), quarter));
+					const __m256 sign = _mm256_sub_ps(one, _mm256_and_ps(_mm256_cmp_ps(p, width, _CMP_GT_OQ), two));
+					value = _mm256_add_ps(_mm256_add_ps(ramp, tri), _mm256_mul_ps(square, sign));
+				}
+
+				const __m256 weighted = _mm256_mul_ps(g, value);
+				sums[i] = k == 0 ? weighted : _mm256_add_ps(sums[i], weighted);
+			}
+			_mm256_storeu_ps(&phase[k], p);
+			_mm256_storeu_ps(&phaseDelta[k], delta);
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(sums[i]), _mm256_extractf128_ps(sums[i], 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			const float total = _mm_cvtss_f32(s);
+			out[i] = add ? out[i] + total : total;
+		}
+	}
+
+	AM_TARGET_AVX512 void renderAvx512(float* out, int numSamples, bool add)
+	{
+		const bool ramping = rampSamplesLeft > 0;
+		alignas(64) float sums[scratchSize * 16];		//one vector of lane sums per sample
+		alignas(64) float lanes[16];
+
+		const Shape shape = getShape();
+		const bool sine = waveIndexVal == 1;
+		const bool vectorSine = sineMode == SineMode::polynomial;
+		const __m512 one = _mm512_set1_ps(1.0f);
+		const __m512 minusOne = _mm512_set1_ps(-1.0f);
+		const __m512 half = _mm512_set1_ps(0.5f);
+		const __m512 quarter = _mm512_set1_ps(0.25f);
+		const __m512i absMask = _mm512_set1_epi32(0x7fffffff);
+		const __m512 slope = _mm512_set1_ps(shape.slope);
+		const __m512 centre = _mm512_set1_ps(shape.centre);
+		const __m512 fold = _mm512_set1_ps(shape.fold);
+		const __m512 square = _mm512_set1_ps(shape.square);
+		const int used = ((numOscillators + 15) / 16) * 16;
+
+		for (int k = 0; k < used; k += 16)
+		{
+			__m512 p = _mm512_loadu_ps(&phase[k]);
+			__m512 delta = _mm512_loadu_ps(&phaseDelta[k]);
+			const __m512 ratio = _mm512_loadu_ps(&deltaRatio[k]);
+			const __m512 step = _mm512_loadu_ps(&deltaStep[k]);
+			const __m512 width = _mm512_loadu_ps(&pw[k]);
+			const __m512 g = _mm512_loadu_ps(&gain[k]);
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				if (ramping)
+				{
+					delta = _mm512_fmadd_ps(delta, ratio, step);
+				}
+
+				p = _mm512_add_ps(p, delta);
+				p = _mm512_mask_sub_ps(p, _mm512_cmp_ps_mask(p, one, _CMP_GT_OQ), p, one);	//wrap the phase
+
+				__m512 value;
+				if (sine && vectorSine)
+				{
+					value = FastSine::polynomialAvx512(_mm512_mul_ps(p, _mm512_set1_ps(turnsPerPhase)));
+				}
+				else if (sine)
+				{
+					_mm512_store_ps(lanes, p);
+					for (int l = 0; l < 16; l++)
+					{
+						lanes[l] = sineLane(lanes[l]);
+					}
+					value = _mm512_load_ps(lanes);
+				}
+				else
+				{
+					const __m512 ramp = _mm512_mul_ps(slope, _mm512_sub_ps(p, centre));
+					const __m512 tri = _mm512_mul_ps(fold, _mm512_sub_ps(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(_mm512_sub_ps(p, half)), absMask)), quarter));
+					const __m512 sign = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(p, width, _CMP_GT_OQ), one, minusOne);
+					value = _mm512_add_ps(_mm512_add_ps(ramp, tri), _mm512_mul_ps(square, sign));
+				}
+
+				const __m512 weighted = _mm512_mul_ps(g, value);
+				_mm512_store_ps(&sums[i * 16], k == 0 ? weighted : _mm512_add_ps(_mm512_load_ps(&sums[i * 16]), weighted));
+			}
+			_mm512_storeu_ps(&phase[k], p);
+			_mm512_storeu_ps(&phaseDelta[k], delta);
+		}
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			const __m256 v = _mm256_add_ps(_mm256_load_ps(&sums[i * 16]), _mm256_load_ps(&sums[i * 16 + 8]));
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			const float total = _mm_cvtss_f32(s);
+			out[i] = add ? out[i] + total : total;
+		}
+	}
+
+#endif
+
+	//structure-of-arrays oscillator state, padded to a multiple of maxLanes with silent oscillators
+	std::vector<float> phase;
+	std::vector<float> phaseDelta;
+	std::vector<float> pw;
+	std::vector<float> gain;
+	std::vector<float> freq;
+	std::vector<float> deltaRatio;						//per sample multiplier of phaseDelta while ramping (1 otherwise)
+	std::vector<float> deltaStep;						//per sample increment of phaseDelta while ramping (0 otherwise)
+	std::vector<int> rampLeft;							//samples until each oscillator reaches its target (0 if not ramping)
+
+	int numOscillators = 0;
+	int rampSamplesLeft = 0;							//the shortest of rampLeft that is not 0: the most a chunk can ramp
+	int waveIndexVal = 0;
+	float sampleRate = 44100.0f;
+	SineMode sineMode = AM_DEFAULT_SINE_MODE;
+	bool bandLimited = false;
+	InstructionSet instructionSet = InstructionSet::scalar;
+};
@@ -1,152 +1,853 @@
-/*
-  ==============================================================================
-
-	am_Oscillators.h
-	Created: 21 Nov 2022 10:01:20am
-	Author:  Andrew McGillivray
-
-  ==============================================================================
-*/
-#pragma once
-#ifndef Oscillators_h
-#define Oscillators_h
-#include <cmath>
-
-/**
-* NOTE: When using this class and its inheritance classes, all gains are set to oscillate between 1.0dB and -1.0dB.
-*/
-class Oscillator
-{
-public:
-
-	/**Sets up a basic oscillator completely
-	* @param sample rate in Hz
-	* @param frequency in Hz
-	* @param wave index: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
-	*/
-	void setUp(float sampleRate, float _freq, int waveIndex)
-	{
-		setSampleRate(sampleRate);
-		setFrequency(_freq);
-		setWaveIndex(waveIndex);
-	}
-
-
-	//Individual Functions
-	
-	//set the sample rate in Hz
-	void setSampleRate(float _sampleRate)
-	{
-		sampleRate = _sampleRate;
-	
-	}
-
-	//set the frequency of the wave in Hz
-	void setFrequency(float _freq)
-	{
-		freq = _freq;
-		phaseDelta = freq / sampleRate;
-	}
-
-	//sets where the phase will start
-	void setOffset(float offset)
-	{
-		phaseOffset = offset;
-	}
-
-
-
-	//Specific Functions
-
-	//set the wave index: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
-	void setWaveIndex(int waveIndex)
-	{
-		waveIndexVal = waveIndex;
-	}
-
-	//set phi value for a sine wave
-	void setPhi(float phiInput)
-	{
-		phi = phiInput;
-	}
-
-	//set the phi modulation value
-	void setPhiMod(float modInput)
-	{
-		phiMod = modInput;
-	}
-
-	//set phase width for a square wave
-	void setPhaseWidth(float _pw)
-	{
-		pw = _pw;
-	}
-
-
-	//Output Functions
-	
-	//creates a wave
-	//for Wave Index: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
-	float process()
-	{
-		phase += (phaseDelta + phaseOffset);
-		//wrap the phase
-
-		if (phase > 1.0)
-		{
-			phase -= 1.0;
-		}
-
-		//phasor
-		if (waveIndexVal == 0)
-		{
-			return phase;
-		}
-
-		//sine wave
-		if (waveIndexVal == 1)
-		{
-			return std::sin(phase * 2.0 * 3.14159 + (phi * phiMod));
-		}
-
-		//square wave
-		if (waveIndexVal == 2)
-		{
-			if (phase > pw)
-			{
-				outVal = -1.0f;
-			}
-			else
-			{
-				outVal = 1.0f;
-			}
-			return outVal;
-		}
-
-		//triangle wave
-		if (waveIndexVal == 3)
-		{
-			return 4 * (fabs(phase - 0.5f) - 0.25);
-		}
-
-		//sawtooth wave
-		if (waveIndexVal == 4)
-		{
-			return 2 * (phase - 0.5f);
-		}
-	}
-	
-private:
-	float freq;
-	float phase = 0.0f;
-	float phaseDelta;
-	float phaseOffset = 0.0f;
-	float sampleRate;
-	int waveIndexVal = 0;
-	float phi = 0;
-	float phiMod = 1;
-	float outVal;
-	float pw = 0.5;
-};
-
+/*
+  ==============================================================================
+
+	am_Oscillators.h
+	Created: 21 Nov 2022 10:01:20am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+#ifndef Oscillators_h
+#define Oscillators_h
+#include "am_FastSine.h"
+#include "am_FixedPhase.h"
+#include "am_ParameterRamp.h"
+#include "am_PolyBlep.h"
+#include <cmath>
+
+/**
+* NOTE: When using this class and its inheritance classes, all gains are set to oscillate between 1.0dB and -1.0dB.
+*/
+class Oscillator
+{
+public:
+
+	/**Sets up a basic oscillator completely
+	* @param sample rate in Hz
+	* @param frequency in Hz
+	* @param wave index: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+	*/
+	void setUp(float sampleRate, float _freq, int waveIndex)
+	{
+		setSampleRate(sampleRate);
+		setFrequency(_freq);
+		setWaveIndex(waveIndex);
+	}
+
+
+	//Individual Functions
+	
+	//set the sample rate in Hz. The frequency is kept, and a frequency ramp carries on to its target in the samples it has left.
+	void setSampleRate(float _sampleRate)
+	{
+		ramps.delta.scale(sampleRate / _sampleRate);
+		sampleRate = _sampleRate;
+		phaseDelta = ramps.delta.getCurrent();
+		updateFixedIncrement();
+	}
+
+	//set the frequency of the wave in Hz
+	void setFrequency(float _freq)
+	{
+		freq = _freq;
+		phaseDelta = freq / sampleRate;
+		ramps.delta.setCurrent(phaseDelta);
+		updateFixedIncrement();
+	}
+
+	//sets where the phase will start
+	void setOffset(float offset)
+	{
+		phaseOffset = offset;
+		ramps.offset.setCurrent(phaseOffset);
+		updateFixedIncrement();
+	}
+
+	//current position of the phasor in [0, 1] ([0, 1) in fixed point)
+	float getPhase() const
+	{
+		return phase;
+	}
+
+	//the frequency in Hz, which follows a frequency ramp as it moves
+	float getFrequency() const
+	{
+		return ramps.delta.isRamping() ? phaseDelta * sampleRate : freq;
+	}
+
+	//where a frequency ramp ends (the frequency itself when not ramping), the samples it has left and its curve
+	float getTargetFrequency() const
+	{
+		return freq;
+	}
+
+	int getFrequencyRampSamples() const
+	{
+		return ramps.delta.getRemainingSamples();
+	}
+
+	RampShape getFrequencyRampShape() const
+	{
+		return ramps.delta.getShape();
+	}
+
+	float getSampleRate() const
+	{
+		return sampleRate;
+	}
+
+	int getWaveIndex() const
+	{
+		return waveIndexVal;
+	}
+
+	float getPhaseWidth() const
+	{
+		return pw;
+	}
+
+	//the phi modulation value, or where a ramp of it is going
+	float getPhiMod() const
+	{
+		return ramps.phiMod.isRamping() ? ramps.phiMod.getTarget() : phiMod;
+	}
+
+
+
+	//Specific Functions
+
+	//set the wave index: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+	void setWaveIndex(int waveIndex)
+	{
+		waveIndexVal = waveIndex;
+	}
+
+	//set phi value for a sine wave
+	void setPhi(float phiInput)
+	{
+		phi = phiInput;
+	}
+
+	//set the phi modulation value
+	void setPhiMod(float modInput)
+	{
+		phiMod = modInput;
+		ramps.phiMod.setCurrent(phiMod);
+	}
+
+	//set phase width for a square wave
+	void setPhaseWidth(float _pw)
+	{
+		pw = _pw;
+		ramps.pw.setCurrent(pw);
+	}
+
+
+	//Ramps
+	//each moves a setting to a target over numSamples samples, one step per sample inside process() and the block
+	//functions. Calling the matching setter stops the ramp.
+
+	/**
+	*glide the frequency. The ramp runs on the phase increment, so it costs no division per sample.
+	*@param frequency to reach in Hz
+	*@param length of the glide in samples
+	*@param RampShape::exponential for a glide that is even in pitch, RampShape::linear for one even in Hz
+	*/
+	void rampFrequency(float targetFrequency, int numSamples, RampShape shape = RampShape::exponential)
+	{
+		ramps.delta.setCurrent(phaseDelta);
+		ramps.delta.rampTo(targetFrequency / sampleRate, numSamples, shape);
+		freq = targetFrequency;
+		phaseDelta = ramps.delta.getCurrent();
+		updateRamping();
+		updateFixedIncrement();
+	}
+
+	//ramp the phase offset added to the phase every sample (see setOffset())
+	void rampOffset(float targetOffset, int numSamples, RampShape shape = RampShape::linear)
+	{
+		startRamp(ramps.offset, phaseOffset, targetOffset, numSamples, shape);
+		updateFixedIncrement();
+	}
+
+	//ramp the phase width of the square wave
+	void rampPhaseWidth(float targetWidth, int numSamples, RampShape shape = RampShape::linear)
+	{
+		startRamp(ramps.pw, pw, targetWidth, numSamples, shape);
+	}
+
+	//ramp the phi modulation value (the modulation index when used in a PhiModulator)
+	void rampPhiMod(float targetMod, int numSamples, RampShape shape = RampShape::linear)
+	{
+		startRamp(ramps.phiMod, phiMod, targetMod, numSamples, shape);
+	}
+
+	//true while any ramp is moving
+	bool isRamping() const
+	{
+		return ramping;
+	}
+
+	/**
+	*choose how the sine wave is calculated (see am_FastSine.h for the error of each)
+	*@param SineMode::exact (std::sin), SineMode::polynomial or SineMode::table
+	*/
+	void setSineMode(SineMode mode)
+	{
+		sineMode = mode;
+
+		if (sineMode == SineMode::table)
+		{
+			FastSine::getTable();									//build the table now rather than on the audio thread
+		}
+	}
+
+	SineMode getSineMode() const
+	{
+		return sineMode;
+	}
+
+	/**
+	*choose band-limited (PolyBLEP) versions of the square, triangle and sawtooth waves.
+	*These have far less aliasing at high frequencies, so the plugin does not need oversampling for them.
+	*@param true for band-limited, false for the original naive waves
+	*/
+	void setBandLimited(bool shouldBandLimit)
+	{
+		bandLimited = shouldBandLimit;
+	}
+
+	bool isBandLimited() const
+	{
+		return bandLimited;
+	}
+
+	/**
+	*choose how the phase is kept (see am_FixedPhase.h). Fixed point has an exact frequency and wraps without a
+	*compare, so low notes stay in tune and long sessions do not drift. The current phase carries over.
+	*@param PhaseMode::floatingPoint or PhaseMode::fixedPoint
+	*/
+	void setPhaseMode(PhaseMode mode)
+	{
+		if (mode == PhaseMode::fixedPoint && phaseMode != PhaseMode::fixedPoint)
+		{
+			fixedPhase.setPhase(phase);
+		}
+		phaseMode = mode;
+		updateFixedIncrement();
+	}
+
+	PhaseMode getPhaseMode() const
+	{
+		return phaseMode;
+	}
+
+
+	//Parameters
+
+	//the settings a GUI changes, as one set that can be handed to the audio thread whole (see am_ParameterExchange.h)
+	struct Parameters
+	{
+		float frequency = 0.0f;			//Hz
+		float phaseWidth = 0.5f;		//square wave
+		float offset = 0.0f;			//see setOffset()
+		int waveIndex = 0;				//0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+	};
+
+	//applies a whole set through the setters above, so any ramps stop. Does not allocate.
+	void setParameters(const Parameters& parameters)
+	{
+		setFrequency(parameters.frequency);
+		setPhaseWidth(parameters.phaseWidth);
+		setOffset(parameters.offset);
+		setWaveIndex(parameters.waveIndex);
+	}
+
+	//the current set (targets, for ramps that are still moving)
+	Parameters getParameters() const
+	{
+		Parameters parameters;
+		parameters.frequency = freq;
+		parameters.phaseWidth = ramps.pw.isRamping() ? ramps.pw.getTarget() : pw;
+		parameters.offset = ramps.offset.isRamping() ? ramps.offset.getTarget() : phaseOffset;
+		parameters.waveIndex = waveIndexVal;
+		return parameters;
+	}
+
+
+	//Snapshots
+
+	static constexpr char snapshotTag[5] = "OSC ";
+
+	/**
+	*saves or restores the whole state of the oscillator: settings, phase (floating and fixed point) and any ramps
+	*part way through, so a restored oscillator carries on sample for sample (see am_Snapshot.h)
+	*@param SnapshotWriter or SnapshotReader
+	*/
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		archive.value(freq);
+		archive.value(phase);
+		archive.value(phaseDelta);
+		archive.value(phaseOffset);
+		archive.value(sampleRate);
+		archive.value(waveIndexVal);
+		archive.value(phi);
+		archive.value(phiMod);
+		archive.value(pw);
+		archive.value(sineMode);
+		archive.value(bandLimited);
+		archive.value(phaseMode);
+		fixedPhase.serialise(archive);
+		ramps.delta.serialise(archive);
+		ramps.offset.serialise(archive);
+		ramps.pw.serialise(archive);
+		ramps.phiMod.serialise(archive);
+
+		if (Archive::loading)
+		{
+			if (!archive.check(waveIndexVal >= 0 && waveIndexVal <= 4 && sampleRate > 0.0f && FastSine::isValidMode(sineMode)
+				&& (phaseMode == PhaseMode::floatingPoint || phaseMode == PhaseMode::fixedPoint)))
+			{
+				waveIndexVal = 0;										//a failed restore falls back to settings that are safe to render
+				sampleRate = 44100.0f;
+				sineMode = AM_DEFAULT_SINE_MODE;
+				phaseMode = PhaseMode::floatingPoint;
+			}
+			updateRamping();
+			setSineMode(sineMode);										//builds the sine table if it is needed
+		}
+	}
+
+
+	//Output Functions
+	
+	//creates a wave
+	//for Wave Index: 0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+	float process()
+	{
+		advance();
+
+		switch (waveIndexVal)
+		{
+			case 0: return waveValue<0>(phase, phi * phiMod);
+			case 1: return sineValue(phase, phi * phiMod);
+			case 2: return bandLimited ? bandLimitedValue<2>(phase, phaseDelta + phaseOffset) : waveValue<2>(phase, phi * phiMod);
+			case 3: return bandLimited ? bandLimitedValue<3>(phase, phaseDelta + phaseOffset) : waveValue<3>(phase, phi * phiMod);
+			case 4: return bandLimited ? bandLimitedValue<4>(phase, phaseDelta + phaseOffset) : waveValue<4>(phase, phi * phiMod);
+			default: return 0.0f;
+		}
+	}
+
+	/**
+	*moves on numSamples without making any output, leaving the oscillator exactly as if process() had been called
+	*numSamples times, ramps included (e.g. to start rendering part way through a piece). Once any ramp is over, a fixed
+	*point phase jumps straight there, so this takes the same time however far it goes. A floating-point phase has to
+	*land on the same rounding as process(), so it jumps a power of 2 at a time (see FloatPhase), a few steps a cycle.
+	*@param number of samples to skip
+	*/
+	void skipSamples(int64_t numSamples)
+	{
+		for (; numSamples > 0 && ramping; numSamples--)
+		{
+			advance();
+		}
+
+		if (numSamples <= 0)
+		{
+			return;
+		}
+
+		if (phaseMode == PhaseMode::fixedPoint)
+		{
+			fixedPhase.skip(uint64_t(numSamples));
+			phase = FixedPhase::toFloat(fixedPhase.getValue());
+		}
+		else
+		{
+			phase = FloatPhase::skip(phase, phaseDelta + phaseOffset, numSamples);
+		}
+	}
+
+	/**
+	*fills a buffer with the wave, overwriting what is already there.
+	*Sample-identical to calling process() numSamples times.
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		dispatchBlock<false>(out, numSamples);
+	}
+
+	/**
+	*adds the wave on top of what is already in the buffer (out[i] += process())
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		dispatchBlock<true>(out, numSamples);
+	}
+
+	/**
+	*fills a buffer with the wave while setting a new phi value for every sample.
+	*Equivalent to calling setPhi(phiIn[i]) then process() for each sample, as PhiModulator does.
+	*@param phi value for each sample
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlockWithPhi(const float* phiIn, float* out, int numSamples)
+	{
+		if (numSamples <= 0)
+		{
+			return;
+		}
+
+		if (waveIndexVal != 1)										//phi only affects the sine wave
+		{
+			processBlock(out, numSamples);
+		}
+		else if (ramping)
+		{
+			for (int i = 0; i < numSamples; i++)
+			{
+				phi = phiIn[i];
+				out[i] = process();
+			}
+		}
+		else if (phaseMode == PhaseMode::fixedPoint)
+		{
+			renderBlockWithPhi<true>(phiIn, out, numSamples);
+		}
+		else
+		{
+			renderBlockWithPhi<false>(phiIn, out, numSamples);
+		}
+
+		phi = phiIn[numSamples - 1];
+	}
+	
+private:
+
+	//every ramp. A ramp that is not moving holds the current value of its setting.
+	struct Ramps
+	{
+		ParameterRamp delta;									//phase increment, so frequency glides need no division
+		ParameterRamp offset;
+		ParameterRamp pw;
+		ParameterRamp phiMod;
+	};
+
+	//starts a linear or exponential ramp on one setting
+	void startRamp(ParameterRamp& ramp, float& value, float targetValue, int numSamples, RampShape shape)
+	{
+		ramp.setCurrent(value);
+		ramp.rampTo(targetValue, numSamples, shape);
+		value = ramp.getCurrent();
+		updateRamping();
+	}
+
+	//the exact fixed-point increment for the frequency and offset, i.e. where any ramp ends up
+	void updateFixedIncrement()
+	{
+		fixedPhase.setIncrement(double(freq) / double(sampleRate) + double(ramps.offset.getTarget()));
+	}
+
+	/**
+	*moves a phase on one sample. In floating point it wraps p with a compare; in fixed point it adds to the raw phase
+	*and p just follows it. The block loops are written once around this for both modes.
+	*@param phase in floating point
+	*@param raw phase in fixed point
+	*@param fixed-point increment
+	*@param floating-point increment
+	*@return the new phase in [0, 1]
+	*/
+	template <bool Fixed>
+	static float stepPhase(float p, uint64_t& fixed, uint64_t increment, float delta)
+	{
+		if constexpr (Fixed)
+		{
+			fixed += increment;
+			return FixedPhase::toFloat(fixed);
+		}
+		else
+		{
+			p += delta;
+			if (p > 1.0)
+			{
+				p -= 1.0;
+			}
+			return p;
+		}
+	}
+
+	//moves the ramps and the phase on one sample: everything process() does before it works out the wave
+	void advance()
+	{
+		const bool rampedThisSample = ramping;
+
+		if (ramping)
+		{
+			advanceRamps();
+			updateRamping();
+		}
+
+		if (phaseMode == PhaseMode::fixedPoint)
+		{
+			//while ramping the increment follows the ramp, afterwards it is the exact one for the frequency
+			const uint64_t increment = rampedThisSample ? FixedPhase::fromTurns(phaseDelta + phaseOffset) : fixedPhase.getIncrement();
+			uint64_t fixed = fixedPhase.getValue();
+			phase = stepPhase<true>(phase, fixed, increment, 0.0f);
+			fixedPhase.setValue(fixed);
+		}
+		else
+		{
+			phase += (phaseDelta + phaseOffset);
+			//wrap the phase
+
+			if (phase > 1.0)
+			{
+				phase -= 1.0;
+			}
+		}
+	}
+
+	void updateRamping()
+	{
+		ramping = ramps.delta.isRamping() || ramps.offset.isRamping() || ramps.pw.isRamping() || ramps.phiMod.isRamping();
+	}
+
+	//samples until every ramp has finished
+	int rampSamplesLeft() const
+	{
+		int left = ramps.delta.getRemainingSamples();
+		left = left > ramps.offset.getRemainingSamples() ? left : ramps.offset.getRemainingSamples();
+		left = left > ramps.pw.getRemainingSamples() ? left : ramps.pw.getRemainingSamples();
+		left = left > ramps.phiMod.getRemainingSamples() ? left : ramps.phiMod.getRemainingSamples();
+		return left;
+	}
+
+	//moves every ramp on one sample. A ramp that is not moving just holds its setting, so no checks are needed here;
+	//callers update the ramping flag once afterwards.
+	void advanceRamps()
+	{
+		phaseDelta = ramps.delta.next();
+		phaseOffset = ramps.offset.next();
+		pw = ramps.pw.next();
+		phiMod = ramps.phiMod.next();
+	}
+
+	//the block loops move a local copy of the ramps so it can stay in registers, then store it back with this
+	void storeRamps(const Ramps& local)
+	{
+		ramps = local;
+		phaseDelta = local.delta.getCurrent();
+		phaseOffset = local.offset.getCurrent();
+		pw = local.pw.getCurrent();
+		phiMod = local.phiMod.getCurrent();
+	}
+
+	//the sine angle in turns for the fast sine engines. Same angle as the exact sine: phase * 2 * 3.14159 + phaseModulation radians.
+	static float toTurns(float p, float phaseModulation)
+	{
+		return (p * 6.28318f + phaseModulation) * 0.159154943f;
+	}
+
+	//sine wave with whichever engine is selected
+	float sineValue(float p, float phaseModulation) const
+	{
+		if (sineMode == SineMode::exact)
+		{
+			return waveValue<1>(p, phaseModulation);
+		}
+		return FastSine::sinTurns(toTurns(p, phaseModulation), sineMode);
+	}
+
+	//the output of a single wave at a given phase. Kept in one place so process() and the block functions always agree.
+	template <int WaveIndex>
+	float waveValue(float p, float phaseModulation) const
+	{
+		if constexpr (WaveIndex == 0)								//phasor
+		{
+			return p;
+		}
+		else if constexpr (WaveIndex == 1)							//sine wave
+		{
+			return std::sin(p * 2.0 * 3.14159 + phaseModulation);
+		}
+		else if constexpr (WaveIndex == 2)							//square wave
+		{
+			return p > pw ? -1.0f : 1.0f;
+		}
+		else if constexpr (WaveIndex == 3)							//triangle wave
+		{
+			return 4 * (fabs(p - 0.5f) - 0.25);
+		}
+		else														//sawtooth wave
+		{
+			return 2 * (p - 0.5f);
+		}
+	}
+
+	//band-limited square, triangle and sawtooth waves. dt is the phase increment per sample.
+	template <int WaveIndex>
+	float bandLimitedValue(float p, float dt) const
+	{
+		dt = std::fabs(dt);
+
+		if constexpr (WaveIndex == 2)
+		{
+			return PolyBlep::square(p, pw, dt);
+		}
+		else if constexpr (WaveIndex == 3)
+		{
+			return PolyBlep::triangle(p, dt);
+		}
+		else
+		{
+			return PolyBlep::sawtooth(p, dt);
+		}
+	}
+
+	//renders the part of the block where ramps are moving with the ramping loops, and the rest with the plain ones
+	template <bool Add>
+	void dispatchBlock(float* out, int numSamples)
+	{
+		if (phaseMode == PhaseMode::fixedPoint)
+		{
+			dispatchBlock<Add, true>(out, numSamples);
+		}
+		else
+		{
+			dispatchBlock<Add, false>(out, numSamples);
+		}
+	}
+
+	template <bool Add, bool Fixed>
+	void dispatchBlock(float* out, int numSamples)
+	{
+		if (ramping && numSamples > 0)
+		{
+			const int rampPart = numSamples < rampSamplesLeft() ? numSamples : rampSamplesLeft();
+			dispatchSegment<Add, true, Fixed>(out, rampPart);
+			updateRamping();
+			out += rampPart;
+			numSamples -= rampPart;
+		}
+
+		if (numSamples > 0)
+		{
+			dispatchSegment<Add, false, Fixed>(out, numSamples);
+		}
+	}
+
+	//picks the wave once per block rather than once per sample
+	template <bool Add, bool Ramping, bool Fixed>
+	void dispatchSegment(float* out, int numSamples)
+	{
+		switch (waveIndexVal)
+		{
+			case 0: renderBlock<0, Add, false, Ramping, Fixed>(out, numSamples); break;
+			case 1:
+				if (sineMode == SineMode::exact)
+				{
+					renderBlock<1, Add, false, Ramping, Fixed>(out, numSamples);
+				}
+				else
+				{
+					renderFastSineBlock<Add, Ramping, Fixed>(out, numSamples);
+				}
+				break;
+			case 2: bandLimited ? renderBlock<2, Add, true, Ramping, Fixed>(out, numSamples) : renderBlock<2, Add, false, Ramping, Fixed>(out, numSamples); break;
+			case 3: bandLimited ? renderBlock<3, Add, true, Ramping, Fixed>(out, numSamples) : renderBlock<3, Add, false, Ramping, Fixed>(out, numSamples); break;
+			case 4: bandLimited ? renderBlock<4, Add, true, Ramping, Fixed>(out, numSamples) : renderBlock<4, Add, false, Ramping, Fixed>(out, numSamples); break;
+			default:
+			{
+				uint64_t fixed = fixedPhase.getValue();
+				for (int i = 0; i < numSamples; i++)
+				{
+					if (Ramping)
+					{
+						advanceRamps();
+					}
+					const uint64_t increment = Ramping ? FixedPhase::fromTurns(phaseDelta + phaseOffset) : fixedPhase.getIncrement();
+					phase = stepPhase<Fixed>(phase, fixed, increment, phaseDelta + phaseOffset);
+					if (!Add)
+					{
+						out[i] = 0.0f;
+					}
+				}
+				fixedPhase.setValue(fixed);
+				break;
+			}
+		}
+	}
+
+	//inner loop with every parameter read hoisted into locals. While ramping they are moved on every sample instead.
+	template <int WaveIndex, bool Add, bool BandLimited = false, bool Ramping = false, bool Fixed = false>
+	void renderBlock(float* out, int numSamples)
+	{
+		float p = phase;
+		float delta = phaseDelta + phaseOffset;
+		float phaseModulation = phi * phiMod;
+		Ramps local = ramps;
+		uint64_t fixed = fixedPhase.getValue();
+		uint64_t increment = fixedPhase.getIncrement();
+
+		for (int i = 0; i < numSamples; i++)
+		{
+			if constexpr (Ramping)
+			{
+				delta = local.delta.next() + local.offset.next();
+				pw = local.pw.next();
+				phaseModulation = phi * local.phiMod.next();
+
+				if constexpr (Fixed)
+				{
+					increment = FixedPhase::fromTurns(delta);
+				}
+			}
+
+			p = stepPhase<Fixed>(p, fixed, increment, delta);
+
+			float value;
+			if constexpr (BandLimited)
+			{
+				value = bandLimitedValue<WaveIndex>(p, delta);
+			}
+			else
+			{
+				value = waveValue<WaveIndex>(p, phaseModulation);
+			}
+
+			if (Add)
+			{
+				out[i] += value;
+			}
+			else
+			{
+				out[i] = value;
+			}
+		}
+		phase = p;
+		fixedPhase.setValue(fixed);
+
+		if constexpr (Ramping)
+		{
+			storeRamps(local);
+		}
+	}
+
+	//sine with a fast engine: accumulate the phase into a scratch buffer, then run the sine over it in one vectorized pass
+	template <bool Add, bool Ramping, bool Fixed>
+	void renderFastSineBlock(float* out, int numSamples)
+	{
+		float turns[scratchSize];
+		float delta = phaseDelta + phaseOffset;
+		float phaseModulation = phi * phiMod;
+		Ramps local = ramps;
+		uint64_t fixed = fixedPhase.getValue();
+		uint64_t increment = fixedPhase.getIncrement();
+
+		for (int start = 0; start < numSamples; start += scratchSize)
+		{
+			const int chunk = numSamples - start < scratchSize ? numSamples - start : scratchSize;
+
+			float p = phase;
+			for (int i = 0; i < chunk; i++)
+			{
+				if constexpr (Ramping)
+				{
+					delta = local.delta.next() + local.offset.next();
+					phaseModulation = phi * local.phiMod.next();
+					local.pw.next();
+
+					if constexpr (Fixed)
+					{
+						increment = FixedPhase::fromTurns(delta);
+					}
+				}
+
+				p = stepPhase<Fixed>(p, fixed, increment, delta);
+				turns[i] = toTurns(p, phaseModulation);
+			}
+			phase = p;
+
+			if (Add)
+			{
+				FastSine::sinTurnsBlock(turns, turns, chunk, sineMode);
+				for (int i = 0; i < chunk; i++)
+				{
+					out[start + i] += turns[i];
+				}
+			}
+			else
+			{
+				FastSine::sinTurnsBlock(turns, out + start, chunk, sineMode);
+			}
+		}
+		fixedPhase.setValue(fixed);
+
+		if constexpr (Ramping)
+		{
+			storeRamps(local);
+		}
+	}
+
+	//the sine with a new phi every sample (see processBlockWithPhi())
+	template <bool Fixed>
+	void renderBlockWithPhi(const float* phiIn, float* out, int numSamples)
+	{
+		float p = phase;
+		const float delta = phaseDelta + phaseOffset;
+		const float mod = phiMod;
+		uint64_t fixed = fixedPhase.getValue();
+		const uint64_t increment = fixedPhase.getIncrement();
+
+		if (sineMode == SineMode::exact)
+		{
+			for (int i = 0; i < numSamples; i++)
+			{
+				p = stepPhase<Fixed>(p, fixed, increment, delta);
+				out[i] = waveValue<1>(p, phiIn[i] * mod);
+			}
+		}
+		else
+		{
+			for (int i = 0; i < numSamples; i++)					//the phase has to be accumulated in order...
+			{
+				p = stepPhase<Fixed>(p, fixed, increment, delta);
+				out[i] = toTurns(p, phiIn[i] * mod);
+			}
+
+			FastSine::sinTurnsBlock(out, out, numSamples, sineMode);	//...but the sine of it can be done in one vectorized pass
+		}
+
+		phase = p;
+		fixedPhase.setValue(fixed);
+	}
+
+	static constexpr int scratchSize = 64;						//samples per pass in renderFastSineBlock
+
+	float freq = 0.0f;
+	float phase = 0.0f;
+	float phaseDelta = 0.0f;
+	float phaseOffset = 0.0f;
+	float sampleRate = 44100.0f;
+	int waveIndexVal = 0;
+	float phi = 0;
+	float phiMod = 1;
+	float pw = 0.5;
+	SineMode sineMode = AM_DEFAULT_SINE_MODE;
+	bool bandLimited = false;
+	PhaseMode phaseMode = PhaseMode::floatingPoint;
+	FixedPhase fixedPhase;										//the phase in fixed point; phase follows it
+
+	Ramps ramps;
+	bool ramping = false;										//true while any ramp is moving
+};
+
 #endif /* Oscillators_h */
\ No newline at end of file
@@ -0,0 +1,672 @@
+/*
+  ==============================================================================
+
+	am_Oversampler.h
+	Created: 17 Oct 2026 11:32:40pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+//the kind of half-band filters an Oversampler uses
+enum class OversamplingPhase
+{
+	linear = 0,			//symmetric FIR: no phase distortion, a few samples of latency
+	minimum				//polyphase IIR allpass: sharper and almost no latency, but the phase is bent near Nyquist
+};
+
+/**
+*A 2x half-band FIR (Kaiser windowed sinc) in polyphase form.
+*
+*Every other coefficient of a half-band filter is 0 except the centre one, which is 0.5. Splitting the high-rate signal
+*into its even and odd samples leaves one multiply for the evens and one multiply per symmetric pair of odds, and each
+*pass over the block is a plain loop over contiguous arrays that the compiler vectorizes (SSE/AVX).
+*/
+class HalfbandFir
+{
+public:
+	static constexpr int maxCoefficients = 16;					//non-zero coefficients on each side of the centre
+	static constexpr int maxBlock = 256;						//low-rate samples per internal pass
+
+	/**
+	*designs the filter
+	*@param non-zero coefficients on each side of the centre (at most maxCoefficients), 4 * count - 1 taps in all
+	*@param Kaiser window beta: higher for more stopband attenuation but a wider transition band
+	*/
+	void setUp(int numCoefficients, double beta)
+	{
+		count = std::min(std::max(numCoefficients, 1), maxCoefficients);
+
+		double sum = 0.0;
+		for (int k = 0; k < count; k++)
+		{
+			const int m = 2 * k + 1;									//distance from the centre tap
+			const double ratio = double(m) / double(2 * count - 1);
+			const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / besselI0(beta);
+			const double value = std::sin(3.14159265358979323846 * m / 2.0) / (3.14159265358979323846 * m) * window;
+			coefficients[k] = value;
+			sum += 2.0 * value;
+		}
+
+		for (int k = 0; k < count; k++)
+		{
+			coefficients[k] *= 0.5 / sum;								//the odd taps add up to 0.5, so the DC gain is exactly 1
+			gains[k] = float(coefficients[k]);
+		}
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(history, history + 2 * maxCoefficients, 0.0f);
+		std::fill(evenHistory, evenHistory + maxCoefficients, 0.0f);
+	}
+
+	//delay in high-rate samples
+	double getLatency() const
+	{
+		return double(2 * count - 1);
+	}
+
+	/**
+	*filters and halves the rate
+	*@param high-rate input, 2 * numOut samples
+	*@param low-rate output (may be the same buffer as the input)
+	*@param number of low-rate samples to make
+	*/
+	void downsample(const float* in, float* out, int numOut)
+	{
+		for (int start = 0; start < numOut; start += maxBlock)
+		{
+			const int n = std::min(maxBlock, numOut - start);
+			downsampleBlock(in + 2 * start, out + start, n);
+		}
+	}
+
+	/**
+	*doubles the rate and filters out the images
+	*@param low-rate input, numIn samples
+	*@param high-rate output, 2 * numIn samples (must not overlap the input)
+	*@param number of low-rate input samples
+	*/
+	void upsample(const float* in, float* out, int numIn)
+	{
+		for (int start = 0; start < numIn; start += maxBlock)
+		{
+			const int n = std::min(maxBlock, numIn - start);
+			upsampleBlock(in + start, out + 2 * start, n);
+		}
+	}
+
+private:
+
+	//y[n] = 0.5 * even[n + 1 - K] + sum over k of c[k] * (odd[n - K - k] + odd[n + 1 - K + k])
+	void downsampleBlock(const float* in, float* out, int n)
+	{
+		const int oddHistory = 2 * count - 1;
+		const int evenDelay = count - 1;
+
+		for (int i = 0; i < n; i++)
+		{
+			odd[oddHistory + i] = in[2 * i + 1];
+			even[evenDelay + i] = in[2 * i];
+		}
+		std::copy(history, history + oddHistory, odd);
+		std::copy(evenHistory, evenHistory + evenDelay, even);
+
+		float sums[maxBlock];
+		for (int i = 0; i < n; i++)
+		{
+			sums[i] = 0.5f * even[i];
+		}
+		for (int k = 0; k < count; k++)
+		{
+			const float c = gains[k];
+			const float* early = odd + count - 1 - k;
+			const float* late = odd + count + k;
+			for (int i = 0; i < n; i++)
+			{
+				sums[i] += c * (early[i] + late[i]);
+			}
+		}
+
+		std::copy(odd + n, odd + n + oddHistory, history);
+		std::copy(even + n, even + n + evenDelay, evenHistory);
+		std::copy(sums, sums + n, out);
+	}
+
+	//z[2n] = 2 * sum over k of c[k] * (u[n - K - k] + u[n + 1 - K + k]), z[2n + 1] = u[n + 1 - K]
+	void upsampleBlock(const float* in, float* out, int n)
+	{
+		const int delay = 2 * count - 1;
+
+		std::copy(history, history + delay, odd);
+		std::copy(in, in + n, odd + delay);
+
+		float sums[maxBlock] = {};
+		for (int k = 0; k < count; k++)
+		{
+			const float c = 2.0f * gains[k];
+			const float* early = odd + count - 1 - k;
+			const float* late = odd + count + k;
+			for (int i = 0; i < n; i++)
+			{
+				sums[i] += c * (early[i] + late[i]);
+			}
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			out[2 * i] = sums[i];
+			out[2 * i + 1] = odd[count + i];
+		}
+
+		std::copy(odd + n, odd + n + delay, history);
+	}
+
+	//modified Bessel function of the first kind, order 0, for the Kaiser window
+	static double besselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 50; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	int count = 1;
+	double coefficients[maxCoefficients] = {};
+	float gains[maxCoefficients] = {};
+	float history[2 * maxCoefficients] = {};					//last odd (downsample) or input (upsample) samples
+	float evenHistory[maxCoefficients] = {};
+	float odd[maxBlock + 2 * maxCoefficients] = {};
+	float even[maxBlock + maxCoefficients] = {};
+};
+
+/**
+*A 2x half-band IIR made of two parallel chains of first-order allpass filters running at the low rate (the polyphase
+*structure of Valenzuela and Constantinides). The coefficients come from an elliptic prototype, designed for a
+*stopband attenuation and transition band, so it gets the same rejection as a long FIR from a handful of multiplies.
+*The phase is not linear, but the latency is only a sample or two.
+*/
+class HalfbandIir
+{
+public:
+	static constexpr int maxCoefficients = 16;
+
+	/**
+	*designs the filter
+	*@param stopband attenuation in dB
+	*@param transition band as a fraction of the high sample rate, in (0, 0.5): the passband ends at 0.25 - transition
+	*/
+	void setUp(double attenuationDb, double transition)
+	{
+		double k = 0.0;
+		double q = 0.0;
+		transitionParameters(transition, k, q);
+
+		//the order the elliptic prototype needs for the attenuation (always odd)
+		const double power = std::pow(10.0, -attenuationDb / 10.0);
+		const double a = power / (1.0 - power);
+		int order = int(std::ceil(std::log(a * a / 16.0) / std::log(q)));
+		order += (order & 1) == 0 ? 1 : 0;
+		order = std::max(order, 3);
+
+		count = std::min((order - 1) / 2, maxCoefficients);
+		order = 2 * count + 1;
+
+		for (int index = 0; index < count; index++)
+		{
+			coefficients[index] = float(coefficient(index + 1, k, q, order));
+		}
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(x, x + maxCoefficients, 0.0f);
+		std::fill(y, y + maxCoefficients, 0.0f);
+	}
+
+	int getNumCoefficients() const
+	{
+		return count;
+	}
+
+	//delay at low frequencies in high-rate samples: the average of the two allpass chains' group delays
+	double getLatency() const
+	{
+		double pathDelay[2] = { 0.0, 1.0 };								//the second chain sees the odd samples, one later
+		for (int i = 0; i < count; i++)
+		{
+			const double c = coefficients[i];
+			pathDelay[i & 1] += 2.0 * (1.0 - c) / (1.0 + c);			//one section at the low rate, in high-rate samples
+		}
+		return 0.5 * (pathDelay[0] + pathDelay[1]);
+	}
+
+	/**
+	*filters and halves the rate
+	*@param high-rate input, 2 * numOut samples
+	*@param low-rate output (may be the same buffer as the input)
+	*@param number of low-rate samples to make
+	*/
+	void downsample(const float* in, float* out, int numOut)
+	{
+		for (int i = 0; i < numOut; i++)
+		{
+			float pathOne = in[2 * i + 1];
+			float pathTwo = in[2 * i];
+			runChains(pathOne, pathTwo);
+			out[i] = 0.5f * (pathOne + pathTwo);
+		}
+	}
+
+	/**
+	*doubles the rate and filters out the images
+	*@param low-rate input, numIn samples
+	*@param high-rate output, 2 * numIn samples (must not overlap the input)
+	*@param number of low-rate input samples
+	*/
+	void upsample(const float* in, float* out, int numIn)
+	{
+		for (int i = 0; i < numIn; i++)
+		{
+			float pathOne = in[i];
+			float pathTwo = in[i];
+			runChains(pathOne, pathTwo);
+			out[2 * i] = pathOne;
+			out[2 * i + 1] = pathTwo;
+		}
+	}
+
+private:
+
+	//one low-rate sample through both allpass chains. Even coefficients are the first chain, odd ones the second, and
+	//the two are interleaved so the CPU can work on both at once.
+	void runChains(float& pathOne, float& pathTwo)
+	{
+		int i = 0;
+		for (; i + 1 < count; i += 2)
+		{
+			const float inOne = pathOne;
+			const float inTwo = pathTwo;
+			pathOne = (inOne - y[i]) * coefficients[i] + x[i];
+			pathTwo = (inTwo - y[i + 1]) * coefficients[i + 1] + x[i + 1];
+			x[i] = inOne;
+			x[i + 1] = inTwo;
+			y[i] = pathOne;
+			y[i + 1] = pathTwo;
+		}
+		if (i < count)
+		{
+			const float inOne = pathOne;
+			pathOne = (inOne - y[i]) * coefficients[i] + x[i];
+			x[i] = inOne;
+			y[i] = pathOne;
+		}
+	}
+
+	//elliptic modulus k and nome q for a transition band
+	static void transitionParameters(double transition, double& k, double& q)
+	{
+		k = std::tan((1.0 - transition * 2.0) * 3.14159265358979323846 / 4.0);
+		k *= k;
+		const double kSqrt = std::pow(1.0 - k * k, 0.25);
+		const double e = 0.5 * (1.0 - kSqrt) / (1.0 + kSqrt);
+		const double e4 = e * e * e * e;
+		q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+	}
+
+	static double coefficient(int c, double k, double q, int order)
+	{
+		const double pi = 3.14159265358979323846;
+
+		double numerator = 0.0;
+		double term = 0.0;
+		int i = 0;
+		double sign = 1.0;
+		do
+		{
+			term = std::pow(q, double(i * (i + 1))) * std::sin((i * 2 + 1) * c * pi / order) * sign;
+			numerator += term;
+			sign = -sign;
+			i++;
+		}
+		while (std::fabs(term) > 1e-100 && i < 100);
+		numerator *= std::pow(q, 0.25);
+
+		double denominator = 0.0;
+		i = 1;
+		sign = -1.0;
+		do
+		{
+			term = std::pow(q, double(i * i)) * std::cos(i * 2 * c * pi / order) * sign;
+			denominator += term;
+			sign = -sign;
+			i++;
+		}
+		while (std::fabs(term) > 1e-100 && i < 100);
+		denominator += 0.5;
+
+		const double ww = numerator / denominator;
+		const double wwSquared = ww * ww;
+		const double xx = std::sqrt((1.0 - wwSquared * k) * (1.0 - wwSquared / k)) / (1.0 + wwSquared);
+		return (1.0 - xx) / (1.0 + xx);
+	}
+
+	int count = 0;
+	float coefficients[maxCoefficients] = {};
+	float x[maxCoefficients] = {};								//previous input of each allpass section
+	float y[maxCoefficients] = {};								//previous output of each allpass section
+};
+
+/**
+*Changes the sample rate by 2, 4 or 8 with a cascade of 2x half-band stages.
+*
+*The stage next to the base rate is the sharpest (its passband goes up to about 20kHz at 48kHz). Each stage above it
+*only has to keep the images of that band away, so it gets a much wider transition band and fewer coefficients.
+*/
+class Oversampler
+{
+public:
+	static constexpr int maxFactor = 8;
+
+	/**
+	*chooses the factor and filters, and clears the filter state
+	*@param oversampling factor: 1, 2, 4 or 8 (others are rounded down to one of these)
+	*@param linear (FIR) or minimum (IIR) phase filters
+	*/
+	void setUp(int _factor, OversamplingPhase _phase)
+	{
+		phase = _phase;
+		numStages = _factor >= 8 ? 3 : _factor >= 4 ? 2 : _factor >= 2 ? 1 : 0;
+		factor = 1 << numStages;
+
+		//stage 0 works between the base rate and 2x, stage 2 between 4x and 8x
+		static constexpr int firCoefficients[3] = { 16, 6, 4 };
+		static constexpr double iirTransition[3] = { 0.04, 0.14, 0.19 };
+
+		for (int stage = 0; stage < numStages; stage++)
+		{
+			firDown[stage].setUp(firCoefficients[stage], 7.86);			//about 75dB down in the stopband
+			iirDown[stage].setUp(96.0, iirTransition[stage]);
+			firUp[stage] = firDown[stage];
+			iirUp[stage] = iirDown[stage];
+		}
+	}
+
+	int getFactor() const
+	{
+		return factor;
+	}
+
+	OversamplingPhase getPhase() const
+	{
+		return phase;
+	}
+
+	//delay downsample() adds, in base-rate samples at low frequencies
+	double getDownsamplingLatency() const
+	{
+		return totalLatency(-1.0);
+	}
+
+	//delay upsample() adds, in base-rate samples at low frequencies
+	double getUpsamplingLatency() const
+	{
+		return totalLatency(0.0);
+	}
+
+	void reset()
+	{
+		for (int stage = 0; stage < numStages; stage++)
+		{
+			firDown[stage].reset();
+			firUp[stage].reset();
+			iirDown[stage].reset();
+			iirUp[stage].reset();
+		}
+	}
+
+	/**
+	*filters a high-rate buffer and brings it down to the base rate
+	*@param input at factor times the base rate, factor * numOut samples. It is used as scratch and overwritten.
+	*@param base-rate output, numOut samples
+	*@param number of base-rate samples to make
+	*/
+	void downsample(float* in, float* out, int numOut)
+	{
+		if (numStages == 0)
+		{
+			std::copy(in, in + numOut, out);
+			return;
+		}
+
+		for (int stage = numStages - 1; stage >= 0; stage--)
+		{
+			float* target = stage == 0 ? out : in;
+			const int samples = numOut << stage;
+
+			if (phase == OversamplingPhase::linear)
+			{
+				firDown[stage].downsample(in, target, samples);
+			}
+			else
+			{
+				iirDown[stage].downsample(in, target, samples);
+			}
+		}
+	}
+
+	/**
+	*brings a base-rate buffer up to factor times the base rate
+	*@param base-rate input, numIn samples
+	*@param high-rate output, factor * numIn samples (must not overlap the input)
+	*@param number of base-rate input samples, at most maxBlock
+	*/
+	void upsample(const float* in, float* out, int numIn)
+	{
+		const float* source = in;
+		float scratch[maxFactor / 2 * maxBlock];
+
+		for (int stage = 0; stage < numStages; stage++)
+		{
+			const int samples = numIn << stage;
+
+			//ping-pong so the last stage lands in out
+			float* target = ((numStages - 1 - stage) & 1) == 0 ? out : scratch;
+
+			if (phase == OversamplingPhase::linear)
+			{
+				firUp[stage].upsample(source, target, samples);
+			}
+			else
+			{
+				iirUp[stage].upsample(source, target, samples);
+			}
+			source = target;
+		}
+
+		if (numStages == 0)
+		{
+			std::copy(in, in + numIn, out);
+		}
+	}
+
+	static constexpr int maxBlock = 64;								//base-rate samples upsample() takes at a time
+
+private:
+
+	//a stage's delay is its group delay as a filter at the high rate, less one high-rate sample when it downsamples
+	//(each output lines up with the first of the two inputs it is made from)
+	double totalLatency(double adjustment) const
+	{
+		double latency = 0.0;
+		for (int stage = 0; stage < numStages; stage++)
+		{
+			const double stageLatency = phase == OversamplingPhase::linear ? firDown[stage].getLatency() : iirDown[stage].getLatency();
+			latency += (stageLatency + adjustment) / double(2 << stage);
+		}
+		return latency;
+	}
+
+	int factor = 1;
+	int numStages = 0;
+	OversamplingPhase phase = OversamplingPhase::linear;
+	HalfbandFir firDown[3];										//each direction keeps its own filter state
+	HalfbandFir firUp[3];
+	HalfbandIir iirDown[3];
+	HalfbandIir iirUp[3];
+};
+
+/**
+*Runs a generator (e.g. PhiModulator or FMEngine) at 2x, 4x or 8x the sample rate and filters it back down, so the
+*sidebands of a bright FM patch that go past Nyquist are filtered out instead of folding back as aliasing. Only the
+*wrapped generator pays for the higher rate; the rest of the signal chain stays at the base rate.
+*
+*Set the generator up with getOversampledRate() as its sample rate, e.g.
+*	Oversampled<PhiModulator> fm;
+*	fm.setOversampling(48000.0f, 4, OversamplingPhase::minimum);
+*	fm.get().setUpPhiModulator(fm.getOversampledRate(), 220.0f, 1, 110.0f, 1, 8.0f);
+*
+*The generator needs processBlock(float*, int).
+*/
+template <class Generator>
+class Oversampled
+{
+public:
+
+	/**
+	*chooses the oversampling. Call it before setting up the generator, which must then be given getOversampledRate().
+	*@param base sample rate in Hz
+	*@param factor: 1, 2, 4 or 8
+	*@param linear or minimum phase filters
+	*/
+	void setOversampling(float _sampleRate, int factor, OversamplingPhase phase)
+	{
+		sampleRate = _sampleRate;
+		oversampler.setUp(factor, phase);
+	}
+
+	float getOversampledRate() const
+	{
+		return sampleRate * float(oversampler.getFactor());
+	}
+
+	int getFactor() const
+	{
+		return oversampler.getFactor();
+	}
+
+	//delay the downsampling filters add, in base-rate samples
+	double getLatency() const
+	{
+		return oversampler.getDownsamplingLatency();
+	}
+
+	Generator& get()
+	{
+		return generator;
+	}
+
+	const Generator& get() const
+	{
+		return generator;
+	}
+
+	//clears the filters (the generator is left alone)
+	void reset()
+	{
+		oversampler.reset();
+	}
+
+	float process()
+	{
+		float out;
+		processBlock(&out, 1);
+		return out;
+	}
+
+	/**
+	*fills a buffer at the base rate, overwriting what is already there
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		float high[Oversampler::maxFactor * scratchSize];
+		const int factor = oversampler.getFactor();
+
+		for (int start = 0; start < numSamples; start += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - start);
+			generator.processBlock(high, chunk * factor);
+			oversampler.downsample(high, out + start, chunk);
+		}
+	}
+
+	/**
+	*adds the base-rate output on top of what is already in the buffer
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		float low[scratchSize];
+
+		for (int start = 0; start < numSamples; start += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - start);
+			processBlock(low, chunk);
+
+			for (int i = 0; i < chunk; i++)
+			{
+				out[start + i] += low[i];
+			}
+		}
+	}
+
+	/**
+	*moves on numSamples at the base rate. The generator skips ahead without rendering (it needs
+	*skipSamples(int64_t)); only the last settleSamples are rendered again, into the filters, so they hold what they
+	*would have. Linear phase filters then match exactly; minimum phase ones, whose memory never quite ends, to within
+	*float rounding.
+	*@param number of base-rate samples to skip
+	*/
+	void skipSamples(int64_t numSamples)
+	{
+		const int64_t rendered = std::min<int64_t>(std::max<int64_t>(numSamples, 0), settleSamples);
+
+		if (numSamples > rendered)
+		{
+			generator.skipSamples((numSamples - rendered) * oversampler.getFactor());
+			oversampler.reset();
+		}
+
+		float discard[scratchSize];
+		for (int64_t done = 0; done < rendered; done += scratchSize)
+		{
+			processBlock(discard, int(std::min<int64_t>(scratchSize, rendered - done)));
+		}
+	}
+
+	static constexpr int settleSamples = 4096;						//base-rate samples skipSamples() runs through the filters
+
+private:
+	static constexpr int scratchSize = 64;
+
+	Generator generator;
+	Oversampler oversampler;
+	float sampleRate = 44100.0f;
+};
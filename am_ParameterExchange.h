@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+	am_ParameterExchange.h
+	Created: 17 Oct 2026 11:41:12pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+*Hands a whole set of parameters from the GUI (message) thread to the audio thread without a lock, so the setters are
+*never called on one thread while the other is rendering.
+*
+*It is a triple buffer: the writer fills one copy, the reader owns another, and the third sits in the middle holding
+*the newest finished set. write() fills its copy and swaps it into the middle; update() on the audio thread swaps the
+*middle out only if something new was written. Each side is one atomic exchange and never waits for the other, and the
+*reader only ever sees complete sets, never half of one write and half of the next. Writes the audio thread has not
+*picked up yet are replaced by newer ones.
+*
+*The classes have a Parameters struct with setParameters() and getParameters() for this. Once per block, at the top of
+*the callback:
+*
+*	ParameterExchange<DoubleCombFilter::Parameters> combParameters;		//a member next to the filter
+*	combParameters.write(parameters);									//message thread, whenever a control moves
+*	combParameters.applyTo(comb);										//audio thread, before comb.processBlock()
+*
+*Only one thread may write and one thread may read.
+*@tparam the set of parameters, copied whole on the writer's thread
+*/
+template <class Parameters>
+class ParameterExchange
+{
+public:
+
+	ParameterExchange() = default;
+
+	//starts every copy at the same set, e.g. the object's getParameters(), so latest() is meaningful before any write()
+	explicit ParameterExchange(const Parameters& initial)
+	{
+		for (auto& slot : slots)
+		{
+			slot = initial;
+		}
+	}
+
+	ParameterExchange(const ParameterExchange&) = delete;
+	ParameterExchange& operator=(const ParameterExchange&) = delete;
+
+	//writer thread only: publishes a complete set for the audio thread's next update()
+	void write(const Parameters& parameters)
+	{
+		slots[writeIndex] = parameters;
+		writeIndex = middle.exchange(uint8_t(writeIndex | freshBit), std::memory_order_acq_rel) & indexMask;
+	}
+
+	/**
+	*reader thread only: takes the newest set if there is one the reader has not seen
+	*@return true if latest() changed
+	*/
+	bool update()
+	{
+		if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+		{
+			return false;
+		}
+
+		readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+
+	//reader thread only: the set taken by the last update() that returned true
+	const Parameters& latest() const
+	{
+		return slots[readIndex];
+	}
+
+	/**
+	*reader thread only: update(), then hands any new set to target.setParameters(). Costs one relaxed load when
+	*nothing has changed.
+	*@return true if the target was given a new set
+	*/
+	template <class Target>
+	bool applyTo(Target& target)
+	{
+		if (!update())
+		{
+			return false;
+		}
+
+		target.setParameters(slots[readIndex]);
+		return true;
+	}
+
+private:
+	static constexpr uint8_t indexMask = 3;
+	static constexpr uint8_t freshBit = 4;							//set in middle by write(), cleared by update()
+
+	Parameters slots[3] {};
+	alignas(64) std::atomic<uint8_t> middle { 1 };				//each side's state on its own cache line, so the threads do not fight over one
+	alignas(64) uint8_t writeIndex = 0;
+	alignas(64) uint8_t readIndex = 2;
+};
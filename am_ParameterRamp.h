@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+	am_ParameterRamp.h
+	Created: 17 Oct 2026 8:47:36pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <cmath>
+
+//the curve a ramp follows
+enum class RampShape
+{
+	linear = 0,			//equal steps, for gains, widths and indices
+	exponential			//equal ratios, for frequencies (a glide that sounds even in pitch)
+};
+
+/**
+*A value that moves to a target over a set number of samples, for sample-accurate glides without calling a setter
+*every sample.
+*
+*All the work (the one division, or the pow() for an exponential curve) happens in rampTo(). After that every sample
+*is a single add or multiply in next(), which the classes call inside their block loops. The last sample of a ramp
+*lands exactly on the target.
+*
+*An exponential ramp needs both ends on the same side of 0. If they are not, it ramps linearly instead.
+*/
+class ParameterRamp
+{
+public:
+
+	//jump straight to a value, stopping any ramp
+	void setCurrent(float value)
+	{
+		current = value;
+		target = value;
+		remaining = 0;
+	}
+
+	/**
+	*start moving from the current value to a target
+	*@param value to reach
+	*@param number of samples to get there in. 0 or less jumps straight there.
+	*@param RampShape::linear or RampShape::exponential
+	*/
+	void rampTo(float targetValue, int numSamples, RampShape shape)
+	{
+		target = targetValue;
+
+		if (numSamples <= 0 || target == current)
+		{
+			setCurrent(target);
+			return;
+		}
+
+		remaining = numSamples;
+		exponential = shape == RampShape::exponential && canRampExponentially(current, target);
+
+		if (exponential)
+		{
+			ratio = float(std::pow(double(target) / double(current), 1.0 / numSamples));
+		}
+		else
+		{
+			step = (target - current) / float(numSamples);
+		}
+	}
+
+	//moves on one sample and returns the new value
+	float next()
+	{
+		if (remaining > 0)
+		{
+			if (--remaining == 0)
+			{
+				current = target;
+			}
+			else
+			{
+				current = exponential ? current * ratio : current + step;
+			}
+		}
+		return current;
+	}
+
+	bool isRamping() const
+	{
+		return remaining > 0;
+	}
+
+	//samples until the target is reached
+	int getRemainingSamples() const
+	{
+		return remaining;
+	}
+
+	float getCurrent() const
+	{
+		return current;
+	}
+
+	float getTarget() const
+	{
+		return target;
+	}
+
+	//the curve a ramp in progress follows (linear if an exponential one was asked for but could not be done)
+	RampShape getShape() const
+	{
+		return exponential ? RampShape::exponential : RampShape::linear;
+	}
+
+	/**
+	*multiplies the value and target by a factor, keeping the shape and the samples left, e.g. to carry a ramp of a
+	*phase increment over to a new sample rate
+	*@param factor
+	*/
+	void scale(float factor)
+	{
+		current *= factor;
+		target *= factor;
+		step *= factor;
+	}
+
+	/**
+	*the per-sample multiplier and increment of the ramp, for classes that apply it in their own (vector) loops as
+	*value = value * ratio + step. One of the two is always neutral (ratio 1 or step 0).
+	*/
+	float getRatio() const
+	{
+		return isRamping() && exponential ? ratio : 1.0f;
+	}
+
+	float getStep() const
+	{
+		return isRamping() && !exponential ? step : 0.0f;
+	}
+
+	//true if an exponential ramp can go between two values
+	static bool canRampExponentially(float from, float to)
+	{
+		return (from > 0.0f && to > 0.0f) || (from < 0.0f && to < 0.0f);
+	}
+
+	//saves or restores the ramp, part way through included (see am_Snapshot.h)
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		archive.value(current);
+		archive.value(target);
+		archive.value(step);
+		archive.value(ratio);
+		archive.value(remaining);
+		archive.value(exponential);
+		archive.check(remaining >= 0);
+	}
+
+private:
+	float current = 0.0f;
+	float target = 0.0f;
+	float step = 0.0f;
+	float ratio = 1.0f;
+	int remaining = 0;
+	bool exponential = false;
+};
@@ -1,76 +1,202 @@
-/*
-  ==============================================================================
-
-	am_Phase_Modulator.h
-	Created: 27 Oct 2022 10:17:48am
-	Author:  Andrew McGillivray
-
-  ==============================================================================
-*/#pragma once
-
-#include "Oscillators.h"
-
-/**
-*A class containing a phi modulator for sinusoids. The parameters to be set in this class are:
-*1) Carrier Frequency
-*2) Modulating Frequency
-*3) Modulating Index (to be multiplied by the modulating frequency output value))
-*and as always, Sample Rate.
-*
-*The variable will be applied as follows:
-*output = sin((2 * pi * phase) + (modulatingOscillatorOutput * modultingIndex))
-*/
-class PhiModulator 
-{
-public:
-
-	/**
-	*set up an entire phi modulator
-	*/
-	void setUpPhiModulator(float _sampleRate, float carrierFrequency, int carrierWaveIndex, float modulatorFrequency, int modulatorWaveIndex, float carrierIndexValue)
-	{
-		sampleRate = _sampleRate;
-		carrier.setUp(_sampleRate, carrierFrequency, carrierWaveIndex);
-		modulator.setUp(_sampleRate, modulatorFrequency, 1);
-		carrier.setPhiMod(carrierIndexValue);
-	}
-
-	/**
-	*set the sample rate for all oscillators involved
-	*@param sample rate in Hz
-	*/
-
-	void setSampleRate(float _sampleRate)
-	{
-		sampleRate = _sampleRate;
-		carrier.setSampleRate(_sampleRate);
-		modulator.setSampleRate(_sampleRate);
-	}
-
-	/**
-	*set the frequencies for both the carrier oscillator and the modulator oscillator
-	*@param frequency of carrier oscillator in Hz
-	*@param frequency of modulator oscillator in Hz
-	*@param index value in the oscillator
-	*/
-	void setUp(float carrierfrequency, float modulatorfrequency, float indexValue)
-	{
-		carrier.setFrequency(carrierfrequency);
-		modulator.setFrequency(modulatorfrequency);
-		carrier.setPhiMod(indexValue);
-	}
-
-	//modulates the phase of the carrier oscillator with the modulator oscillator and produces and output
-	float process()
-	{
-		float modVal = modulator.process();					//find the modulator oscillator output
-		carrier.setPhi(modVal);								//updates the carrier oscillator phi value.
-		float mainVal = carrier.process();					//finds the new carrier oscillator output
-
-		return mainVal;
-	}
-private:
-	float sampleRate;
-	Oscillator carrier;
-	Oscillator modulator;
-};
+/*
+  ==============================================================================
+
+	am_Phase_Modulator.h
+	Created: 27 Oct 2022 10:17:48am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/#pragma once
+
+#include "am_Oscillators.h"
+#include "am_Profiler.h"
+#include <algorithm>
+#include <cstdint>
+
+/**
+*A class containing a phi modulator for sinusoids. The parameters to be set in this class are:
+*1) Carrier Frequency
+*2) Modulating Frequency
+*3) Modulating Index (to be multiplied by the modulating frequency output value))
+*and as always, Sample Rate.
+*
+*The variable will be applied as follows:
+*output = sin((2 * pi * phase) + (modulatingOscillatorOutput * modultingIndex))
+*/
+class PhiModulator 
+{
+public:
+
+	/**
+	*set up an entire phi modulator
+	*/
+	void setUpPhiModulator(float _sampleRate, float carrierFrequency, int carrierWaveIndex, float modulatorFrequency, int modulatorWaveIndex, float carrierIndexValue)
+	{
+		sampleRate = _sampleRate;
+		carrier.setUp(_sampleRate, carrierFrequency, carrierWaveIndex);
+		modulator.setUp(_sampleRate, modulatorFrequency, 1);
+		carrier.setPhiMod(carrierIndexValue);
+	}
+
+	/**
+	*set the sample rate for all oscillators involved
+	*@param sample rate in Hz
+	*/
+
+	void setSampleRate(float _sampleRate)
+	{
+		sampleRate = _sampleRate;
+		carrier.setSampleRate(_sampleRate);
+		modulator.setSampleRate(_sampleRate);
+	}
+
+	/**
+	*set the frequencies for both the carrier oscillator and the modulator oscillator
+	*@param frequency of carrier oscillator in Hz
+	*@param frequency of modulator oscillator in Hz
+	*@param index value in the oscillator
+	*/
+	void setUp(float carrierfrequency, float modulatorfrequency, float indexValue)
+	{
+		carrier.setFrequency(carrierfrequency);
+		modulator.setFrequency(modulatorfrequency);
+		carrier.setPhiMod(indexValue);
+	}
+
+	/**
+	*glide the carrier and modulator frequencies and the modulation index together, one step per sample while rendering
+	*@param carrier frequency to reach in Hz
+	*@param modulator frequency to reach in Hz
+	*@param modulation index to reach
+	*@param length of the ramp in samples
+	*/
+	void rampTo(float carrierFrequency, float modulatorFrequency, float indexValue, int numSamples)
+	{
+		carrier.rampFrequency(carrierFrequency, numSamples, RampShape::exponential);
+		modulator.rampFrequency(modulatorFrequency, numSamples, RampShape::exponential);
+		carrier.rampPhiMod(indexValue, numSamples, RampShape::linear);
+	}
+
+	/**
+	*ramp only the modulation index
+	*@param modulation index to reach
+	*@param length of the ramp in samples
+	*@param RampShape::linear or RampShape::exponential
+	*/
+	void rampModulationIndex(float indexValue, int numSamples, RampShape shape = RampShape::linear)
+	{
+		carrier.rampPhiMod(indexValue, numSamples, shape);
+	}
+
+	//the settings a GUI changes, as one set that can be handed to the audio thread whole (see am_ParameterExchange.h)
+	struct Parameters
+	{
+		float carrierFrequency = 0.0f;		//Hz
+		float modulatorFrequency = 0.0f;	//Hz
+		float modulationIndex = 1.0f;
+	};
+
+	//applies a whole set as setUp() does, so any ramps stop. Does not allocate.
+	void setParameters(const Parameters& parameters)
+	{
+		setUp(parameters.carrierFrequency, parameters.modulatorFrequency, parameters.modulationIndex);
+	}
+
+	//the current set (targets, for ramps that are still moving)
+	Parameters getParameters() const
+	{
+		Parameters parameters;
+		parameters.carrierFrequency = carrier.getParameters().frequency;
+		parameters.modulatorFrequency = modulator.getParameters().frequency;
+		parameters.modulationIndex = carrier.getPhiMod();
+		return parameters;
+	}
+
+	static constexpr char snapshotTag[5] = "PHIM";
+
+	/**
+	*saves or restores both oscillators, phases and ramps included (see am_Snapshot.h)
+	*@param SnapshotWriter or SnapshotReader
+	*/
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		carrier.serialise(archive);
+		modulator.serialise(archive);
+		sampleRate = carrier.getSampleRate();
+	}
+
+	//modulates the phase of the carrier oscillator with the modulator oscillator and produces and output
+	float process()
+	{
+		float modVal = modulator.process();					//find the modulator oscillator output
+		carrier.setPhi(modVal);								//updates the carrier oscillator phi value.
+		float mainVal = carrier.process();					//finds the new carrier oscillator output
+
+		return mainVal;
+	}
+
+	/**
+	*fills a buffer with the modulated carrier, overwriting what is already there.
+	*Sample-identical to calling process() numSamples times.
+	*@param buffer to write into
+	*@param number of samples to write
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		AM_PROFILE_MODULE(ProfiledModule::phiModulator, numSamples);
+		renderBlock(out, numSamples);
+	}
+
+	/**
+	*adds the modulated carrier on top of what is already in the buffer (out[i] += process())
+	*@param buffer to add into
+	*@param number of samples to add
+	*/
+	void processBlockAdd(float* out, int numSamples)
+	{
+		AM_PROFILE_MODULE(ProfiledModule::phiModulator, numSamples);
+		float mainVals[scratchSize];
+
+		for (int start = 0; start < numSamples; start += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - start);
+			renderBlock(mainVals, chunk);
+
+			for (int i = 0; i < chunk; i++)
+			{
+				out[start + i] += mainVals[i];
+			}
+		}
+	}
+
+	/**
+	*moves on numSamples without making any output, leaving both oscillators as if process() had been called
+	*numSamples times (see Oscillator::skipSamples())
+	*@param number of samples to skip
+	*/
+	void skipSamples(int64_t numSamples)
+	{
+		modulator.skipSamples(numSamples);
+		carrier.skipSamples(numSamples);				//phi is set again from the modulator before the carrier's next sample
+	}
+
+private:
+	static constexpr int scratchSize = 64;			//samples rendered at a time in the block functions
+
+	void renderBlock(float* out, int numSamples)
+	{
+		float modVals[scratchSize];
+
+		for (int start = 0; start < numSamples; start += scratchSize)
+		{
+			const int chunk = std::min(scratchSize, numSamples - start);
+			modulator.processBlock(modVals, chunk);						//find the modulator outputs for the whole chunk
+			carrier.processBlockWithPhi(modVals, out + start, chunk);	//feed them into the carrier one sample at a time
+		}
+	}
+
+	float sampleRate;
+	Oscillator carrier;
+	Oscillator modulator;
+};
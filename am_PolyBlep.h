@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+	am_PolyBlep.h
+	Created: 17 Oct 2026 1:42:09pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <cmath>
+
+/**
+*Band-limited versions of the square, triangle and sawtooth waves using polynomial corrections (PolyBLEP for jumps,
+*PolyBLAMP for corners) over the two samples either side of each discontinuity.
+*
+*This removes most of the aliasing of the naive waves at the base sample rate, for a few multiplies per sample
+*instead of running everything oversampled. The phase conventions match Oscillator: phase in [0, 1], square is +1
+*up to the phase width and -1 after it, triangle peaks at phase 0, sawtooth rises from -1 to 1.
+*/
+namespace PolyBlep
+{
+	/**
+	*correction for a unit step at phase 0
+	*@param phase in [0, 1]
+	*@param phase increment per sample
+	*/
+	inline float blep(float t, float dt)
+	{
+		if (t < dt)
+		{
+			const float x = t / dt;
+			return x + x - x * x - 1.0f;
+		}
+		if (t > 1.0f - dt)
+		{
+			const float x = (t - 1.0f) / dt;
+			return x * x + x + x + 1.0f;
+		}
+		return 0.0f;
+	}
+
+	/**
+	*correction for a unit change of slope (per sample) at phase 0
+	*@param phase in [0, 1]
+	*@param phase increment per sample
+	*/
+	inline float blamp(float t, float dt)
+	{
+		if (t < dt)
+		{
+			const float x = t / dt - 1.0f;
+			return -(1.0f / 6.0f) * x * x * x;
+		}
+		if (t > 1.0f - dt)
+		{
+			const float x = (t - 1.0f) / dt + 1.0f;
+			return (1.0f / 6.0f) * x * x * x;
+		}
+		return 0.0f;
+	}
+
+	//wraps a shifted phase back into [0, 1)
+	inline float wrap(float t)
+	{
+		return t >= 1.0f ? t - 1.0f : (t < 0.0f ? t + 1.0f : t);
+	}
+
+	/**
+	*band-limited square wave with a variable phase width
+	*@param phase in [0, 1]
+	*@param phase width in [0, 1]
+	*@param phase increment per sample
+	*/
+	inline float square(float p, float pw, float dt)
+	{
+		float value = p > pw ? -1.0f : 1.0f;
+		value += blep(p, dt);							//rising edge at phase 0
+		value -= blep(wrap(p - pw), dt);				//falling edge at the phase width
+		return value;
+	}
+
+	/**
+	*band-limited triangle wave (slope of -4 then +4 per cycle)
+	*@param phase in [0, 1]
+	*@param phase increment per sample
+	*/
+	inline float triangle(float p, float dt)
+	{
+		float value = 4.0f * (std::fabs(p - 0.5f) - 0.25f);
+		value -= 8.0f * dt * blamp(p, dt);				//peak at phase 0, slope changes by -8
+		value += 8.0f * dt * blamp(wrap(p + 0.5f), dt);	//trough at phase 0.5, slope changes by +8
+		return value;
+	}
+
+	/**
+	*band-limited sawtooth wave
+	*@param phase in [0, 1]
+	*@param phase increment per sample
+	*/
+	inline float sawtooth(float p, float dt)
+	{
+		return 2.0f * (p - 0.5f) - blep(p, dt);			//drop of 2 at phase 0
+	}
+}
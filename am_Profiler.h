@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+	am_Profiler.h
+	Created: 17 Oct 2026 11:58:05pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+	#include <intrin.h>
+#endif
+
+//Build with AM_ENABLE_PROFILING=1 (the CMake option of the same name) to turn the profiling in the classes on.
+//Without it the AM_PROFILE macros are empty and the classes compile exactly as before.
+#ifndef AM_ENABLE_PROFILING
+	#define AM_ENABLE_PROFILING 0
+#endif
+
+//the classes that time themselves
+enum class ProfiledModule : uint8_t
+{
+	block = 0,			//a whole audio callback, see ProfiledBlock
+	chord,
+	clusterChord,
+	phiModulator,
+	doubleCombFilter,
+	numModules
+};
+
+inline const char* getModuleName(ProfiledModule module)
+{
+	static const char* const names[] = { "block", "Chord", "clusterChord", "PhiModulator", "DoubleCombFilter" };
+	return module < ProfiledModule::numModules ? names[int(module)] : "?";
+}
+
+/**
+*the CPU's cycle counter: rdtsc on x86, the virtual counter on 64 bit ARM (a fixed rate, not the clock speed) and
+*steady_clock nanoseconds elsewhere. Only differences between two readings on the same thread mean anything.
+*/
+inline uint64_t readCycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	return __rdtsc();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+	uint64_t ticks;
+	asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+	return ticks;
+#else
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+*A wait-free queue for one producer thread and one consumer thread. push() never blocks or allocates: when the
+*queue is full the item is dropped and counted instead, so the audio thread cannot be held up by a slow reader.
+*@tparam item type (copied in and out)
+*@tparam capacity, a power of two
+*/
+template <class T, size_t Capacity>
+class SpscRing
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+
+	//producer thread only. Returns false (and counts a drop) if the queue is full.
+	bool push(const T& item)
+	{
+		const size_t head = writeIndex.load(std::memory_order_relaxed);
+
+		if (head - readIndex.load(std::memory_order_acquire) >= Capacity)
+		{
+			dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		items[head & (Capacity - 1)] = item;
+		writeIndex.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	//consumer thread only. Returns false if the queue is empty.
+	bool pop(T& item)
+	{
+		const size_t tail = readIndex.load(std::memory_order_relaxed);
+
+		if (tail == writeIndex.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		item = items[tail & (Capacity - 1)];
+		readIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//items pushed while the queue was full
+	uint64_t getNumDropped() const
+	{
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	alignas(64) std::atomic<size_t> writeIndex { 0 };			//the two indices on their own cache lines, so the threads do not fight over one
+	alignas(64) std::atomic<size_t> readIndex { 0 };
+	alignas(64) std::atomic<uint64_t> dropped { 0 };
+	T items[Capacity];
+};
+
+//one timing, as it comes out of DspProfiler::pop()
+struct ProfileEvent
+{
+	ProfiledModule module = ProfiledModule::block;
+	int32_t numSamples = 0;
+	uint64_t cycles = 0;						//readCycleCounter() ticks the module (or block) took
+	uint64_t nanoseconds = 0;					//blocks only: wall-clock time of the callback
+	uint64_t deadlineNanoseconds = 0;			//blocks only: how long the callback had, numSamples / sample rate
+};
+
+//missed-deadline statistics since the last resetStats()
+struct XrunStats
+{
+	uint64_t blocks = 0;
+	uint64_t xruns = 0;							//blocks that took longer than their deadline
+	double averageLoad = 0.0;					//mean of render time / deadline, 1 is 100% of the budget
+	double worstLoad = 0.0;
+	uint64_t droppedEvents = 0;					//timings lost because nobody drained the queue in time
+};
+
+/**
+*Records how long each module and each audio callback take, for a meter or a log on another thread.
+*
+*The audio thread puts a ProfiledBlock (AM_PROFILE_BLOCK) at the top of its callback. While that exists, every
+*Chord, clusterChord, PhiModulator and DoubleCombFilter block function called on the same thread records its cycle
+*count into this profiler, and the callback's time is checked against its deadline when the block ends. Each timing is
+*an event in a lock-free single-producer queue that one other thread drains with pop(), and the xrun statistics can be
+*read from any thread.
+*
+*Timings are inclusive: a clusterChord's includes its chords'. Modules rendered on RenderThreadPool workers are not
+*recorded themselves (a worker has no ProfiledBlock); their time shows up in the module waiting for them.
+*Use one profiler per audio thread.
+*/
+class DspProfiler
+{
+public:
+	static constexpr size_t queueSize = 4096;
+
+	//sets the deadline of a block. Call it before audio starts.
+	void setSampleRate(float _sampleRate)
+	{
+		nanosecondsPerSample = 1.0e9 / double(_sampleRate);
+	}
+
+	//consumer thread: takes the next timing, false if there are none
+	bool pop(ProfileEvent& event)
+	{
+		return events.pop(event);
+	}
+
+	//any thread
+	XrunStats getXrunStats() const
+	{
+		XrunStats stats;
+		stats.blocks = blocks.load(std::memory_order_relaxed);
+		stats.xruns = xruns.load(std::memory_order_relaxed);
+		stats.averageLoad = stats.blocks > 0 ? totalLoad.load(std::memory_order_relaxed) / double(stats.blocks) : 0.0;
+		stats.worstLoad = worstLoad.load(std::memory_order_relaxed);
+		stats.droppedEvents = events.getNumDropped();
+		return stats;
+	}
+
+	//audio thread, or while audio is stopped
+	void resetStats()
+	{
+		blocks.store(0, std::memory_order_relaxed);
+		xruns.store(0, std::memory_order_relaxed);
+		totalLoad.store(0.0, std::memory_order_relaxed);
+		worstLoad.store(0.0, std::memory_order_relaxed);
+	}
+
+	//audio thread: records a module's timing
+	void recordModule(ProfiledModule module, int numSamples, uint64_t cycles)
+	{
+		ProfileEvent event;
+		event.module = module;
+		event.numSamples = numSamples;
+		event.cycles = cycles;
+		events.push(event);
+	}
+
+	//audio thread: records a callback's timing and updates the xrun statistics
+	void recordBlock(int numSamples, uint64_t cycles, uint64_t nanoseconds)
+	{
+		ProfileEvent event;
+		event.numSamples = numSamples;
+		event.cycles = cycles;
+		event.nanoseconds = nanoseconds;
+		event.deadlineNanoseconds = uint64_t(double(numSamples) * nanosecondsPerSample);
+		events.push(event);
+
+		//only this thread writes the statistics, so plain loads and stores are enough
+		const double load = event.deadlineNanoseconds > 0 ? double(nanoseconds) / double(event.deadlineNanoseconds) : 0.0;
+		blocks.store(blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		totalLoad.store(totalLoad.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+
+		if (load > 1.0)
+		{
+			xruns.store(xruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		if (load > worstLoad.load(std::memory_order_relaxed))
+		{
+			worstLoad.store(load, std::memory_order_relaxed);
+		}
+	}
+
+	//the profiler of the ProfiledBlock running on this thread, or nullptr
+	static DspProfiler*& current()
+	{
+		static thread_local DspProfiler* profiler = nullptr;
+		return profiler;
+	}
+
+private:
+	SpscRing<ProfileEvent, queueSize> events;
+	double nanosecondsPerSample = 1.0e9 / 44100.0;
+
+	std::atomic<uint64_t> blocks { 0 };
+	std::atomic<uint64_t> xruns { 0 };
+	std::atomic<double> totalLoad { 0.0 };
+	std::atomic<double> worstLoad { 0.0 };
+};
+
+/**
+*Times one audio callback on the calling thread and makes the profiler current there, so the modules called inside
+*it record into it. Use AM_PROFILE_BLOCK rather than this directly, so it disappears when profiling is off.
+*/
+class ProfiledBlock
+{
+public:
+
+	ProfiledBlock(DspProfiler& _profiler, int _numSamples)
+		: profiler(_profiler), previous(DspProfiler::current()), numSamples(_numSamples)
+	{
+		DspProfiler::current() = &profiler;
+		startTime = std::chrono::steady_clock::now();
+		startCycles = readCycleCounter();
+	}
+
+	~ProfiledBlock()
+	{
+		const uint64_t cycles = readCycleCounter() - startCycles;
+		const auto elapsed = std::chrono::steady_clock::now() - startTime;
+		profiler.recordBlock(numSamples, cycles, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		DspProfiler::current() = previous;
+	}
+
+	ProfiledBlock(const ProfiledBlock&) = delete;
+	ProfiledBlock& operator=(const ProfiledBlock&) = delete;
+
+private:
+	DspProfiler& profiler;
+	DspProfiler* previous;
+	int numSamples;
+	std::chrono::steady_clock::time_point startTime;
+	uint64_t startCycles;
+};
+
+/**
+*Times the rest of the scope it is in as one module, if a ProfiledBlock is running on this thread. Use
+*AM_PROFILE_MODULE rather than this directly.
+*/
+class ProfiledScope
+{
+public:
+
+	ProfiledScope(ProfiledModule _module, int _numSamples)
+		: profiler(DspProfiler::current()), module(_module), numSamples(_numSamples)
+	{
+		startCycles = profiler != nullptr ? readCycleCounter() : 0;
+	}
+
+	~ProfiledScope()
+	{
+		if (profiler != nullptr)
+		{
+			profiler->recordModule(module, numSamples, readCycleCounter() - startCycles);
+		}
+	}
+
+	ProfiledScope(const ProfiledScope&) = delete;
+	ProfiledScope& operator=(const ProfiledScope&) = delete;
+
+private:
+	DspProfiler* profiler;
+	ProfiledModule module;
+	int numSamples;
+	uint64_t startCycles;
+};
+
+#if AM_ENABLE_PROFILING
+	#define AM_PROFILE_BLOCK(profiler, numSamples) ProfiledBlock amProfiledBlock_((profiler), (numSamples))
+	#define AM_PROFILE_MODULE(module, numSamples) ProfiledScope amProfiledScope_((module), (numSamples))
+#else
+	#define AM_PROFILE_BLOCK(profiler, numSamples) ((void)0)
+	#define AM_PROFILE_MODULE(module, numSamples) ((void)0)
+#endif
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+	am_Random.h
+	Created: 17 Oct 2026 6:20:05pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+*A small seedable random number generator (xoshiro128**, seeded through splitmix64), used in place of juce::Random so
+*the classes build without JUCE.
+*
+*A default-constructed generator is seeded differently every time, so two clusters made the same way sound different.
+*Give it a seed (the constructor or setSeed()) to get the same numbers on every platform, so clusters (and benchmarks)
+*can be reproduced.
+*Cheap enough to call on the audio thread: no allocation, no locks, a few integer operations per number.
+*/
+class SeededRandom
+{
+public:
+
+	//starts from a seed that is different for every generator and every run
+	SeededRandom()
+	{
+		setSeed(makeUniqueSeed());
+	}
+
+	explicit SeededRandom(uint64_t seed)
+	{
+		setSeed(seed);
+	}
+
+	//restart the sequence from a seed
+	void setSeed(uint64_t seed)
+	{
+		for (int i = 0; i < 4; i += 2)
+		{
+			const uint64_t value = splitMix(seed);
+			state[i] = uint32_t(value);
+			state[i + 1] = uint32_t(value >> 32);
+		}
+
+		if ((state[0] | state[1] | state[2] | state[3]) == 0)		//the one state xoshiro cannot leave
+		{
+			state[0] = 1;
+		}
+	}
+
+	//a random 32 bit number
+	uint32_t nextUInt32()
+	{
+		const uint32_t result = rotateLeft(state[1] * 5, 7) * 9;
+		const uint32_t shifted = state[1] << 9;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= shifted;
+		state[3] = rotateLeft(state[3], 11);
+
+		return result;
+	}
+
+	//a random float in [0, 1), same range as juce::Random::nextFloat()
+	float nextFloat()
+	{
+		return float(nextUInt32() >> 8) * (1.0f / 16777216.0f);		//24 bits, so every value is exact in a float
+	}
+
+	//a random int in [0, maxValue)
+	int nextInt(int maxValue)
+	{
+		return maxValue > 0 ? int((uint64_t(nextUInt32()) * uint64_t(maxValue)) >> 32) : 0;
+	}
+
+	//saves or restores the position in the sequence, so the numbers carry on where they left off (see am_Snapshot.h)
+	template <class Archive>
+	void serialise(Archive& archive)
+	{
+		archive.value(state);
+		archive.check((state[0] | state[1] | state[2] | state[3]) != 0);
+	}
+
+private:
+
+	static uint32_t rotateLeft(uint32_t x, int k)
+	{
+		return (x << k) | (x >> (32 - k));
+	}
+
+	//a counter shared by every generator mixed with the clock: two generators never match, in one run or across runs
+	static uint64_t makeUniqueSeed()
+	{
+		static std::atomic<uint64_t> counter { 0 };
+		uint64_t instance = counter.fetch_add(1, std::memory_order_relaxed);
+		const uint64_t time = uint64_t(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+		return splitMix(instance) ^ time;
+	}
+
+	static uint64_t splitMix(uint64_t& x)
+	{
+		uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	uint32_t state[4];
+};
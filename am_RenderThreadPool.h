@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+	am_RenderThreadPool.h
+	Created: 17 Oct 2026 5:31:40pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+*A pool of worker threads for splitting one block of audio work (e.g. the chords of a cluster) across cores.
+*
+*run() hands out task numbers 0 to numTasks - 1. Every thread (the workers and the thread calling run(), which always
+*takes part) starts on its own contiguous range of tasks and, once that is used up, steals single tasks from the other
+*ranges. Claiming a task is one atomic add, so the audio thread never takes a lock, allocates or waits on a worker that
+*has not started: anything a worker does not pick up in time the calling thread does itself.
+*
+*Workers spin (yielding) for a short while after each job so back-to-back audio blocks start with no wake-up delay,
+*then sleep until the next job. Waking a sleeping worker is a notify without a lock, so in rare cases a worker can
+*join a job late or not at all; that only costs speed, never correctness.
+*
+*Use fewer workers than cores (defaultNumWorkers()), since a spinning worker sharing a core with the audio thread slows
+*it down. Tasks must be independent of each other, and run() must only be called from one thread at a time.
+*/
+class RenderThreadPool
+{
+public:
+
+	/**
+	*starts the worker threads
+	*@param number of worker threads, not counting the thread that calls run(). 0 renders everything on the caller.
+	*@param true to ask for real-time (SCHED_FIFO) priority for the workers, where the platform allows it. Only do this
+	*       when the audio thread is real-time too, or spinning workers can starve it.
+	*/
+	explicit RenderThreadPool(int numWorkers, bool realtimePriority = false)
+	{
+		numWorkers = std::max(numWorkers, 0);
+		ranges = std::vector<Range>(numWorkers + 1);
+
+		workers.reserve(numWorkers);
+		for (int i = 0; i < numWorkers; i++)
+		{
+			workers.emplace_back([this, i, realtimePriority]
+			{
+				if (realtimePriority)
+				{
+					setRealtimePriority();
+				}
+				workerLoop(i + 1);
+			});
+		}
+	}
+
+	//one worker per core, leaving one core for the thread calling run()
+	static int defaultNumWorkers()
+	{
+		return std::max(int(std::thread::hardware_concurrency()) - 1, 0);
+	}
+
+	~RenderThreadPool()
+	{
+		stopping.store(true);
+		generation.fetch_add(1);
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wakeUp.notify_all();
+		}
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	RenderThreadPool(const RenderThreadPool&) = delete;
+	RenderThreadPool& operator=(const RenderThreadPool&) = delete;
+
+	//number of threads that can work on a job, including the caller
+	int getNumThreads() const
+	{
+		return int(ranges.size());
+	}
+
+	/**
+	*runs task(context, index) for every index in [0, numTasks) across the pool and returns once all of them are done.
+	*@param number of tasks
+	*@param function doing one task
+	*@param pointer passed on to the function
+	*/
+	void run(int numTasks, void (*task)(void*, int), void* context)
+	{
+		if (numTasks <= 0)
+		{
+			return;
+		}
+
+		jobTask = task;
+		jobContext = context;
+
+		const int numRanges = int(ranges.size());
+		for (int r = 0; r < numRanges; r++)										//split the tasks into equal ranges
+		{
+			ranges[r].next.store(int(int64_t(numTasks) * r / numRanges), std::memory_order_relaxed);
+			ranges[r].end = int(int64_t(numTasks) * (r + 1) / numRanges);
+		}
+
+		jobOpen.store(true);
+		generation.fetch_add(1);
+
+		if (sleepingWorkers.load() > 0)
+		{
+			wakeUp.notify_all();
+		}
+
+		doTasks(0);
+
+		jobOpen.store(false);													//late workers must not start on this job...
+		while (busyWorkers.load() > 0)											//...and ones already in it must finish
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	/**
+	*runs fn(index) for every index in [0, numTasks) across the pool. fn is called by reference, so capturing lambdas
+	*are fine and nothing is allocated.
+	*/
+	template <class Function>
+	void run(int numTasks, Function& fn)
+	{
+		run(numTasks, [](void* context, int index) { (*static_cast<Function*>(context))(index); }, &fn);
+	}
+
+private:
+
+	//a contiguous range of tasks, on its own cache line so threads claiming from different ranges do not contend
+	struct alignas(64) Range
+	{
+		std::atomic<int> next { 0 };
+		int end = 0;
+	};
+
+	//does every task this thread can claim: first its own range, then whatever is left in the others
+	void doTasks(int ownRange)
+	{
+		const int numRanges = int(ranges.size());
+
+		for (int r = 0; r < numRanges; r++)
+		{
+			Range& range = ranges[(ownRange + r) % numRanges];
+
+			for (;;)
+			{
+				if (range.next.load(std::memory_order_relaxed) >= range.end)
+				{
+					break;
+				}
+
+				const int index = range.next.fetch_add(1);
+				if (index >= range.end)
+				{
+					break;
+				}
+
+				jobTask(jobContext, index);
+			}
+		}
+	}
+
+	void workerLoop(int ownRange)
+	{
+		uint64_t seen = generation.load();
+
+		while (!stopping.load())
+		{
+			waitForJob(seen);
+			seen = generation.load();
+
+			busyWorkers.fetch_add(1);
+			if (jobOpen.load() && !stopping.load())
+			{
+				doTasks(ownRange);
+			}
+			busyWorkers.fetch_sub(1);
+		}
+	}
+
+	//spins for a while after the last job, then sleeps
+	void waitForJob(uint64_t seen)
+	{
+		const auto spinUntil = std::chrono::steady_clock::now() + std::chrono::microseconds(spinMicroseconds);
+
+		while (generation.load() == seen)
+		{
+			if (std::chrono::steady_clock::now() < spinUntil)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			sleepingWorkers.fetch_add(1);
+			{
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				wakeUp.wait_for(lock, std::chrono::milliseconds(1), [&] { return generation.load() != seen; });
+			}
+			sleepingWorkers.fetch_sub(1);
+		}
+	}
+
+	static void setRealtimePriority()
+	{
+#if defined(__linux__) || defined(__APPLE__)
+		sched_param param {};
+		param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);		//fails without permission, which is fine
+#endif
+	}
+
+	static constexpr int spinMicroseconds = 2000;			//how long a worker stays awake after a job
+
+	std::vector<Range> ranges;								//one per thread, the caller's first
+	std::vector<std::thread> workers;
+
+	void (*jobTask)(void*, int) = nullptr;
+	void* jobContext = nullptr;
+
+	std::atomic<uint64_t> generation { 0 };					//goes up by one for every job
+	std::atomic<bool> jobOpen { false };
+	std::atomic<int> busyWorkers { 0 };
+	std::atomic<int> sleepingWorkers { 0 };
+	std::atomic<bool> stopping { false };
+
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+	am_Simd.h
+	Created: 17 Oct 2026 9:02:14am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+/**
+*Helpers shared by the classes that have hand-written SSE/AVX2/AVX-512 paths.
+*
+*The vector paths are compiled into every build (with per-function target attributes on GCC/Clang) and picked at
+*runtime with detectInstructionSet(), so the same binary runs on any x86 machine. On other platforms everything
+*falls back to the scalar code.
+*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define AM_SIMD_X86 1
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define AM_TARGET_SSE2
+		#define AM_TARGET_AVX2
+		#define AM_TARGET_AVX512
+		#define AM_TARGET_F16C
+	#else
+		#define AM_TARGET_SSE2 __attribute__((target("sse2")))
+		#define AM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+		#define AM_TARGET_AVX512 __attribute__((target("avx512f")))
+		#define AM_TARGET_F16C __attribute__((target("avx2,f16c")))		//half float conversion, on every CPU with AVX2
+	#endif
+#else
+	#define AM_SIMD_X86 0
+#endif
+
+//instruction sets in order of preference. Anything above what the machine supports is never used.
+enum class InstructionSet
+{
+	scalar = 0,
+	sse2,
+	avx2,
+	avx512
+};
+
+//finds the best instruction set this machine (and operating system) can run
+inline InstructionSet detectInstructionSet()
+{
+#if AM_SIMD_X86
+	#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	const int highestLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool hasSse2 = (info[3] & (1 << 26)) != 0;
+	const bool hasFma = (info[2] & (1 << 12)) != 0;
+	const bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+	const bool osSavesAvx512 = osSavesAvx && (_xgetbv(0) & 0xe6) == 0xe6;
+
+	bool hasAvx2 = false;
+	bool hasAvx512 = false;
+	if (highestLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		hasAvx2 = osSavesAvx && hasFma && (info[1] & (1 << 5)) != 0;
+		hasAvx512 = osSavesAvx512 && (info[1] & (1 << 16)) != 0;
+	}
+	#else
+	__builtin_cpu_init();
+	const bool hasSse2 = __builtin_cpu_supports("sse2");
+	const bool hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	const bool hasAvx512 = __builtin_cpu_supports("avx512f");
+	#endif
+
+	if (hasAvx512)
+	{
+		return InstructionSet::avx512;
+	}
+	if (hasAvx2)
+	{
+		return InstructionSet::avx2;
+	}
+	if (hasSse2)
+	{
+		return InstructionSet::sse2;
+	}
+#endif
+	return InstructionSet::scalar;
+}
@@ -0,0 +1,482 @@
+/*
+  ==============================================================================
+
+	am_Snapshot.h
+	Created: 17 Oct 2026 11:02:47pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+/**
+*Binary snapshots of the complete state of the synthesis classes (phases, ramps, random generators, cluster
+*frequencies, DurationWave positions, delay line contents), so a session reloads exactly as it sounded instead of being
+*set up from scratch.
+*
+*Every class that can be saved has a serialise(Archive&) function that lists its state once, for both directions:
+*SnapshotWriter reads the fields into a byte buffer, SnapshotReader writes them back. Values are stored as their raw
+*bytes and arrays (e.g. a delay line) as a count and one block, so restoring is mostly memcpy. Nothing is stored that
+*can be worked out again from the rest (e.g. delay taps), and the runtime set-up is left alone (thread pools, the
+*instruction set, a resize waiting in prepareMaxDelay()).
+*
+*File layout, all in the machine's byte order (little-endian on x86 and ARM, checked by the byte order mark):
+*   header:  "AMSS", format version, byte order mark, number of sections
+*   section: 4 character tag naming the class, length in bytes, then the class's fields
+*
+*The format version is passed to serialise() (archive.getVersion()) so later versions can still read older snapshots.
+*Restore the sections in the order they were added. SnapshotReader checks every tag, length, array size and class
+*invariant; after a failed restore the object is left safe to run (e.g. an empty delay line, which passes audio
+*straight through) but should be set up again.
+*
+*Saving and restoring allocate, so do them while audio is stopped, or save a copy of the object made on the audio thread.
+*
+*   SnapshotWriter writer;
+*   writer.add(chord);
+*   writer.add(comb);
+*   writer.saveToFile("session.amss");
+*
+*   MappedFile file;
+*   SnapshotReader reader;
+*   bool ok = file.open("session.amss") && reader.open(file.data(), file.size()) && reader.restore(chord) && reader.restore(comb);
+*/
+
+///current version of the snapshot format
+constexpr uint32_t snapshotFormatVersion = 1;
+
+///a 4 character section tag as a number, e.g. snapshotTag("CHRD")
+constexpr uint32_t snapshotTag(const char (&name)[5])
+{
+	return uint32_t(uint8_t(name[0])) | (uint32_t(uint8_t(name[1])) << 8) | (uint32_t(uint8_t(name[2])) << 16) | (uint32_t(uint8_t(name[3])) << 24);
+}
+
+/**
+*Collects snapshot sections into a byte buffer. serialise() functions see it as an Archive with loading == false.
+*/
+class SnapshotWriter
+{
+public:
+	static constexpr bool loading = false;
+
+	SnapshotWriter()
+	{
+		const uint32_t header[4] = { snapshotTag("AMSS"), snapshotFormatVersion, byteOrderMark, 0 };
+		bytes(header, sizeof(header));
+	}
+
+	/**
+	*adds a section holding the whole state of an object
+	*@param object with a serialise() function and a snapshotTag
+	*/
+	template <class T>
+	void add(const T& object)
+	{
+		const uint32_t tag = snapshotTag(T::snapshotTag);
+		bytes(&tag, sizeof(tag));
+
+		const size_t lengthPosition = data.size();
+		uint64_t length = 0;
+		bytes(&length, sizeof(length));
+
+		const_cast<T&>(object).serialise(*this);						//only reads the object when saving
+
+		length = uint64_t(data.size() - lengthPosition - sizeof(length));
+		std::memcpy(data.data() + lengthPosition, &length, sizeof(length));
+
+		numSections++;
+		std::memcpy(data.data() + 3 * sizeof(uint32_t), &numSections, sizeof(numSections));
+	}
+
+	//the snapshot so far
+	const std::vector<uint8_t>& getData() const
+	{
+		return data;
+	}
+
+	/**
+	*writes the snapshot to a file
+	*@param path of the file to create (overwritten if it exists)
+	*@return false if the file could not be written
+	*/
+	bool saveToFile(const std::string& path) const
+	{
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+		return std::fclose(file) == 0 && written;
+	}
+
+
+	//Archive Functions (called from serialise())
+
+	uint32_t getVersion() const
+	{
+		return snapshotFormatVersion;
+	}
+
+	///a number, enum, bool or fixed-size array of them
+	template <class T>
+	void value(T& field)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be stored directly");
+		bytes(&field, sizeof(T));
+	}
+
+	///a std::vector of plain values: its size, then the elements in one block
+	template <class T, class Allocator>
+	void array(std::vector<T, Allocator>& elements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be stored as an array");
+		uint64_t count = elements.size();
+		bytes(&count, sizeof(count));
+		bytes(elements.data(), elements.size() * sizeof(T));
+	}
+
+	///a container of objects with their own serialise() (std::vector or FixedVector): its size, then each object
+	template <class Container>
+	void objects(Container& container)
+	{
+		uint64_t count = uint64_t(container.size());
+		bytes(&count, sizeof(count));
+
+		for (auto& element : container)
+		{
+			element.serialise(*this);
+		}
+	}
+
+	///on loading, fails the restore if a class invariant does not hold. Nothing to check when saving.
+	bool check(bool /*condition*/)
+	{
+		return true;
+	}
+
+	//the byte order mark: reads back as something else on a machine with the other byte order
+	static constexpr uint32_t byteOrderMark = 0x01020304u;
+
+private:
+	void bytes(const void* source, size_t numBytes)
+	{
+		const uint8_t* first = static_cast<const uint8_t*>(source);
+		data.insert(data.end(), first, first + numBytes);
+	}
+
+	std::vector<uint8_t> data;
+	uint32_t numSections = 0;
+};
+
+/**
+*Restores objects from a snapshot in memory, e.g. a MappedFile. It does not copy the snapshot, so the memory must stay
+*valid while it is used. serialise() functions see it as an Archive with loading == true.
+*/
+class SnapshotReader
+{
+public:
+	static constexpr bool loading = true;
+
+	/**
+	*starts reading a snapshot, checking its header
+	*@param snapshot bytes, e.g. MappedFile::data() or SnapshotWriter::getData().data()
+	*@param number of bytes
+	*@return false if it is not a snapshot, is from a newer version, or has the other byte order
+	*/
+	bool open(const void* snapshot, size_t numBytes)
+	{
+		position = static_cast<const uint8_t*>(snapshot);
+		end = position + numBytes;
+		failed = false;
+		sectionsLeft = 0;
+
+		uint32_t header[4] = {};
+		bytes(header, sizeof(header));
+
+		failed = failed || header[0] != snapshotTag("AMSS") || header[1] == 0 || header[1] > snapshotFormatVersion
+			|| header[2] != SnapshotWriter::byteOrderMark;
+		version = header[1];
+		sectionsLeft = header[3];
+		return !failed;
+	}
+
+	/**
+	*restores the next section into an object
+	*@param object of the class that saved the section
+	*@return false if anything has failed so far (a wrong tag or length, a truncated snapshot or an invalid value)
+	*/
+	template <class T>
+	bool restore(T& object)
+	{
+		uint32_t tag = 0;
+		uint64_t length = 0;
+		bytes(&tag, sizeof(tag));
+		bytes(&length, sizeof(length));
+
+		if (failed || sectionsLeft == 0 || tag != snapshotTag(T::snapshotTag) || length > uint64_t(end - position))
+		{
+			failed = true;
+			return false;
+		}
+
+		const uint8_t* const sectionEnd = position + length;
+		const uint8_t* const snapshotEnd = end;
+		end = sectionEnd;												//a section can never read past its length
+
+		object.serialise(*this);
+
+		failed = failed || position != sectionEnd;
+		position = sectionEnd;
+		end = snapshotEnd;
+		sectionsLeft--;
+		return !failed;
+	}
+
+	bool hasFailed() const
+	{
+		return failed;
+	}
+
+	//sections not restored yet
+	uint32_t getNumSectionsLeft() const
+	{
+		return sectionsLeft;
+	}
+
+
+	//Archive Functions (called from serialise())
+
+	uint32_t getVersion() const
+	{
+		return version;
+	}
+
+	template <class T>
+	void value(T& field)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be stored directly");
+		bytes(&field, sizeof(T));
+	}
+
+	//any byte other than 0 reads as true, so a damaged snapshot cannot make an invalid bool
+	void value(bool& field)
+	{
+		uint8_t byte = 0;
+		bytes(&byte, sizeof(byte));
+		field = byte != 0;
+	}
+
+	template <class T, class Allocator>
+	void array(std::vector<T, Allocator>& elements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be stored as an array");
+		uint64_t count = 0;
+		bytes(&count, sizeof(count));
+
+		if (failed || count > uint64_t(end - position) / sizeof(T))
+		{
+			failed = true;
+			elements.clear();
+			return;
+		}
+
+		elements.resize(size_t(count));
+		bytes(elements.data(), size_t(count) * sizeof(T));
+	}
+
+	///restores into a container of objects. A FixedVector too small for the saved count fails the restore.
+	template <class Container>
+	void objects(Container& container)
+	{
+		uint64_t count = 0;
+		bytes(&count, sizeof(count));
+
+		if (failed || count > uint64_t(end - position) || count > uint64_t(INT_MAX))		//every object takes at least a byte
+		{
+			failed = true;
+			container.resize(0);
+			return;
+		}
+
+		container.resize(int(count));
+		if (uint64_t(container.size()) != count)
+		{
+			failed = true;
+			container.resize(0);
+			return;
+		}
+
+		for (auto& element : container)
+		{
+			element.serialise(*this);
+		}
+	}
+
+	///fails the restore if a class invariant does not hold
+	bool check(bool condition)
+	{
+		failed = failed || !condition;
+		return !failed;
+	}
+
+private:
+	//copies the next bytes out, or zeros and fails if the section is too short
+	void bytes(void* dest, size_t numBytes)
+	{
+		if (failed || numBytes > size_t(end - position))
+		{
+			failed = true;
+			std::memset(dest, 0, numBytes);
+			return;
+		}
+
+		std::memcpy(dest, position, numBytes);
+		position += numBytes;
+	}
+
+	const uint8_t* position = nullptr;
+	const uint8_t* end = nullptr;
+	uint32_t version = 0;
+	uint32_t sectionsLeft = 0;
+	bool failed = true;
+};
+
+/**
+*A read-only memory-mapped file, so a snapshot is restored straight from the page cache without reading it into a
+*buffer first.
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	*maps a whole file into memory
+	*@param path of the file
+	*@return false if the file could not be opened or mapped (an empty file cannot be mapped)
+	*/
+	bool open(const std::string& path)
+	{
+		close();
+
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		HANDLE mapping = nullptr;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+		CloseHandle(file);
+
+		if (mapping == nullptr)
+		{
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);													//the view keeps the mapping alive
+
+		if (view == nullptr)
+		{
+			return false;
+		}
+
+		mapped = static_cast<const uint8_t*>(view);
+		numBytes = size_t(fileSize.QuadPart);
+#else
+		const int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+		void* view = MAP_FAILED;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		}
+		::close(file);															//the mapping keeps the file alive
+
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+
+		mapped = static_cast<const uint8_t*>(view);
+		numBytes = size_t(status.st_size);
+#endif
+		return true;
+	}
+
+	void close()
+	{
+		if (mapped != nullptr)
+		{
+#if defined(_WIN32)
+			UnmapViewOfFile(mapped);
+#else
+			munmap(const_cast<uint8_t*>(mapped), numBytes);
+#endif
+		}
+		mapped = nullptr;
+		numBytes = 0;
+	}
+
+	bool isOpen() const
+	{
+		return mapped != nullptr;
+	}
+
+	const uint8_t* data() const
+	{
+		return mapped;
+	}
+
+	size_t size() const
+	{
+		return numBytes;
+	}
+
+private:
+	const uint8_t* mapped = nullptr;
+	size_t numBytes = 0;
+};
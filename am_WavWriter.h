@@ -0,0 +1,346 @@
+/*
+  ==============================================================================
+
+	am_WavWriter.h
+	Created: 17 Oct 2026 7:12:33pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+*Streams 32 bit float WAV files to disk for offline rendering.
+*
+*Samples go into one of two buffers. When it is full it is handed to a writer thread and rendering carries on in the
+*other buffer, so the renderer only waits on the disk if the disk is slower than the rendering. Not for the audio
+*thread (it locks and can wait), only for offline rendering.
+*
+*Samples are written in the machine's byte order, which is correct for WAV on every little-endian machine (x86, ARM).
+*Files are limited to 4GB of samples (about 6 hours of mono at 48kHz) by the WAV format.
+*/
+class WavWriter
+{
+public:
+
+	/**
+	*@param samples per buffer. Each buffer is written to disk in one go.
+	*/
+	explicit WavWriter(int bufferSamples = 1 << 16)
+	{
+		bufferSize = std::max(bufferSamples, 1);
+		buffers[0].resize(bufferSize);
+		buffers[1].resize(bufferSize);
+	}
+
+	~WavWriter()
+	{
+		close();
+	}
+
+	WavWriter(const WavWriter&) = delete;
+	WavWriter& operator=(const WavWriter&) = delete;
+
+	/**
+	*creates the file, writes the header and starts the writer thread
+	*@param path of the file to create (overwritten if it exists)
+	*@param sample rate in Hz
+	*@param number of interleaved channels
+	*@return false if the file could not be created
+	*/
+	bool open(const std::string& path, int sampleRate, int numChannels)
+	{
+		close();
+
+		file = std::fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		channels = std::max(numChannels, 1);
+		rate = sampleRate;
+		part = false;
+		totalSamples = 0;
+		failed = false;
+		writeHeader();												//before the writer thread is there to share failed
+
+		if (failed)
+		{
+			closeUnstarted();
+			return false;
+		}
+
+		start();
+		return true;
+	}
+
+	/**
+	*opens a file another WavWriter has made with open(), to write one part of it from firstSample on while other
+	*writers write the rest (e.g. segments of one render on several threads). A part writer leaves the header alone:
+	*the writer that made the file is closed last, after setTotalSamples().
+	*@param path of a file made by open()
+	*@param first sample (not frame) this writer writes
+	*@return false if the file could not be opened or moved to firstSample
+	*/
+	bool openPart(const std::string& path, uint64_t firstSample)
+	{
+		close();
+
+		file = std::fopen(path.c_str(), "r+b");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		part = true;
+
+		if (!seekTo(headerBytes + firstSample * 4))					//before the writer thread starts writing from here
+		{
+			closeUnstarted();
+			return false;
+		}
+
+		start();
+		return true;
+	}
+
+	/**
+	*for a file written in parts (see openPart()): the samples in the whole file, for close() to write into the header
+	*@param number of samples (not frames)
+	*/
+	void setTotalSamples(uint64_t numSamples)
+	{
+		totalSamples = numSamples;
+	}
+
+	bool isOpen() const
+	{
+		return file != nullptr;
+	}
+
+	//true if a write to disk has failed since open()
+	bool hasFailed() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return failed;
+	}
+
+	/**
+	*adds interleaved samples to the file
+	*@param samples, numChannels per frame
+	*@param number of samples (not frames)
+	*/
+	void write(const float* samples, int numSamples)
+	{
+		while (numSamples > 0 && file != nullptr)
+		{
+			const int count = std::min(numSamples, bufferSize - fillCount);
+			std::copy(samples, samples + count, buffers[fillIndex].data() + fillCount);
+			fillCount += count;
+			samples += count;
+			numSamples -= count;
+
+			if (fillCount == bufferSize)
+			{
+				submitBuffer();
+			}
+		}
+	}
+
+	/**
+	*writes what is left, fills in the sizes in the header and closes the file
+	*@return false if anything failed to write
+	*/
+	bool close()
+	{
+		if (file == nullptr)
+		{
+			return true;
+		}
+
+		if (fillCount > 0)
+		{
+			submitBuffer();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			stopping = true;
+			changed.notify_all();
+		}
+		writerThread.join();
+
+		if (!part)
+		{
+			writeSizes();
+		}
+		const bool ok = !failed && std::fclose(file) == 0;
+		file = nullptr;
+		return ok;
+	}
+
+private:
+
+	//clears the buffers and starts the writer thread on a newly opened file
+	void start()
+	{
+		samplesWritten = 0;
+		failed = false;
+		fillCount = 0;
+		fillIndex = 0;
+		pendingIndex = -1;
+		stopping = false;
+		writerThread = std::thread([this] { writerLoop(); });
+	}
+
+	//closes a file that failed to open properly, before any writer thread was started
+	void closeUnstarted()
+	{
+		std::fclose(file);
+		file = nullptr;
+	}
+
+	//moves to a byte offset, past 2GB too
+	bool seekTo(uint64_t offset)
+	{
+#ifdef _WIN32
+		return _fseeki64(file, int64_t(offset), SEEK_SET) == 0;
+#else
+		return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+	}
+
+	//hands the fill buffer to the writer thread, waiting for it to finish the other one first
+	void submitBuffer()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this] { return pendingIndex == -1; });
+
+		pendingIndex = fillIndex;
+		pendingCount = fillCount;
+		changed.notify_all();
+
+		fillIndex ^= 1;
+		fillCount = 0;
+	}
+
+	void writerLoop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (;;)
+		{
+			changed.wait(lock, [this] { return pendingIndex != -1 || stopping; });
+
+			if (pendingIndex == -1)
+			{
+				return;
+			}
+
+			const int index = pendingIndex;
+			const int count = pendingCount;
+			lock.unlock();
+
+			const bool ok = std::fwrite(buffers[index].data(), sizeof(float), size_t(count), file) == size_t(count);
+
+			lock.lock();
+			samplesWritten += uint64_t(count);
+			failed = failed || !ok;
+			pendingIndex = -1;
+			changed.notify_all();
+		}
+	}
+
+	void writeUInt32(uint32_t value)
+	{
+		const unsigned char bytes[4] = { (unsigned char)(value), (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+		failed = failed || std::fwrite(bytes, 1, 4, file) != 4;
+	}
+
+	void writeUInt16(uint16_t value)
+	{
+		const unsigned char bytes[2] = { (unsigned char)(value), (unsigned char)(value >> 8) };
+		failed = failed || std::fwrite(bytes, 1, 2, file) != 2;
+	}
+
+	void writeTag(const char* tag)
+	{
+		failed = failed || std::fwrite(tag, 1, 4, file) != 4;
+	}
+
+	//RIFF header, fmt chunk for IEEE float and the fact chunk it needs. Sizes are filled in by writeSizes().
+	void writeHeader()
+	{
+		writeTag("RIFF");
+		writeUInt32(0);
+		writeTag("WAVE");
+
+		writeTag("fmt ");
+		writeUInt32(18);
+		writeUInt16(3);														//WAVE_FORMAT_IEEE_FLOAT
+		writeUInt16(uint16_t(channels));
+		writeUInt32(uint32_t(rate));
+		writeUInt32(uint32_t(rate) * uint32_t(channels) * 4);				//bytes per second
+		writeUInt16(uint16_t(channels * 4));								//bytes per frame
+		writeUInt16(32);													//bits per sample
+		writeUInt16(0);														//no extra format bytes
+
+		writeTag("fact");
+		writeUInt32(4);
+		writeUInt32(0);														//frames
+
+		writeTag("data");
+		writeUInt32(0);
+	}
+
+	void writeSizes()
+	{
+		const uint64_t numSamples = std::max(samplesWritten, totalSamples);
+		const uint64_t maxDataBytes = 0xffffffffull - headerBytes;
+		const uint64_t dataBytes = std::min(numSamples * 4, maxDataBytes);
+
+		failed = failed || dataBytes < numSamples * 4;						//too long for a WAV file
+
+		std::fseek(file, 4, SEEK_SET);
+		writeUInt32(uint32_t(dataBytes + headerBytes - 8));
+
+		std::fseek(file, factFramesOffset, SEEK_SET);
+		writeUInt32(uint32_t(dataBytes / (4 * uint64_t(channels))));
+
+		std::fseek(file, headerBytes - 4, SEEK_SET);
+		writeUInt32(uint32_t(dataBytes));
+	}
+
+	static constexpr int headerBytes = 58;									//RIFF 12 + fmt 26 + fact 12 + data 8
+	static constexpr int factFramesOffset = 46;
+
+	std::FILE* file = nullptr;
+	int channels = 1;
+	int rate = 44100;
+
+	std::vector<float> buffers[2];
+	int bufferSize = 0;
+	int fillIndex = 0;														//buffer being filled by write()
+	int fillCount = 0;
+
+	mutable std::mutex mutex;
+	std::condition_variable changed;
+	std::thread writerThread;
+	int pendingIndex = -1;													//buffer waiting for (or being written by) the writer thread
+	int pendingCount = 0;
+	bool stopping = false;
+	bool failed = false;
+	uint64_t samplesWritten = 0;
+	uint64_t totalSamples = 0;												//set for files written in parts
+	bool part = false;														//opened with openPart(): no header
+};
@@ -0,0 +1,442 @@
+/*
+  ==============================================================================
+
+	am_bench.cpp
+	Created: 17 Oct 2026 6:41:27pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*Micro-benchmarks for every synthesis class. Each case renders blocks with processBlock() for a fixed time and prints
+*the cost in ns/sample and the throughput in samples/sec, so runs can be compared to catch regressions.
+*
+*Usage: am_bench [seconds per case] [name filter]
+*e.g.   am_bench 0.5 clusterChord
+*/
+
+#include "am_AdditiveEngine.h"
+#include "am_Chords.h"
+#include "am_ChordVoiceManager.h"
+#include "am_DoubleCombFilter.h"
+#include "am_DurationOnOffWave.h"
+#include "am_FDNReverb.h"
+#include "am_FMEngine.h"
+#include "am_MultiTapDelay.h"
+#include "am_Oversampler.h"
+#include "am_ParameterExchange.h"
+#include "am_Phase_Modulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr float sampleRate = 48000.0f;
+	constexpr int blockSize = 512;
+
+	double secondsPerCase = 0.25;
+	std::string filter;
+	volatile float sink = 0.0f;								//keeps the optimiser from removing the rendering
+
+	/**
+	*renders blocks until secondsPerCase has passed and prints the result
+	*@param name of the case
+	*@param function rendering one block of blockSize samples into the buffer it is given
+	*/
+	template <class RenderBlock>
+	void runCase(const std::string& name, RenderBlock&& renderBlock)
+	{
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+		{
+			return;
+		}
+
+		using Clock = std::chrono::steady_clock;
+		std::vector<float> buffer(blockSize);
+
+		for (int i = 0; i < 16; i++)						//warm up caches and any lazily built tables
+		{
+			renderBlock(buffer.data());
+		}
+
+		long long samples = 0;
+		const auto start = Clock::now();
+		auto now = start;
+
+		do
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				renderBlock(buffer.data());
+			}
+			samples += 16 * blockSize;
+			now = Clock::now();
+		}
+		while (std::chrono::duration<double>(now - start).count() < secondsPerCase);
+
+		sink = sink + buffer[blockSize - 1];
+
+		const double seconds = std::chrono::duration<double>(now - start).count();
+		const double nsPerSample = seconds * 1e9 / double(samples);
+		std::printf("%-40s %12.2f ns/sample %16.0f samples/sec\n", name.c_str(), nsPerSample, double(samples) / seconds);
+	}
+
+	void benchOscillators()
+	{
+		const char* waveNames[] = { "phasor", "sine", "square", "triangle", "sawtooth" };
+
+		for (int wave = 0; wave < 5; wave++)
+		{
+			Oscillator osc;
+			osc.setUp(sampleRate, 440.0f, wave);
+			runCase(std::string("Oscillator/") + waveNames[wave], [&](float* out) { osc.processBlock(out, blockSize); });
+		}
+
+		for (int wave = 0; wave < 5; wave++)
+		{
+			Oscillator osc;
+			osc.setUp(sampleRate, 440.0f, wave);
+			osc.setPhaseMode(PhaseMode::fixedPoint);
+			runCase(std::string("Oscillator/") + waveNames[wave] + " fixed", [&](float* out) { osc.processBlock(out, blockSize); });
+		}
+	}
+
+	void benchChords()
+	{
+		for (int octaves = 1; octaves <= 8; octaves++)
+		{
+			Chord chord;
+			chord.setUp(sampleRate, 110.0f, 4, 0, octaves);
+			runCase("Chord/octaves=" + std::to_string(octaves), [&](float* out) { chord.processBlock(out, blockSize); });
+		}
+	}
+
+	//a chord gliding the whole time, to compare with the static chords above
+	void benchChordGlide()
+	{
+		Chord chord;
+		chord.setUp(sampleRate, 110.0f, 4, 0, 4);
+		bool up = true;
+
+		runCase("Chord/octaves=4 glide", [&](float* out)
+		{
+			if (!chord.isRamping())
+			{
+				chord.rampMajorBaseFrequency(up ? 220.0f : 110.0f, 16 * blockSize);
+				up = !up;
+			}
+			chord.processBlock(out, blockSize);
+		});
+	}
+
+	void benchClusters()
+	{
+		for (int chords = 1; chords <= 64; chords *= 2)
+		{
+			clusterChord cluster;
+			cluster.setUpCluster(sampleRate, chords, 1);
+			runCase("clusterChord/chords=" + std::to_string(chords), [&](float* out) { cluster.processBlock(out, blockSize); });
+		}
+	}
+
+	void benchPhiModulator()
+	{
+		PhiModulator modulator;
+		modulator.setUpPhiModulator(sampleRate, 440.0f, 1, 110.0f, 1, 2.0f);
+		runCase("PhiModulator", [&](float* out) { modulator.processBlock(out, blockSize); });
+
+		const OversamplingPhase phases[] = { OversamplingPhase::linear, OversamplingPhase::minimum };
+		const char* phaseNames[] = { "linear", "minimum" };
+
+		for (int factor = 2; factor <= 8; factor *= 2)
+		{
+			for (int p = 0; p < 2; p++)
+			{
+				Oversampled<PhiModulator> oversampled;
+				oversampled.setOversampling(sampleRate, factor, phases[p]);
+				oversampled.get().setUpPhiModulator(oversampled.getOversampledRate(), 440.0f, 1, 110.0f, 1, 2.0f);
+				runCase("PhiModulator/x" + std::to_string(factor) + " " + phaseNames[p], [&](float* out) { oversampled.processBlock(out, blockSize); });
+			}
+		}
+	}
+
+	//six operators in one chain, to compare with PhiModulator (two operators) above
+	void benchFMEngine()
+	{
+		const SineMode modes[] = { SineMode::exact, SineMode::polynomial };
+		const char* modeNames[] = { "exact", "polynomial" };
+
+		for (int m = 0; m < 2; m++)
+		{
+			FMEngine<FMStack<6>> engine;
+			engine.setUp(sampleRate, 220.0f);
+			engine.setSineMode(modes[m]);
+			for (int op = 1; op < 6; op++)
+			{
+				engine.setRatio(op, float(op + 1));
+				engine.setLevel(op, 1.5f);
+			}
+			engine.setFeedback(5, 0.5f);
+
+			runCase(std::string("FMEngine/stack6 ") + modeNames[m], [&](float* out) { engine.processBlock(out, blockSize); });
+		}
+	}
+
+	//where the inverse FFT overtakes the rotations depends on the instruction set, see AdditiveEngine::getFftThreshold()
+	void benchAdditive()
+	{
+		const AdditiveMode modes[] = { AdditiveMode::rotation, AdditiveMode::inverseFft };
+		const char* modeNames[] = { "rotation", "inverseFft" };
+
+		for (int partials = 16; partials <= 1024; partials *= 4)
+		{
+			for (int m = 0; m < 2; m++)
+			{
+				AdditiveEngine engine;
+				engine.setUp(sampleRate, 20.0f, partials);
+				engine.setMode(modes[m]);
+				runCase("AdditiveEngine/partials=" + std::to_string(partials) + " " + modeNames[m], [&](float* out) { engine.processBlock(out, blockSize); });
+			}
+		}
+	}
+
+	void benchDurationWave()
+	{
+		DurationWave duration;
+		duration.setUpDuration(sampleRate, 4.0f, 1.0f, 3.0f);
+		runCase("DurationWave", [&](float* out) { duration.processBlock(out, blockSize); });
+	}
+
+	//32 filters with long delays, so their buffers (16MB of floats) stream from memory rather than sit in cache
+	template <class Storage>
+	void benchCombStorage(const char* name)
+	{
+		std::vector<BasicDoubleCombFilter<Storage>> combs(32);
+		for (size_t c = 0; c < combs.size(); c++)
+		{
+			combs[c].setSampleRate(sampleRate);
+			combs[c].setMaxDelay(2);
+			combs[c].setDelayTimes(0.6f + 0.037f * float(c), 1.1f + 0.029f * float(c));
+			combs[c].setFeedback(0.5f, 0.3f);
+		}
+
+		std::vector<float> input(blockSize);
+		SeededRandom random(1);
+		for (auto& sample : input)
+		{
+			sample = random.nextFloat() * 2.0f - 1.0f;
+		}
+
+		runCase(std::string("DoubleCombFilter/32 filters ") + name, [&](float* out)
+		{
+			std::fill(out, out + blockSize, 0.0f);
+			for (auto& comb : combs)
+			{
+				comb.processBlockAdd(input.data(), out, blockSize);
+			}
+		});
+	}
+
+	void benchCombFilter()
+	{
+		const float delayTimes[] = { 0.001f, 0.01f, 0.1f, 1.0f };
+
+		for (float delay : delayTimes)
+		{
+			DoubleCombFilter comb;
+			comb.setSampleRate(sampleRate);
+			comb.setMaxDelay(2);
+			comb.setDelayTimes(delay, delay * 0.73f);
+			comb.setFeedback(0.5f, 0.3f);
+
+			std::vector<float> input(blockSize);
+			SeededRandom random(1);
+			for (auto& sample : input)
+			{
+				sample = random.nextFloat() * 2.0f - 1.0f;
+			}
+
+			runCase("DoubleCombFilter/delay=" + std::to_string(int(delay * 1000.0f)) + "ms",
+					[&](float* out) { comb.processBlock(input.data(), out, blockSize); });
+		}
+
+		//a tail decaying into denormals, then silence: the cases the denormal flush and the bypass are for
+		const float thresholds[] = { 0.0f, 1.0e-6f };
+		for (float threshold : thresholds)
+		{
+			DoubleCombFilter comb;
+			comb.setSampleRate(sampleRate);
+			comb.setMaxDelay(2);
+			comb.setDelayTimes(0.01f, 0.0073f);
+			comb.setFeedback(0.5f, 0.3f);
+			comb.setTailThreshold(threshold);
+
+			std::vector<float> input(blockSize);
+			for (int i = 0; i < blockSize; i++)
+			{
+				input[i] = 1.0e-39f * float(i % 5 + 1);
+			}
+
+			runCase(threshold > 0.0f ? "DoubleCombFilter/denormal input bypassed" : "DoubleCombFilter/denormal input",
+					[&](float* out) { comb.processBlock(input.data(), out, blockSize); });
+		}
+
+		//the parameter exchange checked every block, with nothing new and with a new set every block (written on this
+		//thread here, so the cost of write() is counted too)
+		for (int writeEveryBlock = 0; writeEveryBlock < 2; writeEveryBlock++)
+		{
+			DoubleCombFilter comb;
+			comb.setSampleRate(sampleRate);
+			comb.setMaxDelay(2);
+			comb.setDelayTimes(0.01f, 0.0073f);
+			comb.setFeedback(0.5f, 0.3f);
+
+			ParameterExchange<DoubleCombFilter::Parameters> parameters(comb.getParameters());
+			DoubleCombFilter::Parameters next = comb.getParameters();
+
+			std::vector<float> input(blockSize);
+			SeededRandom random(1);
+			for (auto& sample : input)
+			{
+				sample = random.nextFloat() * 2.0f - 1.0f;
+			}
+
+			runCase(writeEveryBlock ? "DoubleCombFilter/new parameters" : "DoubleCombFilter/parameter check",
+					[&](float* out)
+			{
+				if (writeEveryBlock)
+				{
+					next.feedbackOne = next.feedbackOne > 0.5f ? 0.4f : 0.6f;
+					parameters.write(next);
+				}
+				parameters.applyTo(comb);
+				comb.processBlock(input.data(), out, blockSize);
+			});
+		}
+
+		benchCombStorage<Float32Storage>("fp32");
+		benchCombStorage<Float16Storage>("fp16");
+		benchCombStorage<Int16Storage>("int16");
+	}
+
+	//16 taps here against 8 DoubleCombFilters above is the same number of reads from one buffer instead of eight
+	void benchMultiTapDelay()
+	{
+		std::vector<float> input(blockSize);
+		SeededRandom random(1);
+		for (auto& sample : input)
+		{
+			sample = random.nextFloat() * 2.0f - 1.0f;
+		}
+
+		for (int taps = 1; taps <= 16; taps *= 4)
+		{
+			MultiTapDelay<16> delay;
+			delay.setSampleRate(sampleRate);
+			delay.setMaxDelay(2.0f);
+			delay.setNumTaps(taps);
+			for (int k = 0; k < taps; k++)
+			{
+				delay.setTap(k, 0.05f + 0.09f * float(k), 0.5f / float(taps), 0.5f);
+			}
+
+			runCase("MultiTapDelay/taps=" + std::to_string(taps), [&](float* out) { delay.processBlock(input.data(), out, blockSize); });
+		}
+
+		DoubleCombFilter combs[8];
+		for (int c = 0; c < 8; c++)
+		{
+			combs[c].setSampleRate(sampleRate);
+			combs[c].setMaxDelay(2);
+			combs[c].setDelayTimes(0.05f + 0.18f * float(c), 0.14f + 0.18f * float(c));
+			combs[c].setFeedback(0.3f, 0.3f);
+		}
+		runCase("MultiTapDelay/8 DoubleCombFilters", [&](float* out)
+		{
+			std::fill(out, out + blockSize, 0.0f);
+			for (auto& comb : combs)
+			{
+				comb.processBlockAdd(input.data(), out, blockSize);
+			}
+		});
+	}
+
+	template <int NumLines>
+	void benchFDNReverb(const std::vector<float>& input)
+	{
+		const FdnMixing mixings[] = { FdnMixing::hadamard, FdnMixing::householder };
+		const char* mixingNames[] = { "hadamard", "householder" };
+
+		for (int m = 0; m < 2; m++)
+		{
+			FDNReverb<NumLines> reverb;
+			reverb.setSampleRate(sampleRate);
+			reverb.setDecayTime(2.0f);
+			reverb.setMixing(mixings[m]);
+
+			runCase("FDNReverb/lines=" + std::to_string(NumLines) + " " + mixingNames[m],
+					[&](float* out) { reverb.processBlock(input.data(), out, blockSize); });
+		}
+	}
+
+	//compare with DoubleCombFilter per sample, which is how reverbs were built from it before
+	void benchReverbs()
+	{
+		std::vector<float> input(blockSize);
+		SeededRandom random(1);
+		for (auto& sample : input)
+		{
+			sample = random.nextFloat() * 2.0f - 1.0f;
+		}
+
+		benchFDNReverb<8>(input);
+		benchFDNReverb<16>(input);
+
+		DoubleCombFilter comb;
+		comb.setSampleRate(sampleRate);
+		comb.setMaxDelay(2);
+		comb.setDelayTimes(0.031f, 0.047f);
+		comb.setFeedback(0.5f, 0.4f);
+		runCase("FDNReverb/DoubleCombFilter process()", [&](float* out)
+		{
+			for (int i = 0; i < blockSize; i++)
+			{
+				out[i] = comb.process(input[i]);
+			}
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1)
+	{
+		secondsPerCase = std::atof(argv[1]);
+	}
+	if (argc > 2)
+	{
+		filter = argv[2];
+	}
+
+	std::printf("block size %d, sample rate %.0f Hz, %.2f s per case\n\n", blockSize, double(sampleRate), secondsPerCase);
+
+	benchOscillators();
+	benchChords();
+	benchChordGlide();
+	benchClusters();
+	benchPhiModulator();
+	benchFMEngine();
+	benchAdditive();
+	benchDurationWave();
+	benchCombFilter();
+	benchMultiTapDelay();
+	benchReverbs();
+
+	return 0;
+}
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+	am_Test.h
+	Created: 17 Oct 2026 8:12:40am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Random.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+*A small test harness for the equivalence tests (no dependencies, like the rest of the build).
+*
+*Each test file defines its cases with AM_TEST(name) and ends with AM_TEST_MAIN(). A case fails if any AM_CHECK in it
+*fails; the program runs every case (or those whose names contain its first argument) and returns 1 if any failed, so
+*CTest reports it.
+*
+*Most checks compare two ways of getting the same samples, e.g. process() in a loop against processBlock(). The
+*helpers below render both ways; blocks are of uneven lengths (1 to 509 samples) and alternate between processBlock()
+*and processBlockAdd(), so block boundaries land everywhere.
+*/
+namespace amtest
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*run)();
+	};
+
+	inline std::vector<TestCase>& getTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	inline int& getNumFailedChecks()
+	{
+		static int numFailed = 0;
+		return numFailed;
+	}
+
+	struct Registration
+	{
+		Registration(const char* name, void (*run)())
+		{
+			getTestCases().push_back({ name, run });
+		}
+	};
+
+	inline bool checkCondition(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition)
+		{
+			std::printf("    %s:%d: check failed: %s\n", file, line, expression);
+			getNumFailedChecks()++;
+		}
+		return condition;
+	}
+
+	inline int runTests(int argc, char* argv[])
+	{
+		const std::string filter = argc > 1 ? argv[1] : "";
+		int numFailedCases = 0;
+		int numRun = 0;
+
+		for (const auto& testCase : getTestCases())
+		{
+			if (!filter.empty() && std::string(testCase.name).find(filter) == std::string::npos)
+			{
+				continue;
+			}
+
+			const int failedBefore = getNumFailedChecks();
+			testCase.run();
+			numRun++;
+
+			const bool passed = getNumFailedChecks() == failedBefore;
+			numFailedCases += passed ? 0 : 1;
+			std::printf("%-60s %s\n", testCase.name, passed ? "ok" : "FAILED");
+		}
+
+		std::printf("%d of %d cases passed\n", numRun - numFailedCases, numRun);
+		return numFailedCases == 0 && numRun > 0 ? 0 : 1;
+	}
+
+	//samples that are not equal (NaN counts as different; 0 and -0 do not)
+	inline int countDifferences(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return int(std::max(a.size(), b.size()));
+		}
+
+		int differences = 0;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			differences += a[i] == b[i] ? 0 : 1;
+		}
+		return differences;
+	}
+
+	//the next of the uneven block lengths, 1 to 509
+	inline int nextBlockSize(int blockSize)
+	{
+		return blockSize * 7 % 509 + 1;
+	}
+
+	//a generator's output from process() in a loop
+	template <class Generator>
+	std::vector<float> renderSamples(Generator& generator, int numSamples)
+	{
+		std::vector<float> out(numSamples);
+		for (auto& sample : out)
+		{
+			sample = generator.process();
+		}
+		return out;
+	}
+
+	//a generator's output from processBlock() and processBlockAdd() (into silence) over uneven blocks
+	template <class Generator>
+	std::vector<float> renderBlocks(Generator& generator, int numSamples)
+	{
+		std::vector<float> out(numSamples, 0.0f);
+		bool add = false;
+
+		for (int done = 0, blockSize = 1; done < numSamples; done += blockSize, blockSize = nextBlockSize(blockSize))
+		{
+			blockSize = std::min(blockSize, numSamples - done);
+
+			if (add)
+			{
+				generator.processBlockAdd(out.data() + done, blockSize);
+			}
+			else
+			{
+				generator.processBlock(out.data() + done, blockSize);
+			}
+			add = !add;
+		}
+		return out;
+	}
+
+	//a filter's output from process(input) in a loop
+	template <class Filter>
+	std::vector<float> filterSamples(Filter& filter, const std::vector<float>& input)
+	{
+		std::vector<float> out(input.size());
+		for (size_t i = 0; i < input.size(); i++)
+		{
+			out[i] = filter.process(input[i]);
+		}
+		return out;
+	}
+
+	//a filter's output over uneven blocks, taking turns with processBlock(), in place processBlock() and processBlockAdd().
+	//blockScale multiplies the block lengths, for blocks longer than the 509 samples a filter usually sees.
+	template <class Filter>
+	std::vector<float> filterBlocks(Filter& filter, const std::vector<float>& input, int blockScale = 1)
+	{
+		const int numSamples = int(input.size());
+		std::vector<float> out(numSamples, 0.0f);
+		int form = 0;
+
+		for (int done = 0, step = 1; done < numSamples; step = nextBlockSize(step))
+		{
+			const int blockSize = std::min(step * blockScale, numSamples - done);
+
+			switch (form)
+			{
+				case 0:
+					filter.processBlock(input.data() + done, out.data() + done, blockSize);
+					break;
+				case 1:
+					std::copy(input.begin() + done, input.begin() + done + blockSize, out.begin() + done);
+					filter.processBlock(out.data() + done, blockSize);
+					break;
+				default:
+					filter.processBlockAdd(input.data() + done, out.data() + done, blockSize);
+					break;
+			}
+			form = (form + 1) % 3;
+			done += blockSize;
+		}
+		return out;
+	}
+
+	//moves a generator on numSamples with processBlock(), the reference for skipSamples()
+	template <class Generator>
+	void stepSamples(Generator& generator, int64_t numSamples)
+	{
+		std::vector<float> discard(4096);
+		for (int64_t done = 0; done < numSamples;)
+		{
+			const int blockSize = int(std::min<int64_t>(int64_t(discard.size()), numSamples - done));
+			generator.processBlock(discard.data(), blockSize);
+			done += blockSize;
+		}
+	}
+
+	//true if skipSamples(numSamples) leaves a copy of the generator giving the same next numCompared samples as stepping
+	template <class Generator>
+	bool skipMatchesStepping(const Generator& generator, int64_t numSamples, int numCompared = 4096)
+	{
+		Generator stepped = generator;
+		Generator skipped = generator;
+		stepSamples(stepped, numSamples);
+		skipped.skipSamples(numSamples);
+		return countDifferences(renderBlocks(stepped, numCompared), renderBlocks(skipped, numCompared)) == 0;
+	}
+
+	//white noise in [-amplitude, amplitude)
+	inline std::vector<float> makeNoise(int numSamples, float amplitude = 0.5f, uint64_t seed = 1)
+	{
+		SeededRandom random(seed);
+		std::vector<float> noise(numSamples);
+		for (auto& sample : noise)
+		{
+			sample = amplitude * (random.nextFloat() * 2.0f - 1.0f);
+		}
+		return noise;
+	}
+}
+
+#define AM_TEST(name) \
+	static void name(); \
+	static const amtest::Registration name##Registration(#name, name); \
+	static void name()
+
+#define AM_CHECK(condition) amtest::checkCondition((condition), #condition, __FILE__, __LINE__)
+
+#define AM_TEST_MAIN() \
+	int main(int argc, char* argv[]) \
+	{ \
+		return amtest::runTests(argc, argv); \
+	}
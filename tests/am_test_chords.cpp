@@ -0,0 +1,282 @@
+/*
+  ==============================================================================
+
+	am_test_chords.cpp
+	Created: 17 Oct 2026 8:38:14am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*Chord, FixedChord, clusterChord, FixedClusterChord and ChordVoiceManager: process() against the block functions, with
+*and without the oscillator bank, the thread pool against one thread, and skipSamples() against stepping. Empty chords,
+*clusters and banks must render silence (and return), glides carry on through a sample rate change, end in the bank
+*and are not restarted by rebuilding it, clusters differ unless seeded, and a stolen voice must not jump in level.
+*/
+
+#include "am_Test.h"
+#include "am_Chords.h"
+#include "am_ChordVoiceManager.h"
+#include "am_RenderThreadPool.h"
+
+#include <cmath>
+
+namespace
+{
+	constexpr float sampleRate = 48000.0f;
+
+	template <class ChordType>
+	ChordType makeChord(int waveIndex, int chordChoice, bool useBank)
+	{
+		ChordType chord;
+		chord.setUp(sampleRate, 110.0f, waveIndex, chordChoice, 3);
+		chord.useOscillatorBank(useBank);
+		chord.rampMajorBaseFrequency(165.0f, 9000);
+		return chord;
+	}
+
+	template <class ClusterType>
+	ClusterType makeCluster(int waveIndex, int numChords, bool useBank)
+	{
+		ClusterType cluster;
+		cluster.setRandomSeed(7);
+		cluster.setUpCluster(sampleRate, numChords, waveIndex);
+		cluster.useOscillatorBank(useBank);
+		return cluster;
+	}
+}
+
+AM_TEST(chordBlocksMatchProcess)
+{
+	for (int wave = 0; wave <= 4; wave++)
+	{
+		for (int useBank = 0; useBank <= 1; useBank++)
+		{
+			for (int chordChoice = 0; chordChoice <= 1; chordChoice++)
+			{
+				Chord chord = makeChord<Chord>(wave, chordChoice, useBank != 0);
+				Chord other = chord;
+				AM_CHECK(amtest::countDifferences(amtest::renderSamples(chord, 20000), amtest::renderBlocks(other, 20000)) == 0);
+
+				FixedChord<3> fixedChord = makeChord<FixedChord<3>>(wave, chordChoice, useBank != 0);
+				FixedChord<3> fixedOther = fixedChord;
+				AM_CHECK(amtest::countDifferences(amtest::renderSamples(fixedChord, 20000), amtest::renderBlocks(fixedOther, 20000)) == 0);
+			}
+		}
+	}
+}
+
+AM_TEST(fixedChordMatchesChord)
+{
+	for (int wave = 0; wave <= 4; wave++)
+	{
+		Chord chord = makeChord<Chord>(wave, 1, false);
+		FixedChord<3> fixedChord = makeChord<FixedChord<3>>(wave, 1, false);
+		AM_CHECK(amtest::countDifferences(amtest::renderBlocks(chord, 20000), amtest::renderBlocks(fixedChord, 20000)) == 0);
+	}
+}
+
+AM_TEST(clusterBlocksMatchProcess)
+{
+	for (int wave = 0; wave <= 4; wave++)
+	{
+		for (int useBank = 0; useBank <= 1; useBank++)
+		{
+			clusterChord cluster = makeCluster<clusterChord>(wave, 9, useBank != 0);
+			clusterChord other = cluster;
+			AM_CHECK(amtest::countDifferences(amtest::renderSamples(cluster, 20000), amtest::renderBlocks(other, 20000)) == 0);
+
+			FixedClusterChord<9> fixedCluster = makeCluster<FixedClusterChord<9>>(wave, 9, useBank != 0);
+			FixedClusterChord<9> fixedOther = fixedCluster;
+			AM_CHECK(amtest::countDifferences(amtest::renderSamples(fixedCluster, 20000), amtest::renderBlocks(fixedOther, 20000)) == 0);
+		}
+	}
+}
+
+AM_TEST(clusterThreadPoolMatchesOneThread)
+{
+	RenderThreadPool pool(3);
+
+	for (int wave = 0; wave <= 4; wave++)
+	{
+		clusterChord cluster = makeCluster<clusterChord>(wave, 24, false);
+		clusterChord pooled = cluster;
+		pooled.setRenderThreadPool(&pool, 256);
+
+		AM_CHECK(amtest::countDifferences(amtest::renderBlocks(cluster, 20000), amtest::renderBlocks(pooled, 20000)) == 0);
+	}
+}
+
+AM_TEST(chordSkipMatchesStepping)
+{
+	const int64_t skips[] = { 0, 1, 8999, 9000, 48000 * 60 + 7 };
+
+	for (int64_t skip : skips)
+	{
+		for (int useBank = 0; useBank <= 1; useBank++)
+		{
+			AM_CHECK(amtest::skipMatchesStepping(makeChord<Chord>(4, 0, useBank != 0), skip));
+			AM_CHECK(amtest::skipMatchesStepping(makeCluster<clusterChord>(1, 6, useBank != 0), skip));
+			AM_CHECK(amtest::skipMatchesStepping(makeCluster<FixedClusterChord<6>>(2, 6, useBank != 0), skip));
+		}
+	}
+}
+
+AM_TEST(chordSampleRateChangeKeepsGlide)
+{
+	//not the square: the bank and the notes can round an edge onto different samples, a full step apart
+	for (int wave : { 0, 1, 3, 4 })
+	{
+		Chord chord = makeChord<Chord>(wave, 1, false);
+		Chord banked = makeChord<Chord>(wave, 1, true);
+		amtest::renderSamples(chord, 3000);
+		amtest::renderSamples(banked, 3000);
+
+		//the bank rescales its own glide, so the two still agree to within rounding
+		chord.setSampleRate(2.0f * sampleRate);
+		banked.setSampleRate(2.0f * sampleRate);
+		AM_CHECK(chord.isRamping() && banked.isRamping());
+
+		const std::vector<float> expected = amtest::renderSamples(chord, 9000);
+		const std::vector<float> actual = amtest::renderSamples(banked, 9000);
+		float largest = 0.0f;
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			largest = std::max(largest, std::abs(expected[i] - actual[i]));
+		}
+		AM_CHECK(largest < 0.01f);
+	}
+}
+
+AM_TEST(bankGlideEndsAndIsNotRestarted)
+{
+	Chord banked = makeChord<Chord>(1, 0, true);
+	amtest::renderBlocks(banked, 4000);
+	AM_CHECK(banked.isRamping());
+
+	//rebuilding mid-glide jumps to the target rather than gliding again from 110 Hz
+	Chord settled = banked;
+	settled.useOscillatorBank(true);
+	AM_CHECK(!settled.isRamping());
+
+	amtest::renderBlocks(banked, 5000);
+	AM_CHECK(!banked.isRamping());
+	banked.useOscillatorBank(true);
+	AM_CHECK(!banked.isRamping());
+}
+
+AM_TEST(clustersDifferUnlessSeeded)
+{
+	static clusterChord first, second, seeded, seededAgain;
+	first.setUpCluster(sampleRate, 4, 1);
+	second.setUpCluster(sampleRate, 4, 1);
+	AM_CHECK(amtest::countDifferences(amtest::renderSamples(first, 1000), amtest::renderSamples(second, 1000)) > 0);
+
+	seeded.setRandomSeed(3);
+	seededAgain.setRandomSeed(3);
+	seeded.setUpCluster(sampleRate, 4, 1);
+	seededAgain.setUpCluster(sampleRate, 4, 1);
+	AM_CHECK(amtest::countDifferences(amtest::renderSamples(seeded, 1000), amtest::renderSamples(seededAgain, 1000)) == 0);
+}
+
+AM_TEST(emptyChordsAreSilent)
+{
+	const std::vector<float> silence(5000, 0.0f);
+
+	for (int useBank = 0; useBank <= 1; useBank++)
+	{
+		Chord chord;
+		chord.setUp(sampleRate, 110.0f, 1, 0, 0);
+		chord.useOscillatorBank(useBank != 0);
+		Chord other = chord;
+		AM_CHECK(amtest::countDifferences(amtest::renderSamples(chord, 5000), silence) == 0);
+		AM_CHECK(amtest::countDifferences(amtest::renderBlocks(other, 5000), silence) == 0);
+		AM_CHECK(amtest::skipMatchesStepping(chord, 48000));
+
+		FixedChord<2> fixedChord;
+		fixedChord.setUp(sampleRate, 110.0f, 1, 0, 0);
+		fixedChord.useOscillatorBank(useBank != 0);
+		AM_CHECK(amtest::countDifferences(amtest::renderBlocks(fixedChord, 5000), silence) == 0);
+
+		clusterChord cluster = makeCluster<clusterChord>(1, 0, useBank != 0);
+		clusterChord otherCluster = cluster;
+		AM_CHECK(amtest::countDifferences(amtest::renderSamples(cluster, 5000), silence) == 0);
+		AM_CHECK(amtest::countDifferences(amtest::renderBlocks(otherCluster, 5000), silence) == 0);
+		AM_CHECK(amtest::skipMatchesStepping(cluster, 48000));
+
+		FixedClusterChord<4> fixedCluster = makeCluster<FixedClusterChord<4>>(1, 0, useBank != 0);
+		AM_CHECK(amtest::countDifferences(amtest::renderBlocks(fixedCluster, 5000), silence) == 0);
+	}
+}
+
+AM_TEST(emptyBankIsSilent)
+{
+	OscillatorBank bank;
+	bank.setSampleRate(sampleRate);
+	bank.setWaveIndex(1);
+
+	const std::vector<float> silence(5000, 0.0f);
+	AM_CHECK(amtest::countDifferences(amtest::renderBlocks(bank, 5000), silence) == 0);
+	AM_CHECK(amtest::countDifferences(amtest::renderSamples(bank, 5000), silence) == 0);
+	AM_CHECK(amtest::skipMatchesStepping(bank, 48000));
+}
+
+AM_TEST(voiceManagerBlocksMatchProcess)
+{
+	static ChordVoiceManager<8, 2> voices, other;
+
+	for (auto* manager : { &voices, &other })
+	{
+		manager->setUp(sampleRate, 4, 2);
+		manager->setEnvelope(0.002f, 0.01f);
+	}
+
+	std::vector<float> expected, actual;
+
+	//a note on or off every 700 samples, more notes than voices so some are stolen
+	for (int event = 0; event < 40; event++)
+	{
+		for (auto* manager : { &voices, &other })
+		{
+			if (event % 3 == 2)
+			{
+				manager->noteOff(event - 2);
+			}
+			else
+			{
+				manager->noteOn(event, 100.0f + 13.0f * float(event), event % 2, 0.5f + 0.01f * float(event));
+			}
+		}
+
+		const std::vector<float> samples = amtest::renderSamples(voices, 700);
+		const std::vector<float> blocks = amtest::renderBlocks(other, 700);
+		expected.insert(expected.end(), samples.begin(), samples.end());
+		actual.insert(actual.end(), blocks.begin(), blocks.end());
+	}
+
+	AM_CHECK(amtest::countDifferences(expected, actual) == 0);
+	AM_CHECK(voices.getNumActiveVoices() == other.getNumActiveVoices());
+}
+
+AM_TEST(voiceManagerStealsWithoutAJump)
+{
+	static ChordVoiceManager<1> voices;
+	voices.setUp(sampleRate, 1, 1);
+	voices.setEnvelope(0.01f, 0.1f);
+
+	//one voice, so the second note steals the first while it is still at full level
+	voices.noteOn(60, 220.0f, 1, 1.0f);
+	amtest::renderSamples(voices, 2000);
+	voices.noteOn(67, 330.0f, 1, 1.0f);
+
+	//starting the attack again from 0 would leave the first millisecond almost silent
+	float largest = 0.0f;
+	for (float sample : amtest::renderSamples(voices, 48))
+	{
+		largest = std::max(largest, std::abs(sample));
+	}
+	AM_CHECK(largest > 0.2f);
+}
+
+AM_TEST_MAIN()
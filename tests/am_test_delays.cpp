@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+	am_test_delays.cpp
+	Created: 17 Oct 2026 8:49:19am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*DoubleCombFilter, MultiTapDelay and FDNReverb: process() against the block functions for every delay-line storage,
+*for delays from one sample to the whole delay line, through feedback ramps, the silence bypass and a real-time resize.
+*
+*The block functions flush denormals and process() does not, so the inputs here stay well clear of denormal values.
+*/
+
+#include "am_Test.h"
+#include "am_DoubleCombFilter.h"
+#include "am_FDNReverb.h"
+#include "am_MultiTapDelay.h"
+
+namespace
+{
+	constexpr float sampleRate = 48000.0f;
+
+	//noise with a stretch of silence in the middle, long enough for the comb filters to bypass themselves
+	std::vector<float> makeInput()
+	{
+		std::vector<float> input = amtest::makeNoise(48000);
+		std::fill(input.begin() + 15000, input.begin() + 30000, 0.0f);
+		return input;
+	}
+
+	template <class Storage>
+	BasicDoubleCombFilter<Storage> makeComb()
+	{
+		BasicDoubleCombFilter<Storage> comb;
+		comb.setSampleRate(sampleRate);
+		comb.setMaxDelay(1);
+		comb.setDelayTimes(0.0123f, 0.0371f);
+		comb.setFeedback(0.6f, 0.3f);
+		comb.rampFeedback(0.3f, 0.65f, 9000);
+		return comb;
+	}
+
+	template <class Storage>
+	void checkComb()
+	{
+		const std::vector<float> input = makeInput();
+
+		BasicDoubleCombFilter<Storage> comb = makeComb<Storage>();
+		BasicDoubleCombFilter<Storage> other = makeComb<Storage>();
+		AM_CHECK(amtest::countDifferences(amtest::filterSamples(comb, input), amtest::filterBlocks(other, input)) == 0);
+	}
+
+	template <class Storage>
+	void checkCombResize()
+	{
+		const std::vector<float> input = makeInput();
+
+		BasicDoubleCombFilter<Storage> comb = makeComb<Storage>();
+		BasicDoubleCombFilter<Storage> other = makeComb<Storage>();
+		std::vector<float> expected = amtest::filterSamples(comb, input);
+		std::vector<float> actual = amtest::filterBlocks(other, input);
+
+		//picked up at the start of the next process call on both
+		comb.prepareMaxDelay(2, sampleRate);
+		other.prepareMaxDelay(2, sampleRate);
+
+		const std::vector<float> after = amtest::filterSamples(comb, input);
+		const std::vector<float> afterBlocks = amtest::filterBlocks(other, input);
+		expected.insert(expected.end(), after.begin(), after.end());
+		actual.insert(actual.end(), afterBlocks.begin(), afterBlocks.end());
+
+		AM_CHECK(amtest::countDifferences(expected, actual) == 0);
+		comb.releaseRetiredBuffer();
+		other.releaseRetiredBuffer();
+	}
+
+	template <class Storage>
+	void checkCombDelays()
+	{
+		//from a sample or two, where the blocks fall back to the per-sample path, to almost the whole delay line
+		const float delays[] = { 1.0f, 1.5f, 2.25f, 37.0f, 511.75f, 47999.0f };
+		const std::vector<float> input = makeInput();
+
+		for (float delay : delays)
+		{
+			BasicDoubleCombFilter<Storage> comb, other;
+			for (auto* c : { &comb, &other })
+			{
+				c->setSampleRate(sampleRate);
+				c->setMaxDelay(1);
+				c->setDelayTimes(delay / sampleRate, (0.5f * delay + 1.0f) / sampleRate);
+				c->setFeedback(0.5f, 0.4f);
+			}
+
+			AM_CHECK(amtest::countDifferences(amtest::filterSamples(comb, input), amtest::filterBlocks(other, input)) == 0);
+		}
+	}
+
+	//blocks of up to 4072 samples against a delay of nearly the whole line, so a block is longer than the samples
+	//between the write position and the oldest one a tap reads
+	template <class Storage>
+	void checkCombLongBlocks()
+	{
+		const std::vector<float> input = amtest::makeNoise(3 * 32000);
+
+		BasicDoubleCombFilter<Storage> comb, other;
+		for (auto* c : { &comb, &other })
+		{
+			c->setSampleRate(32000.0f);
+			c->setMaxDelay(2);
+			c->setDelayTimes(2.0f, 1.9f);
+			c->setFeedback(0.6f, 0.3f);
+		}
+
+		AM_CHECK(amtest::countDifferences(amtest::filterSamples(comb, input), amtest::filterBlocks(other, input, 8)) == 0);
+	}
+
+	template <class Storage>
+	void checkMultiTap()
+	{
+		const std::vector<float> input = makeInput();
+		MultiTapDelay<8, Storage> delay, other;
+
+		for (auto* d : { &delay, &other })
+		{
+			d->setSampleRate(sampleRate);
+			d->setMaxDelay(1.0f);
+			d->setNumTaps(6);
+			for (int k = 0; k < 6; k++)
+			{
+				d->setTap(k, 0.01f + 0.037f * float(k), 0.1f, 0.5f);
+			}
+		}
+
+		AM_CHECK(amtest::countDifferences(amtest::filterSamples(delay, input), amtest::filterBlocks(other, input)) == 0);
+	}
+
+	template <int NumLines>
+	void checkReverb(FdnMixing mixing)
+	{
+		const std::vector<float> input = makeInput();
+		FDNReverb<NumLines> reverb, other;
+
+		for (auto* r : { &reverb, &other })
+		{
+			r->setSampleRate(sampleRate);
+			r->setDecayTime(2.0f);
+			r->setDamping(0.2f);
+			r->setMixing(mixing);
+		}
+
+		AM_CHECK(amtest::countDifferences(amtest::filterSamples(reverb, input), amtest::filterBlocks(other, input)) == 0);
+	}
+}
+
+AM_TEST(combBlocksMatchProcess)
+{
+	checkComb<Float32Storage>();
+	checkComb<Float16Storage>();
+	checkComb<Int16Storage>();
+}
+
+AM_TEST(combResizeMatchesBetweenProcessAndBlocks)
+{
+	checkCombResize<Float32Storage>();
+	checkCombResize<Float16Storage>();
+	checkCombResize<Int16Storage>();
+}
+
+AM_TEST(combSilenceBypasses)
+{
+	DoubleCombFilter comb = makeComb<Float32Storage>();
+	const std::vector<float> input = makeInput();
+	comb.processBlock(input.data(), std::vector<float>(29000).data(), 29000);
+	AM_CHECK(comb.isBypassed());
+}
+
+AM_TEST(combDelaysOfEveryLengthMatchProcess)
+{
+	checkCombDelays<Float32Storage>();
+	checkCombDelays<Float16Storage>();
+	checkCombDelays<Int16Storage>();
+}
+
+AM_TEST(combLongBlocksMatchProcess)
+{
+	checkCombLongBlocks<Float32Storage>();
+	checkCombLongBlocks<Float16Storage>();
+	checkCombLongBlocks<Int16Storage>();
+}
+
+AM_TEST(multiTapBlocksMatchProcess)
+{
+	checkMultiTap<Float32Storage>();
+	checkMultiTap<Float16Storage>();
+	checkMultiTap<Int16Storage>();
+}
+
+AM_TEST(reverbBlocksMatchProcess)
+{
+	checkReverb<8>(FdnMixing::hadamard);
+	checkReverb<8>(FdnMixing::householder);
+	checkReverb<16>(FdnMixing::hadamard);
+	checkReverb<16>(FdnMixing::householder);
+}
+
+AM_TEST_MAIN()
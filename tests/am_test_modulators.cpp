@@ -0,0 +1,201 @@
+/*
+  ==============================================================================
+
+	am_test_modulators.cpp
+	Created: 17 Oct 2026 8:44:52am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*PhiModulator, Oversampled, FMEngine and AdditiveEngine: process() against the block functions for every sine mode and
+*instruction set, skipSamples() against stepping, and the mode AdditiveEngine picks automatically.
+*/
+
+#include "am_Test.h"
+#include "am_AdditiveEngine.h"
+#include "am_FMEngine.h"
+#include "am_Oversampler.h"
+#include "am_Phase_Modulator.h"
+
+namespace
+{
+	constexpr float sampleRate = 48000.0f;
+
+	const InstructionSet instructionSets[] = { InstructionSet::scalar, InstructionSet::sse2, InstructionSet::avx2, InstructionSet::avx512 };
+
+	PhiModulator makePhiModulator(float rate)
+	{
+		PhiModulator modulator;
+		modulator.setUpPhiModulator(rate, 330.0f, 1, 470.0f, 1, 2.5f);
+		modulator.rampTo(400.0f, 500.0f, 3.0f, 9000);
+		return modulator;
+	}
+
+	Oversampled<PhiModulator> makeOversampled(int factor, OversamplingPhase phase)
+	{
+		Oversampled<PhiModulator> oversampled;
+		oversampled.setOversampling(sampleRate, factor, phase);
+		oversampled.get() = makePhiModulator(oversampled.getOversampledRate());
+		return oversampled;
+	}
+
+	template <class Routing>
+	FMEngine<Routing> makeEngine(SineMode sineMode, InstructionSet instructionSet)
+	{
+		FMEngine<Routing> engine;
+		engine.setUp(sampleRate, 220.0f);
+		engine.setSineMode(sineMode);
+		engine.setInstructionSet(instructionSet);
+
+		for (int op = 0; op < FMEngine<Routing>::numOperators; op++)
+		{
+			engine.setRatio(op, 1.0f + 0.5f * float(op));
+			engine.setLevel(op, op > 0 ? 1.5f : 0.8f);
+		}
+		engine.setFeedback(FMEngine<Routing>::numOperators - 1, 0.7f);
+		return engine;
+	}
+
+	template <class Routing>
+	void checkEngine()
+	{
+		for (int sine = 0; sine <= 2; sine++)
+		{
+			for (auto instructionSet : instructionSets)
+			{
+				FMEngine<Routing> engine = makeEngine<Routing>(SineMode(sine), instructionSet);
+				FMEngine<Routing> other = engine;
+				AM_CHECK(amtest::countDifferences(amtest::renderSamples(engine, 10000), amtest::renderBlocks(other, 10000)) == 0);
+			}
+		}
+	}
+}
+
+AM_TEST(phiModulatorBlocksMatchProcess)
+{
+	PhiModulator modulator = makePhiModulator(sampleRate);
+	PhiModulator other = modulator;
+	AM_CHECK(amtest::countDifferences(amtest::renderSamples(modulator, 20000), amtest::renderBlocks(other, 20000)) == 0);
+}
+
+AM_TEST(phiModulatorSkipMatchesStepping)
+{
+	const int64_t skips[] = { 0, 1, 8999, 9000, 48000 * 60 + 7 };
+
+	for (int64_t skip : skips)
+	{
+		AM_CHECK(amtest::skipMatchesStepping(makePhiModulator(sampleRate), skip));
+	}
+}
+
+AM_TEST(oversampledBlocksMatchProcess)
+{
+	const int factors[] = { 1, 2, 4, 8 };
+
+	for (int factor : factors)
+	{
+		for (int phase = 0; phase <= 1; phase++)
+		{
+			Oversampled<PhiModulator> oversampled = makeOversampled(factor, OversamplingPhase(phase));
+			Oversampled<PhiModulator> other = oversampled;
+			AM_CHECK(amtest::countDifferences(amtest::renderSamples(oversampled, 10000), amtest::renderBlocks(other, 10000)) == 0);
+		}
+	}
+}
+
+AM_TEST(oversampledSkipMatchesStepping)
+{
+	const int64_t skips[] = { 0, 1, 4095, 4096, 4097, 48000 * 60 + 7 };
+
+	for (int64_t skip : skips)
+	{
+		for (int phase = 0; phase <= 1; phase++)
+		{
+			AM_CHECK(amtest::skipMatchesStepping(makeOversampled(4, OversamplingPhase(phase)), skip));
+		}
+	}
+}
+
+AM_TEST(fmEngineBlocksMatchProcess)
+{
+	checkEngine<FMStack<6>>();
+	checkEngine<FMPairs<8>>();
+	checkEngine<FMBranches<4>>();
+	checkEngine<FMParallel<3>>();
+}
+
+AM_TEST(additiveBlocksMatchProcess)
+{
+	const int partialCounts[] = { 1, 10, 200 };
+
+	for (int numPartials : partialCounts)
+	{
+		for (auto instructionSet : instructionSets)
+		{
+			for (int mode = 0; mode <= 1; mode++)
+			{
+				AdditiveEngine engine;
+				engine.setUp(sampleRate, 123.4f, numPartials);
+				engine.setMode(mode == 0 ? AdditiveMode::rotation : AdditiveMode::inverseFft);
+				engine.setInstructionSet(instructionSet);
+
+				AdditiveEngine other = engine;
+				AM_CHECK(amtest::countDifferences(amtest::renderSamples(engine, 10000), amtest::renderBlocks(other, 10000)) == 0);
+			}
+		}
+	}
+}
+
+AM_TEST(additiveAutomaticCountsAudiblePartials)
+{
+	AdditiveEngine engine;
+	engine.setInstructionSet(InstructionSet::scalar);
+	const int numPartials = 2 * engine.getFftThreshold();
+
+	//most of the partials are over Nyquist, so too few are left for the inverse FFT to pay off
+	engine.setUp(sampleRate, sampleRate / float(engine.getFftThreshold()), numPartials);
+	AM_CHECK(engine.getNumAudiblePartials() < engine.getFftThreshold());
+	AM_CHECK(engine.getMode() == AdditiveMode::rotation);
+
+	//the same engine a few octaves down keeps every partial, but only chooses again when asked to
+	engine.setFrequency(0.1f * sampleRate / float(numPartials));
+	AM_CHECK(engine.getNumAudiblePartials() == numPartials);
+	AM_CHECK(engine.getMode() == AdditiveMode::rotation);
+	engine.setMode(AdditiveMode::automatic);
+	AM_CHECK(engine.getMode() == AdditiveMode::inverseFft);
+
+	AdditiveEngine other = engine;
+	AM_CHECK(amtest::countDifferences(amtest::renderSamples(engine, 3000), amtest::renderBlocks(other, 3000)) == 0);
+}
+
+AM_TEST(additiveAutomaticKeepsModeWhenRetuned)
+{
+	//from 300 Hz to 200 Hz, 200 partials go from under the scalar threshold to over it
+	AdditiveEngine automatic, rotation;
+	for (auto* engine : { &automatic, &rotation })
+	{
+		engine->setInstructionSet(InstructionSet::scalar);
+		engine->setUp(sampleRate, 300.0f, 200);
+	}
+	rotation.setMode(AdditiveMode::rotation);
+
+	std::vector<float> expected = amtest::renderBlocks(rotation, 3000);
+	std::vector<float> actual = amtest::renderBlocks(automatic, 3000);
+	AM_CHECK(automatic.getNumAudiblePartials() < automatic.getFftThreshold());
+
+	//retuning must carry on in the same mode rather than restart the output
+	automatic.setFrequency(200.0f);
+	rotation.setFrequency(200.0f);
+	AM_CHECK(automatic.getNumAudiblePartials() >= automatic.getFftThreshold());
+	AM_CHECK(automatic.getMode() == AdditiveMode::rotation);
+
+	const std::vector<float> after = amtest::renderBlocks(rotation, 3000);
+	const std::vector<float> afterAutomatic = amtest::renderBlocks(automatic, 3000);
+	expected.insert(expected.end(), after.begin(), after.end());
+	actual.insert(actual.end(), afterAutomatic.begin(), afterAutomatic.end());
+	AM_CHECK(amtest::countDifferences(expected, actual) == 0);
+}
+
+AM_TEST_MAIN()
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+	am_test_oscillators.cpp
+	Created: 17 Oct 2026 8:31:06am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*Oscillator, OscillatorBank and FloatPhase: process() against the block functions for every wave, sine mode, phase
+*mode and band limiting, with and without ramps, skipSamples() against stepping, and glides that carry on through a
+*sample rate change.
+*/
+
+#include "am_Test.h"
+#include "am_OscillatorBank.h"
+#include "am_Oscillators.h"
+
+#include <cmath>
+
+namespace
+{
+	constexpr float sampleRate = 48000.0f;
+
+	Oscillator makeOscillator(int waveIndex, SineMode sineMode, PhaseMode phaseMode, bool bandLimited)
+	{
+		Oscillator oscillator;
+		oscillator.setUp(sampleRate, 1234.5f, waveIndex);
+		oscillator.setSineMode(sineMode);
+		oscillator.setPhaseMode(phaseMode);
+		oscillator.setBandLimited(bandLimited);
+		oscillator.setPhaseWidth(0.3f);
+		return oscillator;
+	}
+
+	//runs a check on every combination of wave, sine mode, phase mode and band limiting
+	template <class Check>
+	void forEachOscillator(Check&& check)
+	{
+		for (int wave = 0; wave <= 4; wave++)
+		{
+			for (int sine = 0; sine <= 2; sine++)
+			{
+				for (int phase = 0; phase <= 1; phase++)
+				{
+					for (int bandLimited = 0; bandLimited <= 1; bandLimited++)
+					{
+						check(makeOscillator(wave, SineMode(sine), PhaseMode(phase), bandLimited != 0));
+					}
+				}
+			}
+		}
+	}
+
+	void startRamps(Oscillator& oscillator)
+	{
+		oscillator.rampFrequency(3300.0f, 7000);
+		oscillator.rampPhaseWidth(0.7f, 3000, RampShape::linear);
+		oscillator.rampOffset(0.001f, 2000);
+		oscillator.rampPhiMod(0.4f, 5000);
+	}
+}
+
+AM_TEST(oscillatorBlocksMatchProcess)
+{
+	forEachOscillator([](Oscillator oscillator)
+	{
+		Oscillator other = oscillator;
+		AM_CHECK(amtest::countDifferences(amtest::renderSamples(oscillator, 20000), amtest::renderBlocks(other, 20000)) == 0);
+	});
+}
+
+AM_TEST(oscillatorBlocksMatchProcessWhileRamping)
+{
+	forEachOscillator([](Oscillator oscillator)
+	{
+		startRamps(oscillator);
+		Oscillator other = oscillator;
+		AM_CHECK(amtest::countDifferences(amtest::renderSamples(oscillator, 20000), amtest::renderBlocks(other, 20000)) == 0);
+	});
+}
+
+AM_TEST(oscillatorPhiBlockMatchesProcess)
+{
+	const std::vector<float> phi = amtest::makeNoise(5000, 2.0f);
+
+	forEachOscillator([&](Oscillator oscillator)
+	{
+		oscillator.setPhiMod(1.5f);
+		Oscillator other = oscillator;
+
+		std::vector<float> expected(phi.size()), actual(phi.size());
+		for (size_t i = 0; i < phi.size(); i++)
+		{
+			oscillator.setPhi(phi[i]);
+			expected[i] = oscillator.process();
+		}
+		other.processBlockWithPhi(phi.data(), actual.data(), int(phi.size()));
+
+		AM_CHECK(amtest::countDifferences(expected, actual) == 0);
+	});
+}
+
+AM_TEST(oscillatorSkipMatchesStepping)
+{
+	const int64_t skips[] = { 0, 1, 63, 1000, 48000, 480001, 5000000 };
+
+	for (int64_t skip : skips)
+	{
+		forEachOscillator([&](Oscillator oscillator)
+		{
+			AM_CHECK(amtest::skipMatchesStepping(oscillator, skip, 2000));
+			startRamps(oscillator);
+			AM_CHECK(amtest::skipMatchesStepping(oscillator, skip, 2000));
+		});
+	}
+}
+
+AM_TEST(oscillatorSampleRateChangeKeepsGlide)
+{
+	for (auto shape : { RampShape::linear, RampShape::exponential })
+	{
+		Oscillator oscillator;
+		oscillator.setUp(sampleRate, 200.0f, 1);
+		oscillator.rampFrequency(800.0f, 9000, shape);
+		amtest::renderSamples(oscillator, 3000);
+
+		const float frequency = oscillator.getFrequency();
+		oscillator.setSampleRate(2.0f * sampleRate);
+		AM_CHECK(std::abs(oscillator.getFrequency() - frequency) < 0.001f * frequency);
+		AM_CHECK(oscillator.getFrequencyRampSamples() == 6000);
+		AM_CHECK(oscillator.getFrequencyRampShape() == shape);
+
+		amtest::renderSamples(oscillator, 6000);
+		AM_CHECK(!oscillator.isRamping() && oscillator.getFrequency() == 800.0f);
+	}
+}
+
+AM_TEST(floatPhaseSkipMatchesLoop)
+{
+	SeededRandom random(5);
+
+	for (int trial = 0; trial < 2000; trial++)
+	{
+		const float delta = trial % 3 == 0 ? random.nextFloat() * 0.5f : random.nextFloat() * 0.001f;
+		const float start = random.nextFloat();
+		const int64_t numSamples = int64_t(random.nextUInt32() % 200000);
+
+		float expected = start;
+		for (int64_t i = 0; i < numSamples; i++)
+		{
+			expected += delta;
+			expected = expected > 1.0f ? expected - 1.0f : expected;
+		}
+
+		AM_CHECK(FloatPhase::skip(start, delta, numSamples) == expected);
+	}
+}
+
+AM_TEST(oscillatorBankBlocksMatchProcess)
+{
+	const InstructionSet instructionSets[] = { InstructionSet::scalar, InstructionSet::sse2, InstructionSet::avx2, InstructionSet::avx512 };
+
+	for (auto instructionSet : instructionSets)
+	{
+		for (int wave = 0; wave <= 4; wave++)
+		{
+			OscillatorBank bank;
+			bank.setSampleRate(sampleRate);
+			bank.setWaveIndex(wave);
+			bank.setInstructionSet(instructionSet);
+
+			for (int i = 0; i < 13; i++)
+			{
+				bank.addOscillator(110.0f * float(i + 1) * 1.01f, 1.0f / float(i + 1));
+				bank.setPhaseWidth(i, 0.2f + 0.05f * float(i));
+			}
+			bank.rampFrequency(3, 700.0f, 9000);
+
+			OscillatorBank other = bank;
+			AM_CHECK(amtest::countDifferences(amtest::renderSamples(bank, 20000), amtest::renderBlocks(other, 20000)) == 0);
+		}
+	}
+}
+
+AM_TEST(oscillatorBankSkipMatchesStepping)
+{
+	OscillatorBank bank;
+	bank.setSampleRate(sampleRate);
+	bank.setWaveIndex(1);
+
+	for (int i = 0; i < 9; i++)
+	{
+		bank.addOscillator(97.0f * float(i + 1), 0.1f);
+	}
+	bank.rampFrequency(2, 1000.0f, 30000);
+	bank.rampFrequency(5, 80.0f, 7000);
+
+	const int64_t skips[] = { 0, 1, 6999, 7000, 29999, 30000, 48000 * 60 + 7 };
+	for (int64_t skip : skips)
+	{
+		AM_CHECK(amtest::skipMatchesStepping(bank, skip));
+	}
+}
+
+AM_TEST(oscillatorBankRampsEndOnTheirOwnTargets)
+{
+	//a silent second oscillator starts a longer ramp while the first is still gliding
+	OscillatorBank bank, alone;
+	for (auto* b : { &bank, &alone })
+	{
+		b->setSampleRate(sampleRate);
+		b->addOscillator(110.0f, 1.0f);
+		b->addOscillator(330.0f, 0.0f);
+		b->rampFrequency(0, 220.0f, 1000);
+	}
+
+	std::vector<float> expected = amtest::renderBlocks(alone, 900);
+	std::vector<float> actual = amtest::renderBlocks(bank, 900);
+	bank.rampFrequency(1, 440.0f, 5000);
+	AM_CHECK(bank.isRamping() && alone.isRamping());
+
+	//the first must stop at 220 Hz after its own 1000 samples, not carry on until the second's ramp ends
+	const std::vector<float> after = amtest::renderBlocks(alone, 2000);
+	const std::vector<float> afterBank = amtest::renderBlocks(bank, 2000);
+	expected.insert(expected.end(), after.begin(), after.end());
+	actual.insert(actual.end(), afterBank.begin(), afterBank.end());
+
+	AM_CHECK(amtest::countDifferences(expected, actual) == 0);
+	AM_CHECK(bank.isRamping() && !alone.isRamping());
+}
+
+AM_TEST_MAIN()
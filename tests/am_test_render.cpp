@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+	am_test_render.cpp
+	Created: 17 Oct 2026 4:52:37pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*The offline renderer: a patch rendered in segments on several threads (am_render -s, each segment skipping to its
+*start and writing its part of the file through WavWriter::openPart()) must give the same file, byte for byte, as the
+*patch rendered from the start on one thread.
+*/
+
+#include "am_Test.h"
+#include "am_RenderPatch.h"
+#include "am_WavWriter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	//the bytes of a file, empty if it cannot be read
+	std::vector<char> readFile(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	//renders a patch the way am_render does without -s
+	bool renderSerial(const PatchConfig& config)
+	{
+		WavWriter writer(1 << 16);
+		if (!writer.open(config.output, int(config.sampleRate + 0.5f), 1))
+		{
+			return false;
+		}
+
+		RenderPatch patch(config);
+		std::vector<float> block(config.blockSize);
+
+		for (int64_t done = 0; done < config.getNumSamples(); done += config.blockSize)
+		{
+			const int numSamples = int(std::min<int64_t>(config.blockSize, config.getNumSamples() - done));
+			patch.processBlock(block.data(), numSamples);
+			writer.write(block.data(), numSamples);
+		}
+		return writer.close();
+	}
+
+	//renders a patch the way am_render -s does
+	bool renderInSegments(const PatchConfig& config, int numThreads, int numSegments)
+	{
+		WavWriter writer(1 << 16);
+		if (!writer.open(config.output, int(config.sampleRate + 0.5f), 1))
+		{
+			return false;
+		}
+
+		const bool segmentsOk = renderPatchSegments(config, writer, numThreads, numSegments);
+		return writer.close() && segmentsOk;
+	}
+
+	//true if every way of cutting the patch into segments writes the same file as rendering it on one thread
+	bool segmentsMatchSerial(PatchConfig config)
+	{
+		config.output = "am_test_render_serial.wav";
+		const bool serialOk = renderSerial(config);
+		const std::vector<char> expected = readFile(config.output);
+		std::remove(config.output.c_str());
+
+		bool matches = serialOk && !expected.empty();
+		config.output = "am_test_render_segments.wav";
+
+		for (int numSegments : { 2, 3, 7 })
+		{
+			for (int numThreads : { 1, 4 })
+			{
+				matches = renderInSegments(config, numThreads, numSegments) && matches;
+				matches = readFile(config.output) == expected && matches;
+				std::remove(config.output.c_str());
+			}
+		}
+		return matches;
+	}
+
+	//a few seconds of a patch, in blocks that do not divide it evenly
+	PatchConfig makePatch(const std::string& source)
+	{
+		PatchConfig config;
+		config.source = source;
+		config.seconds = 2.5;
+		config.blockSize = 1000 + 7;
+		return config;
+	}
+}
+
+AM_TEST(segmentsMatchSerialOscillator)
+{
+	PatchConfig config = makePatch("oscillator");
+	config.wave = 4;
+	config.bandLimited = true;
+	AM_CHECK(segmentsMatchSerial(config));
+}
+
+AM_TEST(segmentsMatchSerialChord)
+{
+	PatchConfig config = makePatch("chord");
+	config.octaves = 2;
+	config.oscillatorBank = true;
+	AM_CHECK(segmentsMatchSerial(config));
+}
+
+AM_TEST(segmentsMatchSerialGatedCluster)
+{
+	//like tools/patches/cluster_pad.txt: the window skips the source while silent, and the comb rings out over it
+	PatchConfig config = makePatch("cluster");
+	config.chords = 6;
+	config.sineMode = SineMode::polynomial;
+	config.oscillatorBank = true;
+	config.durationLength = 0.7f;
+	config.durationStart = 0.1f;
+	config.durationEnd = 0.4f;
+	config.durationFade = 0.05f;
+	config.comb = true;
+	AM_CHECK(segmentsMatchSerial(config));
+}
+
+AM_TEST(segmentsMatchSerialOversampledPhiModulator)
+{
+	PatchConfig config = makePatch("phimod");
+	config.modulatorFrequency = 470.0f;
+	config.modulationIndex = 2.5f;
+	config.oversampling = 4;
+	AM_CHECK(segmentsMatchSerial(config));
+}
+
+AM_TEST(openPartFailsCleanly)
+{
+	//no file to open: the writer must not start, and closing it must be harmless
+	WavWriter writer(1024);
+	AM_CHECK(!writer.openPart("am_test_render_missing/none.wav", 0));
+	AM_CHECK(!writer.isOpen());
+	AM_CHECK(writer.close());
+}
+
+AM_TEST_MAIN()
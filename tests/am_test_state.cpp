@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+	am_test_state.cpp
+	Created: 17 Oct 2026 8:53:47am
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*DurationWave and snapshots: process() against the block functions and skipSamples() against stepping for the
+*duration wave, getSilentSamplesAhead() against the samples it promises are silent, and snapshot restores that carry on
+*sample for sample, or fail cleanly when the snapshot is damaged or holds a value out of range.
+*
+*ParameterExchange: a set handed over sounds the same as the setters, and a reader racing a writer only sees whole sets.
+*/
+
+#include "am_Test.h"
+#include "am_Chords.h"
+#include "am_DoubleCombFilter.h"
+#include "am_DurationOnOffWave.h"
+#include "am_ParameterExchange.h"
+#include "am_Phase_Modulator.h"
+#include "am_Snapshot.h"
+
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	constexpr float sampleRate = 48000.0f;
+
+	struct Window
+	{
+		float length, start, end, fade;
+	};
+
+	//windows with fades of every length, one never ending and one too short for its fades
+	const Window windows[] = { { 1.0f, 0.2f, 0.7f, 0.05f }, { 0.5f, 0.0f, 0.3f, 0.1f }, { 2.0f, 0.5f, 3.0f, 0.2f },
+							   { 0.3f, 0.1f, 0.25f, 0.5f }, { 1.0f, 0.9f, 0.95f, 0.01f }, { 1.0f, 0.2f, 0.7f, 0.0f } };
+
+	DurationWave makeDuration(const Window& window)
+	{
+		DurationWave duration;
+		duration.setUpDuration(sampleRate, window.length, window.start, window.end);
+		duration.setFadeTime(window.fade);
+		return duration;
+	}
+
+	//everything a snapshot covers, rendered together
+	struct Session
+	{
+		Chord chord;
+		FixedClusterChord<8> cluster;
+		PhiModulator phi;
+		DurationWave duration;
+		DoubleCombFilter comb;
+		BasicDoubleCombFilter<Int16Storage> comb16;
+
+		void setUp()
+		{
+			chord.setUp(sampleRate, 110.0f, 4, 0, 3);
+			chord.rampMajorBaseFrequency(150.0f, 3000);
+			cluster.setRandomSeed(99);
+			cluster.setUpCluster(sampleRate, 8, 1);
+			cluster.useOscillatorBank(true);
+			phi.setUpPhiModulator(sampleRate, 440.0f, 1, 110.0f, 1, 2.0f);
+			phi.rampTo(300.0f, 90.0f, 4.0f, 4000);
+			duration.setUpDuration(sampleRate, 0.5f, 0.1f, 0.3f);
+			duration.setFadeTime(0.01f);
+
+			comb.setSampleRate(sampleRate);
+			comb.setMaxDelay(1);
+			comb.setDelayTimes(0.013f, 0.0271f);
+			comb.setFeedback(0.6f, 0.3f);
+			comb.rampFeedback(0.2f, 0.7f, 5000);
+			comb16.setSampleRate(sampleRate);
+			comb16.setMaxDelay(1);
+			comb16.setDelayTimes(0.0213f, 0.0171f);
+			comb16.setFeedback(0.6f, 0.3f);
+		}
+
+		std::vector<float> render(int numSamples)
+		{
+			std::vector<float> dry(numSamples), out(numSamples);
+			chord.processBlock(dry.data(), numSamples);
+			cluster.processBlockAdd(dry.data(), numSamples);
+			phi.processBlockAdd(dry.data(), numSamples);
+			duration.applyBlock(dry.data(), numSamples);
+			comb.processBlock(dry.data(), out.data(), numSamples);
+			comb16.processBlockAdd(dry.data(), out.data(), numSamples);
+			return out;
+		}
+
+		void save(SnapshotWriter& writer)
+		{
+			writer.add(chord);
+			writer.add(cluster);
+			writer.add(phi);
+			writer.add(duration);
+			writer.add(comb);
+			writer.add(comb16);
+		}
+
+		bool restore(SnapshotReader& reader)
+		{
+			return reader.restore(chord) && reader.restore(cluster) && reader.restore(phi) && reader.restore(duration)
+				&& reader.restore(comb) && reader.restore(comb16);
+		}
+	};
+
+	template <class T>
+	std::vector<uint8_t> snapshotOf(const T& object)
+	{
+		SnapshotWriter writer;
+		writer.add(object);
+		return writer.getData();
+	}
+
+	//true if the snapshot restores into a fresh object, which must still render either way
+	template <class T>
+	bool restores(const std::vector<uint8_t>& data)
+	{
+		T object;
+		SnapshotReader reader;
+		const bool restored = reader.open(data.data(), data.size()) && reader.restore(object);
+		amtest::renderSamples(object, 64);
+		return restored;
+	}
+
+	//puts a value into the one byte where two otherwise equal snapshots differ (the low byte of an int or enum)
+	bool damageByte(std::vector<uint8_t>& data, const std::vector<uint8_t>& other, uint8_t value)
+	{
+		int numDifferent = 0;
+		size_t position = 0;
+		for (size_t i = 0; i < data.size() && i < other.size(); i++)
+		{
+			if (data[i] != other[i])
+			{
+				numDifferent++;
+				position = i;
+			}
+		}
+		data[position] = value;
+		return numDifferent == 1 && data.size() == other.size();
+	}
+
+	//replaces the one place a float is stored with another value
+	bool damageFloat(std::vector<uint8_t>& data, float from, float to)
+	{
+		int numFound = 0;
+		for (size_t i = 0; i + sizeof(float) <= data.size(); i++)
+		{
+			if (std::memcmp(&data[i], &from, sizeof(float)) == 0)
+			{
+				std::memcpy(&data[i], &to, sizeof(float));
+				numFound++;
+			}
+		}
+		return numFound == 1;
+	}
+}
+
+AM_TEST(durationBlocksMatchProcess)
+{
+	for (const auto& window : windows)
+	{
+		DurationWave duration = makeDuration(window);
+		DurationWave other = duration;
+		AM_CHECK(amtest::countDifferences(amtest::renderSamples(duration, 200000), amtest::renderBlocks(other, 200000)) == 0);
+	}
+}
+
+AM_TEST(durationSkipMatchesStepping)
+{
+	const int64_t skips[] = { 0, 1, 100, 4799, 24000, 48000, 48001, 100000, 1234567 };
+	const int64_t preRolls[] = { 0, 9600, 33333 };
+
+	for (const auto& window : windows)
+	{
+		for (int64_t preRoll : preRolls)
+		{
+			DurationWave duration = makeDuration(window);
+			amtest::stepSamples(duration, preRoll);
+
+			for (int64_t skip : skips)
+			{
+				AM_CHECK(amtest::skipMatchesStepping(duration, skip, 100000));
+			}
+		}
+	}
+}
+
+AM_TEST(durationSilenceAheadIsSilent)
+{
+	for (const auto& window : windows)
+	{
+		DurationWave duration = makeDuration(window);
+
+		//from every position in the first two pieces, the promised samples must all be 0
+		for (int position = 0; position < 200000; position += 997)
+		{
+			const int silent = int(std::min<int64_t>(duration.getSilentSamplesAhead(), 100000));
+			DurationWave ahead = duration;
+			const std::vector<float> samples = amtest::renderSamples(ahead, silent);
+			AM_CHECK(std::count(samples.begin(), samples.end(), 0.0f) == silent);
+			amtest::stepSamples(duration, 997);
+		}
+	}
+}
+
+AM_TEST(snapshotRestoreCarriesOn)
+{
+	static Session session, restored;
+	session.setUp();
+	session.render(12345);
+
+	SnapshotWriter writer;
+	session.save(writer);
+	const std::vector<float> expected = session.render(20000);
+
+	//set up differently, so everything has to come from the snapshot
+	restored.cluster.setUpCluster(44100.0f, 3, 0);
+	restored.comb.setSampleRate(44100.0f);
+	restored.comb.setMaxDelay(2);
+
+	SnapshotReader reader;
+	AM_CHECK(reader.open(writer.getData().data(), writer.getData().size()));
+	AM_CHECK(restored.restore(reader));
+	AM_CHECK(amtest::countDifferences(expected, restored.render(20000)) == 0);
+}
+
+AM_TEST(snapshotTruncationFails)
+{
+	static Session session, restored;
+	session.setUp();
+	restored.setUp();
+
+	SnapshotWriter writer;
+	session.save(writer);
+	const std::vector<uint8_t>& data = writer.getData();
+
+	for (size_t length = 0; length < data.size(); length += length < 400 ? 1 : 997)
+	{
+		SnapshotReader reader;
+		AM_CHECK(!(reader.open(data.data(), length) && restored.restore(reader)));
+		restored.render(64);											//whatever was restored must still render
+	}
+}
+
+AM_TEST(snapshotWrongClassFails)
+{
+	DoubleCombFilter comb;
+	comb.setSampleRate(sampleRate);
+	comb.setMaxDelay(1);
+
+	SnapshotWriter writer;
+	writer.add(comb);
+
+	BasicDoubleCombFilter<Float16Storage> wrongStorage;
+	SnapshotReader reader;
+	AM_CHECK(!(reader.open(writer.getData().data(), writer.getData().size()) && reader.restore(wrongStorage)));
+
+	Chord chord;
+	chord.setUp(sampleRate, 110.0f, 1, 0, 3);
+	SnapshotWriter chordWriter;
+	chordWriter.add(chord);
+
+	FixedChord<1> tooSmall;
+	SnapshotReader chordReader;
+	AM_CHECK(!(chordReader.open(chordWriter.getData().data(), chordWriter.getData().size()) && chordReader.restore(tooSmall)));
+}
+
+AM_TEST(snapshotOutOfRangeValuesFail)
+{
+	Oscillator oscillator;
+	oscillator.setUp(sampleRate, 440.0f, 3);
+	AM_CHECK(restores<Oscillator>(snapshotOf(oscillator)));
+
+	Oscillator otherWave = oscillator, otherSine = oscillator, otherPhase = oscillator;
+	otherWave.setWaveIndex(4);
+	otherSine.setSineMode(oscillator.getSineMode() == SineMode::table ? SineMode::exact : SineMode::table);
+	otherPhase.setPhaseMode(PhaseMode::fixedPoint);
+
+	std::vector<uint8_t> data = snapshotOf(oscillator);
+	AM_CHECK(damageByte(data, snapshotOf(otherWave), 5));
+	AM_CHECK(!restores<Oscillator>(data));
+
+	data = snapshotOf(oscillator);
+	AM_CHECK(damageByte(data, snapshotOf(otherSine), 3));
+	AM_CHECK(!restores<Oscillator>(data));
+
+	data = snapshotOf(oscillator);
+	AM_CHECK(damageByte(data, snapshotOf(otherPhase), 2));
+	AM_CHECK(!restores<Oscillator>(data));
+
+	//the duration wave divides by both of these when its window is set again
+	DurationWave duration;
+	duration.setUpDuration(47111.0f, 1.2345f, 0.2f, 0.7f);
+	AM_CHECK(restores<DurationWave>(snapshotOf(duration)));
+
+	data = snapshotOf(duration);
+	AM_CHECK(damageFloat(data, 1.2345f, 0.0f));
+	AM_CHECK(!restores<DurationWave>(data));
+
+	data = snapshotOf(duration);
+	AM_CHECK(damageFloat(data, 47111.0f, -1.0f));
+	AM_CHECK(!restores<DurationWave>(data));
+}
+
+AM_TEST(parameterExchangeMatchesSetters)
+{
+	DoubleCombFilter comb, other;
+	for (auto* c : { &comb, &other })
+	{
+		c->setSampleRate(sampleRate);
+		c->setMaxDelay(1);
+	}
+
+	ParameterExchange<DoubleCombFilter::Parameters> exchange(comb.getParameters());
+	AM_CHECK(!exchange.applyTo(comb));
+
+	//only the newest of several writes gets through, and only once
+	DoubleCombFilter::Parameters parameters { 0.02f, 0.03f, 0.4f, 0.4f };
+	exchange.write(parameters);
+	parameters = { 0.0173f, 0.0291f, 0.7f, 0.2f };
+	exchange.write(parameters);
+	AM_CHECK(exchange.applyTo(comb));
+	AM_CHECK(!exchange.applyTo(comb));
+	AM_CHECK(exchange.latest().delayTimeOne == 0.0173f && exchange.latest().feedbackTwo == 0.2f);
+
+	other.setDelayTimes(0.0173f, 0.0291f);
+	other.setFeedback(0.7f, 0.2f);
+
+	const std::vector<float> input = amtest::makeNoise(20000);
+	AM_CHECK(amtest::countDifferences(amtest::filterBlocks(comb, input), amtest::filterBlocks(other, input)) == 0);
+}
+
+AM_TEST(parameterExchangeNeverTears)
+{
+	//every field of a set holds the same number, so a set made of two writes shows up as a mismatch
+	struct Set
+	{
+		uint32_t values[32];
+	};
+
+	constexpr uint32_t numWrites = 200000;
+	ParameterExchange<Set> exchange;
+
+	std::thread writer([&]
+	{
+		for (uint32_t n = 1; n <= numWrites; n++)
+		{
+			Set set;
+			std::fill(std::begin(set.values), std::end(set.values), n);
+			exchange.write(set);
+		}
+	});
+
+	uint32_t last = 0;
+	int torn = 0, backwards = 0;
+	while (last < numWrites)
+	{
+		if (exchange.update())
+		{
+			const Set& set = exchange.latest();
+			torn += std::count(std::begin(set.values), std::end(set.values), set.values[0]) != 32 ? 1 : 0;
+			backwards += set.values[0] <= last ? 1 : 0;
+			last = set.values[0];
+		}
+	}
+	writer.join();
+
+	AM_CHECK(torn == 0);
+	AM_CHECK(backwards == 0);
+}
+
+AM_TEST_MAIN()
@@ -0,0 +1,581 @@
+/*
+  ==============================================================================
+
+	am_RenderPatch.h
+	Created: 17 Oct 2026 7:40:18pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "am_Chords.h"
+#include "am_DoubleCombFilter.h"
+#include "am_DurationOnOffWave.h"
+#include "am_Oversampler.h"
+#include "am_Phase_Modulator.h"
+#include "am_WavWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+*Everything needed to render one patch offline: a source (oscillator, chord, cluster or phi modulator), optionally
+*switched on and off by a DurationWave window, optionally through a DoubleCombFilter, then a gain.
+*
+*Patches are read from text files of key = value lines. # starts a comment. Every key is optional:
+*
+*   output = pad.wav            file to write, relative to the current directory (default: the patch file with .wav)
+*   sampleRate = 48000          Hz
+*   seconds = 60                length of the render
+*   blockSize = 8192            samples rendered per call
+*   gain = 1
+*
+*   source = cluster            oscillator, chord, cluster or phimod
+*   wave = 1                    0 = Phasor, 1 = Sin, 2 = Square, 3 = Triangle, 4 = Sawtooth
+*   frequency = 220             Hz: oscillator frequency, chord base frequency or phimod carrier
+*   phaseWidth = 0.5            square wave only
+*   sineMode = exact            exact, polynomial or table
+*   bandLimited = 0             1 for PolyBLEP square, triangle and sawtooth
+*   chordType = major           major or minor
+*   octaves = 1                 chord only
+*   chords = 8                  cluster only
+*   seed = 1                    cluster only: the same seed gives the same cluster
+*   oscillatorBank = 0          chord and cluster: 1 to render with the SIMD OscillatorBank
+*   modulatorFrequency = 110    phimod only, Hz
+*   modulationIndex = 1         phimod only
+*   oversampling = 1            phimod only: 2, 4 or 8 to render it oversampled, so bright patches do not alias
+*   oversamplingPhase = linear  linear or minimum (lower latency) phase oversampling filters
+*
+*   durationLength = 0          seconds; above 0 turns the DurationWave window on
+*   durationStart = 0           seconds into each durationLength the sound starts
+*   durationEnd = 0             seconds into each durationLength the sound stops
+*   durationFade = 0.5          seconds of fade in and fade out at the edges of the window
+*
+*   comb = 0                    1 to run the output through a DoubleCombFilter
+*   combDelayOne = 0.01         seconds
+*   combDelayTwo = 0.015        seconds
+*   combFeedbackOne = 0.5       [0, 1]
+*   combFeedbackTwo = 0.5       [0, 1]
+*/
+struct PatchConfig
+{
+	std::string output;
+	float sampleRate = 48000.0f;
+	double seconds = 10.0;
+	int blockSize = 8192;
+	float gain = 1.0f;
+
+	std::string source = "oscillator";
+	int wave = 1;
+	float frequency = 220.0f;
+	float phaseWidth = 0.5f;
+	SineMode sineMode = SineMode::exact;
+	bool bandLimited = false;
+	int chordType = 0;
+	int octaves = 1;
+	int chords = 8;
+	uint64_t seed = 1;
+	bool oscillatorBank = false;
+	float modulatorFrequency = 110.0f;
+	float modulationIndex = 1.0f;
+	int oversampling = 1;
+	OversamplingPhase oversamplingPhase = OversamplingPhase::linear;
+
+	float durationLength = 0.0f;
+	float durationStart = 0.0f;
+	float durationEnd = 0.0f;
+	float durationFade = 0.5f;
+
+	bool comb = false;
+	float combDelayOne = 0.01f;
+	float combDelayTwo = 0.015f;
+	float combFeedbackOne = 0.5f;
+	float combFeedbackTwo = 0.5f;
+
+	//total number of samples to render
+	int64_t getNumSamples() const
+	{
+		return int64_t(seconds * sampleRate + 0.5);
+	}
+
+	/**
+	*reads a patch file
+	*@param path of the patch file
+	*@param set to a description of the problem if reading fails
+	*@return false if the file could not be read or has an unknown key or bad value
+	*/
+	bool load(const std::string& path, std::string& error)
+	{
+		std::ifstream in(path);
+		if (!in)
+		{
+			error = "cannot open " + path;
+			return false;
+		}
+
+		output = path.substr(0, path.find_last_of('.')) + ".wav";
+
+		std::string line;
+		for (int lineNumber = 1; std::getline(in, line); lineNumber++)
+		{
+			line = trim(line.substr(0, line.find('#')));
+			if (line.empty())
+			{
+				continue;
+			}
+
+			const size_t equals = line.find('=');
+			if (equals == std::string::npos)
+			{
+				error = path + ":" + std::to_string(lineNumber) + ": expected key = value";
+				return false;
+			}
+
+			const std::string key = trim(line.substr(0, equals));
+			const std::string value = trim(line.substr(equals + 1));
+
+			if (!set(key, value))
+			{
+				error = path + ":" + std::to_string(lineNumber) + ": bad setting '" + line + "'";
+				return false;
+			}
+		}
+
+		if (source != "oscillator" && source != "chord" && source != "cluster" && source != "phimod")
+		{
+			error = path + ": unknown source '" + source + "'";
+			return false;
+		}
+
+		if (sampleRate <= 0.0f || seconds < 0.0 || blockSize <= 0)
+		{
+			error = path + ": sampleRate and blockSize must be above 0 and seconds at least 0";
+			return false;
+		}
+
+		if (octaves < 1 || chords < 1)
+		{
+			error = path + ": octaves and chords must be at least 1";
+			return false;
+		}
+
+		if (oversampling != 1 && oversampling != 2 && oversampling != 4 && oversampling != 8)
+		{
+			error = path + ": oversampling must be 1, 2, 4 or 8";
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+
+	static std::string trim(const std::string& text)
+	{
+		const size_t first = text.find_first_not_of(" \t\r");
+		if (first == std::string::npos)
+		{
+			return "";
+		}
+		return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+	}
+
+	static bool toNumber(const std::string& text, double& result)
+	{
+		char* end = nullptr;
+		result = std::strtod(text.c_str(), &end);
+		return !text.empty() && end == text.c_str() + text.size();
+	}
+
+	template <class T>
+	static bool toNumber(const std::string& text, T& result)
+	{
+		double value = 0.0;
+		if (!toNumber(text, value))
+		{
+			return false;
+		}
+		result = T(value);
+		return true;
+	}
+
+	//stores one setting, false if the key is unknown or the value does not fit it
+	bool set(const std::string& key, const std::string& value)
+	{
+		if (key == "output")				{ output = value; return !value.empty(); }
+		if (key == "source")				{ source = value; return true; }
+		if (key == "sampleRate")			return toNumber(value, sampleRate);
+		if (key == "seconds")				return toNumber(value, seconds);
+		if (key == "blockSize")				return toNumber(value, blockSize);
+		if (key == "gain")					return toNumber(value, gain);
+		if (key == "wave")					return toNumber(value, wave);
+		if (key == "frequency")				return toNumber(value, frequency);
+		if (key == "phaseWidth")			return toNumber(value, phaseWidth);
+		if (key == "bandLimited")			return toNumber(value, bandLimited);
+		if (key == "octaves")				return toNumber(value, octaves);
+		if (key == "chords")				return toNumber(value, chords);
+		if (key == "seed")					return toNumber(value, seed);
+		if (key == "oscillatorBank")		return toNumber(value, oscillatorBank);
+		if (key == "modulatorFrequency")	return toNumber(value, modulatorFrequency);
+		if (key == "modulationIndex")		return toNumber(value, modulationIndex);
+		if (key == "oversampling")			return toNumber(value, oversampling);
+		if (key == "durationLength")		return toNumber(value, durationLength);
+		if (key == "durationStart")			return toNumber(value, durationStart);
+		if (key == "durationEnd")			return toNumber(value, durationEnd);
+		if (key == "durationFade")			return toNumber(value, durationFade);
+		if (key == "comb")					return toNumber(value, comb);
+		if (key == "combDelayOne")			return toNumber(value, combDelayOne);
+		if (key == "combDelayTwo")			return toNumber(value, combDelayTwo);
+		if (key == "combFeedbackOne")		return toNumber(value, combFeedbackOne);
+		if (key == "combFeedbackTwo")		return toNumber(value, combFeedbackTwo);
+
+		if (key == "chordType")
+		{
+			if (value == "major" || value == "0")		{ chordType = 0; return true; }
+			if (value == "minor" || value == "1")		{ chordType = 1; return true; }
+			return false;
+		}
+
+		if (key == "oversamplingPhase")
+		{
+			if (value == "linear")			{ oversamplingPhase = OversamplingPhase::linear; return true; }
+			if (value == "minimum")			{ oversamplingPhase = OversamplingPhase::minimum; return true; }
+			return false;
+		}
+
+		if (key == "sineMode")
+		{
+			if (value == "exact")			{ sineMode = SineMode::exact; return true; }
+			if (value == "polynomial")		{ sineMode = SineMode::polynomial; return true; }
+			if (value == "table")			{ sineMode = SineMode::table; return true; }
+			return false;
+		}
+
+		return false;
+	}
+};
+
+/**
+*The classes a patch is built from, set up from a PatchConfig. Only the ones the patch uses are created.
+*/
+class RenderPatch
+{
+public:
+
+	explicit RenderPatch(const PatchConfig& configIn)
+		: config(configIn)
+	{
+		const float rate = config.sampleRate;
+
+		if (config.source == "oscillator")
+		{
+			oscillator = std::make_unique<Oscillator>();
+			oscillator->setUp(rate, config.frequency, config.wave);
+			oscillator->setPhaseWidth(config.phaseWidth);
+			oscillator->setSineMode(config.sineMode);
+			oscillator->setBandLimited(config.bandLimited);
+		}
+		else if (config.source == "chord")
+		{
+			chord = std::make_unique<Chord>();
+			chord->setUp(rate, config.frequency, config.wave, config.chordType, config.octaves);
+			chord->setSineMode(config.sineMode);
+			chord->setBandLimited(config.bandLimited);
+			chord->useOscillatorBank(config.oscillatorBank);
+		}
+		else if (config.source == "cluster")
+		{
+			cluster = std::make_unique<clusterChord>();
+			cluster->setRandomSeed(config.seed);
+			cluster->setUpCluster(rate, config.chords, config.wave);
+			cluster->setSineMode(config.sineMode);
+			cluster->setBandLimited(config.bandLimited);
+			cluster->useOscillatorBank(config.oscillatorBank);
+		}
+		else
+		{
+			phiModulator = std::make_unique<Oversampled<PhiModulator>>();
+			phiModulator->setOversampling(rate, config.oversampling, config.oversamplingPhase);
+			phiModulator->get().setUpPhiModulator(phiModulator->getOversampledRate(), config.frequency, config.wave, config.modulatorFrequency, 1, config.modulationIndex);
+		}
+
+		if (config.durationLength > 0.0f)
+		{
+			duration = std::make_unique<DurationWave>();
+			duration->setUpDuration(rate, config.durationLength, config.durationStart, config.durationEnd);
+			duration->setFadeTime(config.durationFade);
+		}
+
+		if (config.comb)
+		{
+			comb = std::make_unique<DoubleCombFilter>();
+			comb->setSampleRate(rate);
+			comb->setMaxDelay(int(std::max(config.combDelayOne, config.combDelayTwo)) + 1);
+			comb->setDelayTimes(config.combDelayOne, config.combDelayTwo);
+			comb->setFeedback(config.combFeedbackOne, config.combFeedbackTwo);
+		}
+	}
+
+	/**
+	*renders the next numSamples of the patch. While the DurationWave window is silent the source is not rendered at
+	*all (it pauses and carries on where it was when the window opens again); the comb filter still rings out.
+	*/
+	void processBlock(float* out, int numSamples)
+	{
+		int silent = 0;
+		if (duration)
+		{
+			silent = int(std::min<int64_t>(duration->getSilentSamplesAhead(), numSamples));
+			std::fill(out, out + silent, 0.0f);
+			duration->skipSamples(silent);
+		}
+
+		renderSource(out + silent, numSamples - silent);
+
+		if (duration)
+		{
+			duration->applyBlock(out + silent, numSamples - silent);
+		}
+
+		if (comb)
+		{
+			comb->processBlock(out, numSamples);
+		}
+
+		if (config.gain != 1.0f)
+		{
+			for (int i = 0; i < numSamples; i++)
+			{
+				out[i] *= config.gain;
+			}
+		}
+	}
+
+	/**
+	*moves on numBlocks blocks of config.blockSize without rendering them, leaving the patch as if processBlock(out,
+	*blockSize) had been called numBlocks times, so a long piece can be cut into segments that render at once.
+	*
+	*The source and the window skip straight there (see their skipSamples()), the source only by the samples it would
+	*have rendered, as it pauses while the window is silent. The comb filter is the only part that remembers its input,
+	*so it is cleared and the blocks from its tail before the last sound up to the new position are rendered again.
+	*That matches exactly unless the window opens for less than the comb's tail, when only what is left below the comb's
+	*silence threshold (-120dB) can differ.
+	*@param number of blocks to skip
+	*/
+	void skipBlocks(int64_t numBlocks)
+	{
+		if (numBlocks <= 0)
+		{
+			return;
+		}
+
+		int64_t lastAudible = -1;
+		countSourceSamples(numBlocks, lastAudible);
+
+		int64_t renderFrom = numBlocks;											//first block rendered again
+		if (comb)
+		{
+			const int64_t tailBlocks = (comb->getTailSamples() + config.blockSize - 1) / config.blockSize;
+			renderFrom = lastAudible >= 0 ? std::max<int64_t>(lastAudible - tailBlocks, 0) : 0;
+		}
+
+		int64_t unused = 0;
+		skipSource(countSourceSamples(renderFrom, unused));
+
+		if (duration)
+		{
+			duration->skipSamples(renderFrom * config.blockSize);
+		}
+
+		if (comb && renderFrom > 0)
+		{
+			comb->reset();
+		}
+
+		std::vector<float> discard(config.blockSize);
+		for (int64_t block = renderFrom; block < numBlocks; block++)
+		{
+			processBlock(discard.data(), config.blockSize);
+		}
+	}
+
+private:
+
+	/**
+	*walks a copy of the window over the next numBlocks blocks, the same way processBlock() checks it
+	*@param number of blocks
+	*@param set to the last of them the source renders in, -1 if it renders in none
+	*@return how many samples the source renders in them
+	*/
+	int64_t countSourceSamples(int64_t numBlocks, int64_t& lastAudible) const
+	{
+		const int64_t blockSize = config.blockSize;
+
+		if (!duration)
+		{
+			lastAudible = numBlocks - 1;
+			return numBlocks * blockSize;
+		}
+
+		DurationWave window = *duration;
+		int64_t total = 0;
+		lastAudible = -1;
+
+		for (int64_t block = 0; block < numBlocks;)
+		{
+			const int64_t silent = window.getSilentSamplesAhead();
+
+			if (silent >= blockSize)											//whole blocks of silence in one go
+			{
+				const int64_t silentBlocks = std::min(silent / blockSize, numBlocks - block);
+				window.skipSamples(silentBlocks * blockSize);
+				block += silentBlocks;
+			}
+			else
+			{
+				total += blockSize - silent;
+				lastAudible = block;
+				window.skipSamples(blockSize);
+				block++;
+			}
+		}
+		return total;
+	}
+
+	void skipSource(int64_t numSamples)
+	{
+		if (oscillator)
+		{
+			oscillator->skipSamples(numSamples);
+		}
+		else if (chord)
+		{
+			chord->skipSamples(numSamples);
+		}
+		else if (cluster)
+		{
+			cluster->skipSamples(numSamples);
+		}
+		else
+		{
+			phiModulator->skipSamples(numSamples);
+		}
+	}
+
+	void renderSource(float* out, int numSamples)
+	{
+		if (numSamples <= 0)
+		{
+			return;
+		}
+
+		if (oscillator)
+		{
+			oscillator->processBlock(out, numSamples);
+		}
+		else if (chord)
+		{
+			chord->processBlock(out, numSamples);
+		}
+		else if (cluster)
+		{
+			cluster->processBlock(out, numSamples);
+		}
+		else
+		{
+			phiModulator->processBlock(out, numSamples);
+		}
+	}
+
+	PatchConfig config;
+
+	std::unique_ptr<Oscillator> oscillator;
+	std::unique_ptr<Chord> chord;
+	std::unique_ptr<clusterChord> cluster;
+	std::unique_ptr<Oversampled<PhiModulator>> phiModulator;
+	std::unique_ptr<DurationWave> duration;
+	std::unique_ptr<DoubleCombFilter> comb;
+};
+
+/**
+*renders a patch cut into numSegments segments of whole blocks, numThreads at once. Each segment has its own
+*RenderPatch that skips to the segment's start (RenderPatch::skipBlocks()), and writes straight into its part of
+*the file: the first through writer, the others through their own WavWriter::openPart(). The file is the same as
+*rendering the patch from the start on one thread.
+*@param patch to render
+*@param writer that has open()ed config.output, left open for the caller to close()
+*@param threads to render the segments on
+*@param segments to cut the patch into
+*@return false if a part of the file could not be written
+*/
+inline bool renderPatchSegments(const PatchConfig& config, WavWriter& writer, int numThreads, int numSegments)
+{
+	const int64_t total = config.getNumSamples();
+	const int64_t totalBlocks = (total + config.blockSize - 1) / config.blockSize;
+	const int64_t segmentBlocks = std::max<int64_t>((totalBlocks + numSegments - 1) / numSegments, 1);
+
+	std::atomic<int> nextSegment { 0 };
+	std::atomic<bool> ok { true };
+
+	auto renderSegment = [&](int segment)
+	{
+		const int64_t first = segment * segmentBlocks * config.blockSize;
+		const int64_t last = std::min(first + segmentBlocks * config.blockSize, total);
+
+		WavWriter partWriter(std::max(config.blockSize, 1 << 16));
+		WavWriter& out = segment == 0 ? writer : partWriter;
+
+		if (segment > 0 && !partWriter.openPart(config.output, uint64_t(first)))
+		{
+			ok = false;
+			return;
+		}
+
+		RenderPatch patch(config);
+		patch.skipBlocks(segment * segmentBlocks);
+
+		std::vector<float> block(config.blockSize);
+		for (int64_t done = first; done < last; done += config.blockSize)
+		{
+			const int numSamples = int(std::min<int64_t>(config.blockSize, last - done));
+			patch.processBlock(block.data(), numSamples);
+			out.write(block.data(), numSamples);
+		}
+
+		if (segment > 0 && !partWriter.close())
+		{
+			ok = false;
+		}
+	};
+
+	auto renderSegments = [&]
+	{
+		for (int segment = nextSegment++; segment < numSegments && int64_t(segment) * segmentBlocks < totalBlocks; segment = nextSegment++)
+		{
+			renderSegment(segment);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < std::min(numThreads, numSegments); i++)
+	{
+		threads.emplace_back(renderSegments);
+	}
+	renderSegments();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	writer.setTotalSamples(uint64_t(total));
+	return ok.load();
+}
@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+	am_render.cpp
+	Created: 17 Oct 2026 8:02:51pm
+	Author:  Andrew McGillivray
+
+  ==============================================================================
+*/
+
+/**
+*Offline renderer: renders patch files (see am_RenderPatch.h) to 32 bit float WAV files as fast as the CPU allows.
+*
+*Usage: am_render [-j threads] [-s segments] patch.txt [patch.txt ...]
+*
+*Several patches are rendered in parallel, one per thread (by default one thread per core). Each patch renders in
+*large blocks and streams to disk through a WavWriter, so long pieces never need to fit in memory.
+*
+*With -s, patches render one after another instead, each cut into that many segments that render on the threads at
+*once. Each segment skips straight to its start (RenderPatch::skipBlocks()) and writes its own part of the file, and
+*the file is the same as a render without -s, so an hour-long piece with one patch can use every core.
+*
+*Built with AM_ENABLE_PROFILING, it also prints how long each module took and how close every block came to its
+*real-time deadline (am_Profiler).
+*/
+
+#include "am_Profiler.h"
+#include "am_RenderPatch.h"
+#include "am_WavWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	std::mutex printMutex;
+
+	//cycles per module as a share of the blocks' cycles, then the xrun statistics
+	void printProfile(const XrunStats& stats, const uint64_t* moduleCycles)
+	{
+		const uint64_t blockCycles = moduleCycles[int(ProfiledModule::block)];
+
+		for (int module = 1; module < int(ProfiledModule::numModules); module++)
+		{
+			if (moduleCycles[module] > 0)
+			{
+				std::printf("    %-20s %12llu cycles  %5.1f%%\n", getModuleName(ProfiledModule(module)),
+							(unsigned long long)moduleCycles[module], blockCycles > 0 ? 100.0 * double(moduleCycles[module]) / double(blockCycles) : 0.0);
+			}
+		}
+
+		std::printf("    %llu blocks, %llu xruns, load %.2f%% average, %.2f%% worst, %llu timings dropped\n",
+					(unsigned long long)stats.blocks, (unsigned long long)stats.xruns, 100.0 * stats.averageLoad,
+					100.0 * stats.worstLoad, (unsigned long long)stats.droppedEvents);
+	}
+
+	/**
+	*renders one patch file to its WAV file
+	*@param path of the patch file
+	*@param segments to cut the patch into and render on several threads at once, 1 to render it on this thread
+	*@param threads to render the segments on
+	*@return false if the patch could not be read or the file could not be written
+	*/
+	bool renderPatchFile(const std::string& path, int numSegments, int numThreads)
+	{
+		PatchConfig config;
+		std::string error;
+
+		if (!config.load(path, error))
+		{
+			std::lock_guard<std::mutex> lock(printMutex);
+			std::fprintf(stderr, "error: %s\n", error.c_str());
+			return false;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		WavWriter writer(std::max(config.blockSize, 1 << 16));
+
+		if (!writer.open(config.output, int(config.sampleRate + 0.5f), 1))
+		{
+			std::lock_guard<std::mutex> lock(printMutex);
+			std::fprintf(stderr, "error: cannot create %s\n", config.output.c_str());
+			return false;
+		}
+
+		const int64_t total = config.getNumSamples();
+
+		DspProfiler profiler;
+		profiler.setSampleRate(config.sampleRate);
+		uint64_t moduleCycles[int(ProfiledModule::numModules)] = {};
+
+		bool segmentsOk = true;
+
+		if (numSegments > 1)
+		{
+			segmentsOk = renderPatchSegments(config, writer, numThreads, numSegments);
+		}
+		else
+		{
+			RenderPatch patch(config);
+			std::vector<float> block(config.blockSize);
+
+			for (int64_t done = 0; done < total; done += config.blockSize)
+			{
+				const int numSamples = int(std::min<int64_t>(config.blockSize, total - done));
+				{
+					AM_PROFILE_BLOCK(profiler, numSamples);
+					patch.processBlock(block.data(), numSamples);
+				}
+				writer.write(block.data(), numSamples);
+
+				ProfileEvent event;
+				while (profiler.pop(event))
+				{
+					moduleCycles[int(event.module)] += event.cycles;
+				}
+			}
+		}
+
+		const bool ok = writer.close() && segmentsOk;
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::lock_guard<std::mutex> lock(printMutex);
+		if (!ok)
+		{
+			std::fprintf(stderr, "error: failed writing %s\n", config.output.c_str());
+			return false;
+		}
+
+		std::printf("%s -> %s: %.1f s of audio in %.2f s (%.0fx real time)\n", path.c_str(), config.output.c_str(),
+					config.seconds, seconds, seconds > 0.0 ? config.seconds / seconds : 0.0);
+
+		if (AM_ENABLE_PROFILING && numSegments <= 1)
+		{
+			printProfile(profiler.getXrunStats(), moduleCycles);
+		}
+		return true;
+	}
+
+	void printUsage()
+	{
+		std::fprintf(stderr, "usage: am_render [-j threads] [-s segments] patch.txt [patch.txt ...]\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int numThreads = int(std::thread::hardware_concurrency());
+	int numSegments = 1;
+	std::vector<std::string> patches;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "-j" && i + 1 < argc)
+		{
+			numThreads = std::atoi(argv[++i]);
+		}
+		else if (arg == "-s" && i + 1 < argc)
+		{
+			numSegments = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "-h" || arg == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		else
+		{
+			patches.push_back(arg);
+		}
+	}
+
+	if (patches.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	numThreads = std::max(numThreads, 1);
+	std::atomic<int> failures { 0 };
+
+	if (numSegments > 1)
+	{
+		for (const auto& patch : patches)
+		{
+			if (!renderPatchFile(patch, numSegments, numThreads))
+			{
+				failures++;
+			}
+		}
+		return failures.load() == 0 ? 0 : 1;
+	}
+
+	numThreads = std::min(numThreads, int(patches.size()));
+	std::atomic<int> nextPatch { 0 };
+
+	auto renderPatches = [&]
+	{
+		for (int index = nextPatch++; index < int(patches.size()); index = nextPatch++)
+		{
+			if (!renderPatchFile(patches[index], 1, 1))
+			{
+				failures++;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++)
+	{
+		threads.emplace_back(renderPatches);
+	}
+	renderPatches();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	return failures.load() == 0 ? 0 : 1;
+}